@@ -1,7 +1,24 @@
 // C program to store temperature of two cities of a week and display it.
 #include <stdio.h>
+#include "fastout.h"
 const int CITY = 2;
 const int WEEK = 7;
+// Longest row: "City " + index + ", Day " + index + " = " + value + '\n'
+const size_t ROW_CHARS = 5 + FO_MAX_INT_CHARS + 6 + FO_MAX_INT_CHARS + 3 + FO_MAX_INT_CHARS + 1;
+// "City %d, Day %d = %d\n" for element idx of the flattened array
+static char *format_reading(char *p, size_t idx, int v, void *ctx)
+{
+  (void)ctx;
+  p = fo_fmt_str(p, "City ", 5);
+  p = fo_fmt_u32(p, (uint32_t)(idx / WEEK) + 1);
+  p = fo_fmt_str(p, ", Day ", 6);
+  p = fo_fmt_u32(p, (uint32_t)(idx % WEEK) + 1);
+  p = fo_fmt_str(p, " = ", 3);
+  p = fo_fmt_i32(p, v);
+  *p++ = '\n';
+  return p;
+}
+
 int main()
 {
   int temperature[CITY][WEEK];
@@ -16,14 +33,13 @@ int main()
     }
   }
   printf("\nDisplaying values: \n\n");
+  fflush(stdout);
 
-  // Using nested loop to display vlues of a 2d array
-  for (int i = 0; i < CITY; ++i)
+  // Format all readings in parallel chunks and write them out in order
+  if (fo_write_ints_parallel(1, &temperature[0][0], (size_t)CITY * WEEK,
+                             format_reading, NULL, ROW_CHARS, 4) != 0)
   {
-    for (int j = 0; j < WEEK; ++j)
-    {
-      printf("City %d, Day %d = %d\n", i + 1, j + 1, temperature[i][j]);
-    }
+    return 1;
   }
   return 0;
 }
@@ -0,0 +1,233 @@
+/*
+ arena.h
+ Per-worker bump arenas and object pools for planner scratch memory
+
+ Overview:
+  - Arena: allocations bump a pointer inside large chunks. arena_reset()
+    rewinds to the first chunk but keeps every chunk, so once a worker has
+    seen its largest mission, later missions never call malloc.
+    arena_mark()/arena_release() rewind to a saved point for nested scopes.
+  - ObjPool: fixed-size objects (tree nodes, records) recycled through a
+    free list, carved from slabs that are kept for the pool's lifetime.
+  - Both count calls to the system allocator (sys_allocs) and requests
+    served (allocs) so benchmarks can check the steady state is malloc-free.
+  - Not thread-safe by design: give each worker its own arena and pools.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+
+#define ARENA_ALIGN 16
+#define ARENA_DEFAULT_CHUNK (256 * 1024)
+#define POOL_SLAB_OBJECTS 256
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t size;            /* usable bytes in data[] */
+    size_t used;
+    char* data;
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk* first;
+    ArenaChunk* cur;
+    size_t chunk_size;
+    size_t sys_allocs;      /* chunks obtained from malloc */
+    size_t allocs;          /* allocations served */
+    size_t bytes;           /* bytes handed out since the last reset */
+    size_t peak;            /* largest bytes seen at a reset */
+} Arena;
+
+typedef struct {
+    ArenaChunk* chunk;
+    size_t used;
+    size_t bytes;
+} ArenaMark;
+
+static inline void arena_init(Arena* a, size_t chunk_size) {
+    memset(a, 0, sizeof(*a));
+    a->chunk_size = chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK;
+}
+
+static inline ArenaChunk* arena_new_chunk(Arena* a, size_t need) {
+    size_t size = need > a->chunk_size ? need : a->chunk_size;
+    ArenaChunk* c = (ArenaChunk*)malloc(sizeof(ArenaChunk) + size + ARENA_ALIGN);
+    if(!c) return NULL;
+    a->sys_allocs++;
+    c->next = NULL;
+    c->size = size;
+    c->used = 0;
+    c->data = (char*)(((size_t)(c + 1) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1));
+    return c;
+}
+
+/* Aligned allocation of size bytes, NULL when out of memory */
+static inline void* arena_alloc(Arena* a, size_t size) {
+    if(size > (size_t)-1 / 2) return NULL;     /* would wrap in the rounding or chunk header */
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ArenaChunk* c = a->cur;
+    if(!c || c->used + size > c->size) {
+        /* Chunks after cur are empty: take the first one big enough, or
+           append a new chunk at the end of the list */
+        ArenaChunk* prev = c;
+        c = c ? c->next : a->first;
+        while(c && size > c->size) {
+            prev = c;
+            c = c->next;
+        }
+        if(!c) {
+            c = arena_new_chunk(a, size);
+            if(!c) return NULL;
+            if(prev) prev->next = c; else a->first = c;
+        }
+        a->cur = c;
+    }
+    void* p = c->data + c->used;
+    c->used += size;
+    a->allocs++;
+    a->bytes += size;
+    return p;
+}
+
+/* NULL if count * size overflows */
+static inline void* arena_calloc(Arena* a, size_t count, size_t size) {
+    if(size && count > (size_t)-1 / size) return NULL;
+    void* p = arena_alloc(a, count * size);
+    if(p) memset(p, 0, count * size);
+    return p;
+}
+
+static inline char* arena_strdup(Arena* a, const char* s) {
+    size_t n = strlen(s) + 1;
+    char* p = (char*)arena_alloc(a, n);
+    if(p) memcpy(p, s, n);
+    return p;
+}
+
+/* printf into arena memory */
+static inline char* arena_printf(Arena* a, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if(n < 0) return NULL;
+    char* p = (char*)arena_alloc(a, (size_t)n + 1);
+    if(!p) return NULL;
+    va_start(ap, fmt);
+    vsnprintf(p, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    return p;
+}
+
+static inline ArenaMark arena_mark(const Arena* a) {
+    ArenaMark m;
+    m.chunk = a->cur;
+    m.used = a->cur ? a->cur->used : 0;
+    m.bytes = a->bytes;
+    return m;
+}
+
+/* Free everything allocated after the mark */
+static inline void arena_release(Arena* a, ArenaMark m) {
+    if(!m.chunk) {
+        for(ArenaChunk* c = a->first; c; c = c->next) c->used = 0;
+        a->cur = a->first;
+    } else {
+        for(ArenaChunk* c = m.chunk->next; c; c = c->next) c->used = 0;
+        m.chunk->used = m.used;
+        a->cur = m.chunk;
+    }
+    a->bytes = m.bytes;
+}
+
+/* Mission-scoped reset: free everything, keep the chunks */
+static inline void arena_reset(Arena* a) {
+    if(a->bytes > a->peak) a->peak = a->bytes;
+    for(ArenaChunk* c = a->first; c; c = c->next) c->used = 0;
+    a->cur = a->first;
+    a->bytes = 0;
+}
+
+static inline void arena_free(Arena* a) {
+    ArenaChunk* c = a->first;
+    while(c) {
+        ArenaChunk* next = c->next;
+        free(c);
+        c = next;
+    }
+    a->first = a->cur = NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Object pool                                                             */
+/* ---------------------------------------------------------------------- */
+
+typedef struct PoolSlab {
+    struct PoolSlab* next;
+} PoolSlab;
+
+typedef struct {
+    size_t elem_size;
+    void* free_list;
+    PoolSlab* slabs;
+    size_t sys_allocs;
+    size_t allocs;
+    size_t live;
+} ObjPool;
+
+static inline void pool_init(ObjPool* p, size_t elem_size) {
+    memset(p, 0, sizeof(*p));
+    if(elem_size < sizeof(void*)) elem_size = sizeof(void*);
+    p->elem_size = (elem_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static inline void* pool_get(ObjPool* p) {
+    if(!p->free_list) {
+        size_t head = (sizeof(PoolSlab) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+        char* slab = (char*)malloc(head + p->elem_size * POOL_SLAB_OBJECTS);
+        if(!slab) return NULL;
+        p->sys_allocs++;
+        ((PoolSlab*)slab)->next = p->slabs;
+        p->slabs = (PoolSlab*)slab;
+        for(int i = POOL_SLAB_OBJECTS - 1; i >= 0; i--) {
+            void* obj = slab + head + (size_t)i * p->elem_size;
+            *(void**)obj = p->free_list;
+            p->free_list = obj;
+        }
+    }
+    void* obj = p->free_list;
+    p->free_list = *(void**)obj;
+    p->allocs++;
+    p->live++;
+    return obj;
+}
+
+static inline void pool_put(ObjPool* p, void* obj) {
+    *(void**)obj = p->free_list;
+    p->free_list = obj;
+    p->live--;
+}
+
+static inline void pool_free(ObjPool* p) {
+    PoolSlab* s = p->slabs;
+    while(s) {
+        PoolSlab* next = s->next;
+        free(s);
+        s = next;
+    }
+    p->slabs = NULL;
+    p->free_list = NULL;
+    p->live = 0;
+}
+
+/* Typed wrappers: POOL_NEW(&pool, FlybyNode) */
+#define POOL_NEW(pool, Type) ((Type*)pool_get(pool))
+#define ARENA_NEW(arena, Type, count) ((Type*)arena_alloc((arena), sizeof(Type) * (size_t)(count)))
+
+#endif /* ARENA_H */
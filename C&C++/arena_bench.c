@@ -0,0 +1,340 @@
+/*
+ arena_bench.c
+ Allocation counts and speed of planner scratch memory: malloc vs arenas
+
+ Overview:
+  - Each mission runs a scratch-heavy planning step of the kind richer
+    models need:
+    * a flyby tree: every heliocentric body sequence of up to MAX_FLYBYS
+      legs within a delta-v budget, one node per candidate
+    * a sampled trajectory: TRAJ_SAMPLES states propagated with
+      kepler_batch.h along the best arc
+    * a text report with one line per kept candidate
+  - The same step runs twice per worker: with malloc/free, and with a
+    per-worker Arena (reset per mission) plus an ObjPool for tree nodes.
+  - Reports system allocations per mission after warm-up (zero for the
+    arena path), missions per second of wall time, and worker CPU time
+    per mission, with one worker per thread.
+  - Hardware counters (perf_counters.h) cover each whole run, workers
+    included, and are reported per mission including warm-up. Their ns
+    column is worker CPU time too, so it lines up with the cycle counts
+    and differs from cpu us/mission only by the warm-up missions.
+
+ Usage: arena_bench [missions_per_thread] [threads]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "mission_core.h"
+#include "transfer_costs.h"
+#include "kepler_batch.h"
+#include "arena.h"
+#include "perf_counters.h"
+
+#define MAX_FLYBYS 3
+#define DV_BUDGET_KM_S 30.0
+#define TRAJ_SAMPLES 256
+#define REPORT_LINES 8
+#define WARMUP_MISSIONS 16
+
+typedef struct FlybyNode {
+    int body;
+    int depth;
+    double dv;              /* heliocentric delta-v so far */
+    double days;
+    struct FlybyNode* parent;
+    struct FlybyNode* first_child;
+    struct FlybyNode* sibling;
+} FlybyNode;
+
+/* Scratch allocation interface: the planner code below is the same for
+   both strategies and only calls these */
+typedef struct {
+    int use_arena;
+    Arena arena;
+    ObjPool nodes;
+    size_t mallocs;         /* system allocations on the malloc path */
+    void** owned;           /* malloc path: blocks to free at mission end */
+    size_t num_owned, cap_owned;
+} Scratch;
+
+static void scratch_oom() {
+    printf("out of memory\n");
+    exit(1);
+}
+
+/* Never returns NULL: a failed allocation ends the benchmark */
+static void* scratch_alloc(Scratch* s, size_t size) {
+    if(s->use_arena) {
+        void* p = arena_alloc(&s->arena, size);
+        if(!p) scratch_oom();
+        return p;
+    }
+    void* p = malloc(size);
+    s->mallocs++;
+    if(!p) scratch_oom();
+    if(s->num_owned == s->cap_owned) {
+        size_t cap = s->cap_owned ? s->cap_owned * 2 : 64;
+        void** owned = realloc(s->owned, sizeof(void*) * cap);
+        s->mallocs++;
+        if(!owned) scratch_oom();
+        s->owned = owned;
+        s->cap_owned = cap;
+    }
+    s->owned[s->num_owned++] = p;
+    return p;
+}
+
+static FlybyNode* scratch_node(Scratch* s) {
+    if(s->use_arena) return POOL_NEW(&s->nodes, FlybyNode);
+    s->mallocs++;
+    return malloc(sizeof(FlybyNode));
+}
+
+static void release_tree(Scratch* s, FlybyNode* n) {
+    while(n) {
+        FlybyNode* next = n->sibling;
+        release_tree(s, n->first_child);
+        if(s->use_arena) pool_put(&s->nodes, n); else free(n);
+        n = next;
+    }
+}
+
+static void scratch_end_mission(Scratch* s) {
+    if(s->use_arena) {
+        arena_reset(&s->arena);
+        return;
+    }
+    for(size_t i = 0; i < s->num_owned; i++) free(s->owned[i]);
+    s->num_owned = 0;
+}
+
+/* Heliocentric bodies usable as flyby targets */
+static int helio[NUM_ORBIT_BODIES];
+static int num_helio;
+volatile double bench_sink;    /* keeps the planning work observable */
+
+/* Expand all sequences from node within the budget; returns nodes created */
+static int expand(Scratch* s, FlybyNode* node, int target) {
+    if(node->depth >= MAX_FLYBYS || node->body == target) return 0;
+    int created = 0;
+    double r1 = orbit_bodies[node->body].a_km;
+    for(int k = 0; k < num_helio; k++) {
+        int b = helio[k];
+        if(b == node->body) continue;
+        double r2 = orbit_bodies[b].a_km;
+        double va, vb;
+        double dv = node->dv + hohmann_dv(MU_SUN, r1, r2, &va, &vb);
+        if(dv > DV_BUDGET_KM_S) continue;
+        FlybyNode* c = scratch_node(s);
+        if(!c) return created;
+        c->body = b;
+        c->depth = node->depth + 1;
+        c->dv = dv;
+        c->days = node->days + 0.5 * orbit_period_days(MU_SUN, 0.5 * (r1 + r2));
+        c->parent = node;
+        c->first_child = NULL;
+        c->sibling = node->first_child;
+        node->first_child = c;
+        created += 1 + expand(s, c, target);
+    }
+    return created;
+}
+
+/* Collect the cheapest sequences that end at the target */
+static void best_leaves(FlybyNode* n, int target, FlybyNode** best, int* nbest) {
+    for(; n; n = n->sibling) {
+        if(n->body == target) {
+            int i;
+            if(*nbest < REPORT_LINES) i = (*nbest)++;
+            else if(n->dv < best[REPORT_LINES - 1]->dv) i = REPORT_LINES - 1;
+            else i = -1;
+            if(i >= 0) {
+                best[i] = n;
+                while(i > 0 && best[i - 1]->dv > best[i]->dv) {
+                    FlybyNode* t = best[i]; best[i] = best[i - 1]; best[i - 1] = t;
+                    i--;
+                }
+            }
+        }
+        best_leaves(n->first_child, target, best, nbest);
+    }
+}
+
+/* One mission's planning step. Returns a checksum so work is not elided. */
+static double plan_mission(Scratch* s, int target) {
+    FlybyNode* root = scratch_node(s);
+    if(!root) scratch_oom();
+    memset(root, 0, sizeof(*root));
+    root->body = TC_EARTH;
+    int nodes = 1 + expand(s, root, target);
+
+    FlybyNode* best[REPORT_LINES] = {0};
+    int nbest = 0;
+    best_leaves(root->first_child, target, best, &nbest);
+
+    /* Sample the first leg of the best sequence */
+    StateSoA st;
+    double* block = scratch_alloc(s, sizeof(double) * 6 * TRAJ_SAMPLES);
+    double* dt = scratch_alloc(s, sizeof(double) * TRAJ_SAMPLES);
+    st.x = block; st.y = block + TRAJ_SAMPLES; st.z = block + 2 * TRAJ_SAMPLES;
+    st.vx = block + 3 * TRAJ_SAMPLES; st.vy = block + 4 * TRAJ_SAMPLES; st.vz = block + 5 * TRAJ_SAMPLES;
+    double r0 = orbit_bodies[TC_EARTH].a_km;
+    double days = nbest ? best[0]->days : 100.0;
+    for(int i = 0; i < TRAJ_SAMPLES; i++) {
+        st.x[i] = r0; st.y[i] = 0.0; st.z[i] = 0.0;
+        st.vx[i] = 0.0; st.vy[i] = sqrt(MU_SUN / r0) * 1.1; st.vz[i] = 0.0;
+        dt[i] = days * 86400.0 * i / TRAJ_SAMPLES;
+    }
+    kepler_propagate_batch(MU_SUN, &st, dt, &st, TRAJ_SAMPLES);
+
+    /* Report lines */
+    double check = st.x[TRAJ_SAMPLES - 1] * 1e-9 + nodes;
+    for(int i = 0; i < nbest; i++) {
+        char* line;
+        const char* name = orbit_bodies[best[i]->body].name;
+        if(s->use_arena) {
+            line = arena_printf(&s->arena, "%d: %s via %d flybys, %.2f km/s, %.0f days",
+                                i + 1, name, best[i]->depth - 1, best[i]->dv, best[i]->days);
+        } else {
+            int n = snprintf(NULL, 0, "%d: %s via %d flybys, %.2f km/s, %.0f days",
+                             i + 1, name, best[i]->depth - 1, best[i]->dv, best[i]->days);
+            line = scratch_alloc(s, (size_t)n + 1);
+            snprintf(line, (size_t)n + 1, "%d: %s via %d flybys, %.2f km/s, %.0f days",
+                     i + 1, name, best[i]->depth - 1, best[i]->dv, best[i]->days);
+        }
+        check += (double)strlen(line);
+    }
+
+    release_tree(s, root);
+    scratch_end_mission(s);
+    return check;
+}
+
+typedef struct {
+    int use_arena;
+    int missions;
+    int seed;
+    double seconds;
+    double cpu_seconds;     /* thread CPU time after warm-up */
+    double cpu_total;       /* thread CPU time including warm-up */
+    size_t steady_mallocs;  /* system allocations after warm-up */
+    size_t allocs_served;
+    size_t peak_bytes;
+    double checksum;
+} Worker;
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double thread_cpu_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void* worker_main(void* arg) {
+    Worker* w = (Worker*)arg;
+    Scratch s;
+    memset(&s, 0, sizeof(s));
+    s.use_arena = w->use_arena;
+    arena_init(&s.arena, 0);
+    pool_init(&s.nodes, sizeof(FlybyNode));
+    unsigned rng = (unsigned)w->seed * 2654435761u + 1u;
+    size_t before = 0;
+    double t0 = 0.0, c0 = 0.0, cstart = thread_cpu_sec();
+    for(int m = 0; m < w->missions + WARMUP_MISSIONS; m++) {
+        if(m == WARMUP_MISSIONS) {
+            before = s.mallocs + s.arena.sys_allocs + s.nodes.sys_allocs;
+            t0 = now_sec();
+            c0 = thread_cpu_sec();
+        }
+        rng = rng * 1664525u + 1013904223u;
+        int target = helio[1 + (rng >> 8) % (unsigned)(num_helio - 1)];
+        w->checksum += plan_mission(&s, target);
+    }
+    w->seconds = now_sec() - t0;
+    double cend = thread_cpu_sec();
+    w->cpu_seconds = cend - c0;
+    w->cpu_total = cend - cstart;
+    w->steady_mallocs = s.mallocs + s.arena.sys_allocs + s.nodes.sys_allocs - before;
+    w->allocs_served = s.arena.allocs + s.nodes.allocs;
+    w->peak_bytes = s.arena.peak;
+    pool_free(&s.nodes);
+    arena_free(&s.arena);
+    free(s.owned);
+    return NULL;
+}
+
+static void run(int use_arena, int missions, int nthreads, PerfCounters* pc, PcSample* ps) {
+    Worker* w = calloc((size_t)nthreads, sizeof(Worker));
+    pthread_t* tids = malloc(sizeof(pthread_t) * (size_t)nthreads);
+    if(!w || !tids) { printf("out of memory\n"); exit(1); }
+    pc_start(pc, ps);
+    for(int t = 0; t < nthreads; t++) {
+        w[t].use_arena = use_arena;
+        w[t].missions = missions;
+        w[t].seed = t + 1;
+        if(pthread_create(&tids[t], NULL, worker_main, &w[t]) != 0) {
+            printf("cannot start worker thread\n");
+            for(int k = 0; k < t; k++) pthread_join(tids[k], NULL);
+            exit(1);
+        }
+    }
+    size_t mallocs = 0, served = 0, peak = 0;
+    double secs = 0.0, cpu = 0.0, cpu_total = 0.0, check = 0.0;
+    for(int t = 0; t < nthreads; t++) {
+        pthread_join(tids[t], NULL);
+        mallocs += w[t].steady_mallocs;
+        served += w[t].allocs_served;
+        if(w[t].peak_bytes > peak) peak = w[t].peak_bytes;
+        if(w[t].seconds > secs) secs = w[t].seconds;
+        cpu += w[t].cpu_seconds;
+        cpu_total += w[t].cpu_total;
+        check += w[t].checksum;
+    }
+    pc_stop(pc, ps);
+    ps->seconds = cpu_total;    /* counter rows report CPU time, like the counts */
+    double total = (double)missions * nthreads;
+    printf(" %-14s %12.2f %14.0f %12.1f", use_arena ? "arena + pool" : "malloc/free",
+           mallocs / total, total / secs, cpu * 1e6 / total);
+    if(use_arena) printf("   (%zu served, peak %zu KiB/mission)", served, peak / 1024);
+    printf("\n");
+    bench_sink += check;
+    free(w);
+    free(tids);
+}
+
+int main(int argc, char** argv) {
+    int missions = argc > 1 ? atoi(argv[1]) : 2000;
+    int nthreads = argc > 2 ? atoi(argv[2]) : 4;
+    if(missions < 1) missions = 1;
+    if(nthreads < 1) nthreads = 1;
+    for(int i = 0; i < NUM_ORBIT_BODIES; i++)
+        if(orbit_bodies[i].central == TC_SUN) helio[num_helio++] = i;
+
+    printf("\n--- PLANNER SCRATCH MEMORY (%d missions x %d threads) ---\n", missions, nthreads);
+    printf(" %-14s %12s %14s %12s\n", "Strategy", "mallocs/msn", "missions/s", "cpu us/msn");
+    PerfCounters pc;
+    PcSample ps[2];
+    pc_open(&pc);
+    run(0, missions, nthreads, &pc, &ps[0]);
+    run(1, missions, nthreads, &pc, &ps[1]);
+
+    double per_run = (double)(missions + WARMUP_MISSIONS) * nthreads;
+    printf("\n");
+    pc_print_status(stdout, &pc);
+    printf("Counter rows: worker CPU time and counts per mission, warm-up included\n");
+    pc_print_header(stdout, 14);
+    pc_print_row(stdout, 14, "malloc/free", &ps[0], per_run);
+    pc_print_row(stdout, 14, "arena + pool", &ps[1], per_run);
+    pc_close(&pc);
+    return 0;
+}
@@ -1,7 +1,10 @@
 // C program to store temperature of two cities of a week and display it.
 #include <stdio.h>
+#include "fastout.h"
 const int CITY = 2;
 const int WEEK = 7;
+// Longest row: "City " + index + ", Day " + index + " = " + value + '\n'
+const size_t ROW_CHARS = 5 + FO_MAX_INT_CHARS + 6 + FO_MAX_INT_CHARS + 3 + FO_MAX_INT_CHARS + 1;
 int main()
 {
   int temperature[CITY][WEEK];
@@ -16,15 +19,27 @@ int main()
     }
   }
   printf("\nDisplaying values: \n\n");
+  fflush(stdout);
 
-  // Using nested loop to display vlues of a 2d array
+  // Using nested loop to display vlues of a 2d array through one buffered writer
+  FastOut out;
+  if (fo_open(&out, 1) != 0)
+    return 1;
   for (int i = 0; i < CITY; ++i)
   {
     for (int j = 0; j < WEEK; ++j)
     {
-      printf("City %d, Day %d = %d\n", i + 1, j + 1, temperature[i][j]);
+      char *p = fo_reserve(&out, ROW_CHARS);
+      p = fo_fmt_str(p, "City ", 5);
+      p = fo_fmt_u32(p, (uint32_t)(i + 1));
+      p = fo_fmt_str(p, ", Day ", 6);
+      p = fo_fmt_u32(p, (uint32_t)(j + 1));
+      p = fo_fmt_str(p, " = ", 3);
+      p = fo_fmt_i32(p, temperature[i][j]);
+      *p++ = '\n';
+      fo_commit(&out, p);
     }
   }
-  return 0;
+  return fo_close(&out) == 0 ? 0 : 1;
 }
 
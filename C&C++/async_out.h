@@ -0,0 +1,561 @@
+/*
+ async_out.h
+ Asynchronous buffered file output for result and report files
+
+ Overview:
+  - Writers fill fixed-size blocks; a full block is handed to the I/O
+    engine and the writer moves on to the next free block at once. With
+    two or more blocks, formatting and disk writes overlap and the writer
+    only waits (a "stall") when every block is still in flight.
+  - Engines, chosen when the file is opened:
+    * io_uring (Linux): blocks submitted as IORING_OP_WRITEV at explicit
+      offsets through the raw syscalls; no liburing needed
+    * thread pool: AO_THREADS workers issuing pwrite(), used when io_uring
+      is unavailable (old kernel, seccomp) or with AO_FORCE_THREADS
+    * synchronous write() on Windows
+  - Only full blocks are submitted until ao_close(); a reserved row that
+    would cross the end of a block is formatted into a spill buffer and
+    copied across the boundary on commit, so every block starts at a
+    multiple of the block size.
+  - AO_DIRECT opens with O_DIRECT for large sequential outputs: blocks are
+    page-aligned, the final partial block is zero-padded and the file is
+    truncated back to its real length on close. File systems that refuse
+    O_DIRECT (tmpfs) silently get normal buffered I/O; ao->direct tells
+    which one took effect.
+  - After a write error the writer calls turn into no-ops, but a block
+    is only reused or freed once its write has completed; a block whose
+    completion can no longer be reaped is leaked rather than freed under
+    the kernel.
+*/
+
+#ifndef ASYNC_OUT_H
+#define ASYNC_OUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#define AO_BLOCK_DEFAULT (1 << 20)
+#define AO_MAX_BUFFERS 16
+#define AO_ALIGN 4096
+#define AO_THREADS 2
+
+/* ao_open() flags */
+#define AO_DIRECT 1
+#define AO_FORCE_THREADS 2
+
+/* glibc only exposes O_DIRECT under _GNU_SOURCE, which must be defined
+   before the first system header; fall back to its internal name */
+#if defined(O_DIRECT)
+#define AO_O_DIRECT O_DIRECT
+#elif defined(__O_DIRECT)
+#define AO_O_DIRECT __O_DIRECT
+#endif
+
+#define AO_ENGINE_SYNC 0
+#define AO_ENGINE_THREADS 1
+#define AO_ENGINE_URING 2
+
+#define AO_FREE 0
+#define AO_FILLING 1
+#define AO_INFLIGHT 2
+
+typedef struct {
+    char* data;
+    size_t len;             /* bytes filled */
+    size_t done;            /* bytes written so far (short-write resume) */
+    size_t submit_len;      /* bytes being written (len padded for O_DIRECT) */
+    long long offset;
+    int state;
+} AoBuffer;
+
+typedef struct {
+    int fd;
+    int engine;
+    int direct;
+    int error;
+    int stuck;              /* io_uring completions can no longer be reaped */
+    size_t block;
+    int nbuf;
+    int cur;
+    long long offset;       /* file offset of the next block */
+    long long size;         /* logical file size */
+    AoBuffer buf[AO_MAX_BUFFERS];
+    char* spill;            /* ao_reserve() space for rows crossing a block end */
+    int spilling;
+    size_t stalls;          /* times the writer waited for a free block */
+    double stall_seconds;
+#ifdef __linux__
+    int ring_fd;
+    void* sq_ptr;
+    void* cq_ptr;
+    size_t sq_size, cq_size, sqe_size;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    struct iovec iov[AO_MAX_BUFFERS];
+#endif
+#ifndef _WIN32
+    pthread_t threads[AO_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int queue[AO_MAX_BUFFERS];
+    int q_head, q_count;
+    int stop;
+#endif
+} AsyncOut;
+
+static inline double ao_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ---------------------------------------------------------------------- */
+/* io_uring engine                                                         */
+/* ---------------------------------------------------------------------- */
+
+#ifdef __linux__
+static inline int ao_uring_setup(AsyncOut* ao) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    long fd = syscall(__NR_io_uring_setup, (unsigned)AO_MAX_BUFFERS, &p);
+    if(fd < 0) return -1;
+    ao->ring_fd = (int)fd;
+    ao->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ao->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ao->sqe_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ao->sq_ptr = mmap(NULL, ao->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ao->ring_fd,
+                      IORING_OFF_SQ_RING);
+    ao->cq_ptr = mmap(NULL, ao->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ao->ring_fd,
+                      IORING_OFF_CQ_RING);
+    ao->sqes = (struct io_uring_sqe*)mmap(NULL, ao->sqe_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                          ao->ring_fd, IORING_OFF_SQES);
+    if(ao->sq_ptr == MAP_FAILED || ao->cq_ptr == MAP_FAILED || ao->sqes == MAP_FAILED) {
+        if(ao->sq_ptr != MAP_FAILED) munmap(ao->sq_ptr, ao->sq_size);
+        if(ao->cq_ptr != MAP_FAILED) munmap(ao->cq_ptr, ao->cq_size);
+        if(ao->sqes != MAP_FAILED) munmap(ao->sqes, ao->sqe_size);
+        close(ao->ring_fd);
+        return -1;
+    }
+    char* sq = (char*)ao->sq_ptr;
+    char* cq = (char*)ao->cq_ptr;
+    ao->sq_head = (unsigned*)(sq + p.sq_off.head);
+    ao->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    ao->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    ao->sq_array = (unsigned*)(sq + p.sq_off.array);
+    ao->cq_head = (unsigned*)(cq + p.cq_off.head);
+    ao->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    ao->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    ao->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static inline void ao_uring_submit(AsyncOut* ao, int idx) {
+    AoBuffer* b = &ao->buf[idx];
+    unsigned tail = *ao->sq_tail;
+    unsigned slot = tail & *ao->sq_mask;
+    struct io_uring_sqe* sqe = &ao->sqes[slot];
+    memset(sqe, 0, sizeof(*sqe));
+    ao->iov[idx].iov_base = b->data + b->done;
+    ao->iov[idx].iov_len = b->submit_len - b->done;
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = ao->fd;
+    sqe->addr = (unsigned long)&ao->iov[idx];
+    sqe->len = 1;
+    sqe->off = (unsigned long long)(b->offset + (long long)b->done);
+    sqe->user_data = (unsigned long long)idx;
+    ao->sq_array[slot] = slot;
+    __atomic_store_n(ao->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    long rc;
+    do {
+        rc = syscall(__NR_io_uring_enter, ao->ring_fd, 1, 0, 0, NULL, 0);
+    } while(rc < 0 && errno == EINTR);
+    if(rc < 1) {
+        /* Not consumed by the kernel: take the entry back, the block is idle */
+        __atomic_store_n(ao->sq_tail, tail, __ATOMIC_RELEASE);
+        ao->error = 1;
+        b->state = AO_FREE;
+    }
+}
+
+/* Process completions; with wait set, block until at least one arrives.
+   Returns -1 (and sets stuck) if waiting for completions fails. */
+static inline int ao_uring_reap(AsyncOut* ao, int wait) {
+    for(;;) {
+        unsigned head = *ao->cq_head;
+        unsigned tail = __atomic_load_n(ao->cq_tail, __ATOMIC_ACQUIRE);
+        if(head == tail) {
+            if(!wait) return 0;
+            if(syscall(__NR_io_uring_enter, ao->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+               errno != EINTR) {
+                ao->error = 1;
+                ao->stuck = 1;
+                return -1;
+            }
+            continue;
+        }
+        for(; head != tail; head++) {
+            struct io_uring_cqe* cqe = &ao->cqes[head & *ao->cq_mask];
+            int idx = (int)cqe->user_data;
+            AoBuffer* b = &ao->buf[idx];
+            if(cqe->res < 0) {
+                ao->error = 1;
+                b->state = AO_FREE;
+            } else {
+                b->done += (size_t)cqe->res;
+                if(b->done < b->submit_len && cqe->res > 0) {
+                    __atomic_store_n(ao->cq_head, head + 1, __ATOMIC_RELEASE);
+                    ao_uring_submit(ao, idx);   /* short write: resume */
+                    head++;
+                    break;
+                }
+                if(b->done < b->submit_len) ao->error = 1;
+                b->state = AO_FREE;
+            }
+        }
+        __atomic_store_n(ao->cq_head, head, __ATOMIC_RELEASE);
+        return 0;
+    }
+}
+
+/* Wait for block idx to leave AO_INFLIGHT, error or not. Returns 0, or -1
+   if the ring is stuck and the block may still be in use by the kernel. */
+static inline int ao_uring_wait_block(AsyncOut* ao, int idx) {
+    while(ao->buf[idx].state == AO_INFLIGHT) {
+        if(ao->stuck || ao_uring_reap(ao, 1) != 0) return -1;
+    }
+    return 0;
+}
+
+static inline void ao_uring_close(AsyncOut* ao) {
+    munmap(ao->sqes, ao->sqe_size);
+    munmap(ao->cq_ptr, ao->cq_size);
+    munmap(ao->sq_ptr, ao->sq_size);
+    close(ao->ring_fd);
+}
+#endif
+
+/* ---------------------------------------------------------------------- */
+/* Thread-pool and synchronous engines                                     */
+/* ---------------------------------------------------------------------- */
+
+/* Write the whole buffer at its offset. Returns 0 or -1. */
+static inline int ao_write_block(AsyncOut* ao, AoBuffer* b) {
+#ifdef _WIN32
+    (void)b->offset;        /* blocks are submitted in order */
+    const char* p = b->data;
+    size_t n = b->submit_len;
+    while(n > 0) {
+        int w = _write(ao->fd, p, (unsigned)n);
+        if(w <= 0) return -1;
+        p += w;
+        n -= (size_t)w;
+    }
+#else
+    while(b->done < b->submit_len) {
+        ssize_t w = pwrite(ao->fd, b->data + b->done, b->submit_len - b->done, (off_t)(b->offset + (long long)b->done));
+        if(w < 0 && errno == EINTR) continue;
+        if(w <= 0) return -1;
+        b->done += (size_t)w;
+    }
+#endif
+    return 0;
+}
+
+#ifndef _WIN32
+static void* ao_thread_main(void* arg) {
+    AsyncOut* ao = (AsyncOut*)arg;
+    pthread_mutex_lock(&ao->lock);
+    for(;;) {
+        while(ao->q_count == 0 && !ao->stop) pthread_cond_wait(&ao->cond, &ao->lock);
+        if(ao->q_count == 0 && ao->stop) break;
+        int idx = ao->queue[ao->q_head];
+        ao->q_head = (ao->q_head + 1) % AO_MAX_BUFFERS;
+        ao->q_count--;
+        pthread_mutex_unlock(&ao->lock);
+        int rc = ao_write_block(ao, &ao->buf[idx]);
+        pthread_mutex_lock(&ao->lock);
+        if(rc != 0) ao->error = 1;
+        ao->buf[idx].state = AO_FREE;
+        pthread_cond_broadcast(&ao->cond);
+    }
+    pthread_mutex_unlock(&ao->lock);
+    return NULL;
+}
+#endif
+
+/* ---------------------------------------------------------------------- */
+/* Writer side                                                             */
+/* ---------------------------------------------------------------------- */
+
+/* Hand the current block to the engine */
+static inline void ao_submit(AsyncOut* ao) {
+    AoBuffer* b = &ao->buf[ao->cur];
+    if(b->state != AO_FILLING || b->len == 0) return;
+    b->offset = ao->offset;
+    b->done = 0;
+    b->submit_len = b->len;
+    if(ao->direct && (b->len % AO_ALIGN) != 0) {
+        /* Final partial block (ao_close only): pad to the alignment
+           O_DIRECT requires */
+        size_t padded = (b->len + AO_ALIGN - 1) & ~(size_t)(AO_ALIGN - 1);
+        memset(b->data + b->len, 0, padded - b->len);
+        b->submit_len = padded;
+    }
+    ao->offset += (long long)b->len;
+    ao->size = ao->offset;
+    b->state = AO_INFLIGHT;
+#ifdef __linux__
+    if(ao->engine == AO_ENGINE_URING) {
+        ao_uring_submit(ao, ao->cur);
+        return;
+    }
+#endif
+#ifndef _WIN32
+    if(ao->engine == AO_ENGINE_THREADS) {
+        pthread_mutex_lock(&ao->lock);
+        ao->queue[(ao->q_head + ao->q_count) % AO_MAX_BUFFERS] = ao->cur;
+        ao->q_count++;
+        pthread_cond_broadcast(&ao->cond);
+        pthread_mutex_unlock(&ao->lock);
+        return;
+    }
+#endif
+    if(ao_write_block(ao, b) != 0) ao->error = 1;
+    b->state = AO_FREE;
+}
+
+/* Make the next block current, waiting if all blocks are in flight */
+static inline void ao_next_block(AsyncOut* ao) {
+    int next = (ao->cur + 1) % ao->nbuf;
+    AoBuffer* b = &ao->buf[next];
+#ifdef __linux__
+    if(ao->engine == AO_ENGINE_URING) ao_uring_reap(ao, 0);
+#endif
+    if(b->state != AO_FREE) {
+        double t0 = ao_now();
+        ao->stalls++;
+#ifdef __linux__
+        if(ao->engine == AO_ENGINE_URING && ao_uring_wait_block(ao, next) != 0) {
+            /* Never hand out a block the kernel may still be reading; the
+               error set by the reap makes further writes no-ops */
+            ao->stall_seconds += ao_now() - t0;
+            return;
+        }
+#endif
+#ifndef _WIN32
+        if(ao->engine == AO_ENGINE_THREADS) {
+            pthread_mutex_lock(&ao->lock);
+            while(b->state != AO_FREE) pthread_cond_wait(&ao->cond, &ao->lock);
+            pthread_mutex_unlock(&ao->lock);
+        }
+#endif
+        ao->stall_seconds += ao_now() - t0;
+    }
+    ao->cur = next;
+    b->state = AO_FILLING;
+    b->len = 0;
+}
+
+static inline void ao_free_buffers(AsyncOut* ao) {
+    for(int i = 0; i < ao->nbuf; i++)
+        if(ao->buf[i].state != AO_INFLIGHT) free(ao->buf[i].data);
+    free(ao->spill);
+}
+
+/* Open path for writing. block and nbuf of 0 pick the defaults (1 MiB, 2).
+   Returns NULL on failure, including when the buffers cannot be allocated. */
+static inline AsyncOut* ao_open(const char* path, int flags, size_t block, int nbuf) {
+    AsyncOut* ao = (AsyncOut*)calloc(1, sizeof(AsyncOut));
+    if(!ao) return NULL;
+    if(block == 0) block = AO_BLOCK_DEFAULT;
+    block = (block + AO_ALIGN - 1) & ~(size_t)(AO_ALIGN - 1);
+    if(nbuf <= 0) nbuf = 2;
+    if(nbuf > AO_MAX_BUFFERS) nbuf = AO_MAX_BUFFERS;
+    ao->block = block;
+    ao->nbuf = nbuf;
+
+#ifdef _WIN32
+    ao->fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+    ao->engine = AO_ENGINE_SYNC;
+    (void)flags;
+#else
+    int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+    ao->fd = -1;
+#ifdef AO_O_DIRECT
+    if(flags & AO_DIRECT) {
+        ao->fd = open(path, oflags | AO_O_DIRECT, 0644);
+        ao->direct = ao->fd >= 0;
+    }
+#endif
+    if(ao->fd < 0) ao->fd = open(path, oflags, 0644);
+#endif
+    if(ao->fd < 0) {
+        free(ao);
+        return NULL;
+    }
+    for(int i = 0; i < nbuf; i++) {
+#ifdef _WIN32
+        ao->buf[i].data = (char*)malloc(block);
+#else
+        if(posix_memalign((void**)&ao->buf[i].data, AO_ALIGN, block) != 0) ao->buf[i].data = NULL;
+#endif
+        if(!ao->buf[i].data) ao->error = 1;
+    }
+    ao->spill = (char*)malloc(block);
+    if(!ao->spill) ao->error = 1;
+    if(ao->error) goto fail;
+
+#ifndef _WIN32
+    ao->engine = AO_ENGINE_THREADS;
+#ifdef __linux__
+    if(!(flags & AO_FORCE_THREADS) && ao_uring_setup(ao) == 0) ao->engine = AO_ENGINE_URING;
+#endif
+    if(ao->engine == AO_ENGINE_THREADS) {
+        pthread_mutex_init(&ao->lock, NULL);
+        pthread_cond_init(&ao->cond, NULL);
+        int started = 0;
+        while(started < AO_THREADS && pthread_create(&ao->threads[started], NULL, ao_thread_main, ao) == 0)
+            started++;
+        if(started < AO_THREADS) {
+            pthread_mutex_lock(&ao->lock);
+            ao->stop = 1;
+            pthread_cond_broadcast(&ao->cond);
+            pthread_mutex_unlock(&ao->lock);
+            for(int t = 0; t < started; t++) pthread_join(ao->threads[t], NULL);
+            pthread_cond_destroy(&ao->cond);
+            pthread_mutex_destroy(&ao->lock);
+            goto fail;
+        }
+    }
+#endif
+    ao->cur = 0;
+    ao->buf[0].state = AO_FILLING;
+    return ao;
+
+fail:
+    ao_free_buffers(ao);
+#ifdef _WIN32
+    _close(ao->fd);
+#else
+    close(ao->fd);
+#endif
+    free(ao);
+    return NULL;
+}
+
+static inline void ao_write(AsyncOut* ao, const void* data, size_t n) {
+    const char* p = (const char*)data;
+    while(n > 0 && !ao->error) {
+        AoBuffer* b = &ao->buf[ao->cur];
+        size_t room = ao->block - b->len;
+        size_t k = n < room ? n : room;
+        memcpy(b->data + b->len, p, k);
+        b->len += k;
+        p += k;
+        n -= k;
+        if(b->len == ao->block) {
+            ao_submit(ao);
+            ao_next_block(ao);
+        }
+    }
+}
+
+/* Zero-copy formatting as in fastout.h: reserve up to need bytes
+   (need <= block size), write them, then commit the end pointer. Near the
+   end of a block the space comes from the spill buffer instead. */
+static inline char* ao_reserve(AsyncOut* ao, size_t need) {
+    AoBuffer* b = &ao->buf[ao->cur];
+    if(ao->error || b->len + need > ao->block) {
+        /* After an error the spill buffer takes the row and ao_write drops it */
+        ao->spilling = 1;
+        return ao->spill;
+    }
+    return b->data + b->len;
+}
+
+static inline void ao_commit(AsyncOut* ao, char* end) {
+    if(ao->spilling) {
+        ao->spilling = 0;
+        ao_write(ao, ao->spill, (size_t)(end - ao->spill));
+        return;
+    }
+    AoBuffer* b = &ao->buf[ao->cur];
+    b->len = (size_t)(end - b->data);
+}
+
+static inline void ao_printf(AsyncOut* ao, const char* fmt, ...) {
+    if(ao->error) return;
+    AoBuffer* b = &ao->buf[ao->cur];
+    size_t room = ao->block - b->len;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(b->data + b->len, room, fmt, ap);
+    va_end(ap);
+    if(n < 0) return;
+    if((size_t)n < room) {
+        b->len += (size_t)n;
+        return;
+    }
+    /* Did not fit: format into a temporary and copy across blocks */
+    char stack[1024];
+    char* tmp = (size_t)n < sizeof(stack) ? stack : (char*)malloc((size_t)n + 1);
+    if(!tmp) { ao->error = 1; return; }
+    va_start(ap, fmt);
+    vsnprintf(tmp, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    ao_write(ao, tmp, (size_t)n);
+    if(tmp != stack) free(tmp);
+}
+
+/* Flush, wait for all writes, close. Returns 0, or -1 if any write failed. */
+static inline int ao_close(AsyncOut* ao) {
+    if(!ao->error) ao_submit(ao);
+#ifdef __linux__
+    if(ao->engine == AO_ENGINE_URING) {
+        /* Drain every write, failed or not, before anything is freed */
+        for(int i = 0; i < ao->nbuf; i++) ao_uring_wait_block(ao, i);
+        ao_uring_close(ao);
+    }
+#endif
+#ifndef _WIN32
+    if(ao->engine == AO_ENGINE_THREADS) {
+        pthread_mutex_lock(&ao->lock);
+        ao->stop = 1;
+        pthread_cond_broadcast(&ao->cond);
+        pthread_mutex_unlock(&ao->lock);
+        for(int t = 0; t < AO_THREADS; t++) pthread_join(ao->threads[t], NULL);
+        pthread_cond_destroy(&ao->cond);
+        pthread_mutex_destroy(&ao->lock);
+    }
+    if(ao->direct && ftruncate(ao->fd, (off_t)ao->size) != 0) ao->error = 1;
+    if(close(ao->fd) != 0) ao->error = 1;
+#else
+    if(_close(ao->fd) != 0) ao->error = 1;
+#endif
+    int rc = ao->error ? -1 : 0;
+    ao_free_buffers(ao);    /* blocks still AO_INFLIGHT (stuck ring) are leaked */
+    free(ao);
+    return rc;
+}
+
+#endif /* ASYNC_OUT_H */
@@ -0,0 +1,159 @@
+/*
+ async_out_bench.c
+ Sweep result sink throughput: stdio vs async_out.h engines
+
+ Writes one CSV row per (rocket, body, payload) sweep result (margin in
+ m/s as an integer) through stdio fwrite, and through AsyncOut with the
+ io_uring engine, the thread-pool engine and io_uring + O_DIRECT. Rows
+ are formatted with fastout.h so formatting does not hide the I/O cost.
+ Reports wall time, MB/s, and how often and how long the sweep thread
+ stalled waiting for disk. If the file system refuses O_DIRECT the direct
+ row says so: it then measures buffered I/O.
+ The stdio output is kept as a reference and every engine's file is
+ compared with it byte for byte, so a reordered or torn block is reported
+ as a mismatch rather than passing on size alone.
+
+ Usage: async_out_bench [rows] [file] [blocks]
+*/
+
+#define _GNU_SOURCE             /* O_DIRECT */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "mission_core.h"
+#include "async_out.h"
+#include "fastout.h"
+
+#define ROW_MAX 64              /* longest formatted row */
+
+#define MODE_STDIO 0
+#define MODE_URING 1
+#define MODE_THREADS 2
+#define MODE_DIRECT 3
+
+static const char* mode_names[] = {"stdio fwrite", "async io_uring", "async threads", "async io_uring+O_DIRECT"};
+static const char* engine_names[] = {"sync", "threads", "io_uring"};
+
+/* Result row i of the sweep */
+static void sweep_row(size_t i, size_t per_pair, int* r, int* b, int* payload, double* margin) {
+    size_t pair = i / per_pair;
+    *r = (int)(pair / (size_t)NUM_BODIES) % NUM_ROCKETS;
+    *b = (int)(pair % (size_t)NUM_BODIES);
+    *payload = (int)(rockets[*r].payload_leo_kg * (double)(i % per_pair) / (double)per_pair);
+    double req = EARTH_ASCENT_COST + bodies[*b].dv_transfer + bodies[*b].dv_capture;
+    *margin = calc_capability(&rockets[*r], *payload) - req;
+}
+
+/* "r,b,payload_kg,margin_m_s,success\n" */
+static char* format_row(char* p, int r, int b, int payload, double margin) {
+    p = fo_fmt_i32(p, r);
+    *p++ = ',';
+    p = fo_fmt_i32(p, b);
+    *p++ = ',';
+    p = fo_fmt_i32(p, payload);
+    *p++ = ',';
+    p = fo_fmt_i32(p, (int)lrint(margin * 1000.0));
+    *p++ = ',';
+    *p++ = margin >= 0.0 ? '1' : '0';
+    *p++ = '\n';
+    return p;
+}
+
+/* Offset of the first byte where the files differ (or where one ends),
+   -1 if identical, -2 if either cannot be read */
+static long long first_difference(const char* a, const char* b) {
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+    char* ba = malloc(1 << 20);
+    char* bb = malloc(1 << 20);
+    long long at = -2;
+    if(fa && fb && ba && bb) {
+        long long off = 0;
+        for(;;) {
+            size_t na = fread(ba, 1, 1 << 20, fa);
+            size_t nb = fread(bb, 1, 1 << 20, fb);
+            size_t n = na < nb ? na : nb;
+            size_t i = 0;
+            if(memcmp(ba, bb, n) != 0)
+                while(ba[i] == bb[i]) i++;
+            else
+                i = n;
+            if(i < n || na != nb) {
+                at = off + (long long)i;
+                break;
+            }
+            if(na == 0) {
+                at = -1;
+                break;
+            }
+            off += (long long)n;
+        }
+    }
+    if(fa) fclose(fa);
+    if(fb) fclose(fb);
+    free(ba);
+    free(bb);
+    return at;
+}
+
+static void run(int mode, size_t rows, const char* path, const char* ref, int blocks) {
+    size_t per_pair = rows / (size_t)(NUM_ROCKETS * NUM_BODIES) + 1;
+    double t0 = ao_now();
+    AsyncOut* ao = NULL;
+    FILE* f = NULL;
+    if(mode == MODE_STDIO) f = fopen(ref, "w");
+    else ao = ao_open(path, mode == MODE_DIRECT ? AO_DIRECT : (mode == MODE_THREADS ? AO_FORCE_THREADS : 0), 0, blocks);
+    if(!f && !ao) {
+        printf(" %-24s cannot open %s\n", mode_names[mode], path);
+        return;
+    }
+    int engine = ao ? ao->engine : AO_ENGINE_SYNC;
+    int direct = ao ? ao->direct : 0;
+    for(size_t i = 0; i < rows; i++) {
+        int r, b, payload;
+        double margin;
+        sweep_row(i, per_pair, &r, &b, &payload, &margin);
+        if(f) {
+            char row[ROW_MAX];
+            fwrite(row, 1, (size_t)(format_row(row, r, b, payload, margin) - row), f);
+        } else {
+            ao_commit(ao, format_row(ao_reserve(ao, ROW_MAX), r, b, payload, margin));
+        }
+    }
+    size_t stalls = ao ? ao->stalls : 0;
+    double stall = ao ? ao->stall_seconds : 0.0;
+    int rc = f ? fclose(f) : ao_close(ao);
+    double t = ao_now() - t0;
+
+    FILE* check = fopen(f ? ref : path, "rb");
+    long size = 0;
+    if(check) {
+        fseek(check, 0, SEEK_END);
+        size = ftell(check);
+        fclose(check);
+    }
+    char diff[64] = "";
+    if(ao) {
+        long long at = first_difference(ref, path);
+        if(at == -2) snprintf(diff, sizeof(diff), "  (cannot compare)");
+        else if(at >= 0) snprintf(diff, sizeof(diff), "  (MISMATCH at byte %lld)", at);
+    }
+    printf(" %-24s %-8s %-6s %8.3f s %8.1f MB/s %7zu stalls %8.4f s stalled%s%s%s\n", mode_names[mode],
+           engine_names[engine], direct ? "direct" : "-", t, size / t / 1e6, stalls, stall,
+           rc != 0 ? "  (WRITE ERROR)" : "",
+           mode == MODE_DIRECT && !direct ? "  (O_DIRECT refused, buffered)" : "", diff);
+}
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? (size_t)atol(argv[1]) : 20000000;
+    const char* path = argc > 2 ? argv[2] : "async_out_bench.csv";
+    int blocks = argc > 3 ? atoi(argv[3]) : 2;
+    char ref[512];
+    snprintf(ref, sizeof(ref), "%s.ref", path);
+    printf("\n--- RESULT SINK THROUGHPUT (%zu rows, %d blocks) ---\n", rows, blocks);
+    for(int mode = MODE_STDIO; mode <= MODE_DIRECT; mode++) run(mode, rows, path, ref, blocks);
+    remove(path);
+    remove(ref);
+    return 0;
+}
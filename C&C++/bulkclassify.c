@@ -0,0 +1,419 @@
+/*
+ bulkclassify.c
+ Bulk parity / predicate classification of integer streams
+
+ Overview:
+  - Bulk version of if.c: instead of one scanf'd number, classifies every
+    integer in a file (mmap'd) or on stdin.
+  - Predicates are evaluated a block at a time into packed bitmaps (one bit
+    per value). On CPUs with AVX2 the compare/mask kernel handles 8 values
+    per instruction; otherwise the scalar kernel is used. The choice is
+    made at startup (cpu_dispatch.h), so one binary serves both, and
+    SIMD_FORCE_ISA=scalar forces the scalar path for comparison.
+  - The input is split across all cores; each thread parses and classifies
+    its own range, and per-thread counts are summed at the end.
+  - Optionally prints the values matching every predicate, in input order.
+  - Text numbers outside the int32 range are skipped and counted, and a
+    trailing partial int32 in -b input is ignored; both are reported on
+    stderr. Running out of memory while collecting -p output is an error.
+  - A slice whose thread cannot be started is classified on the main
+    thread instead.
+  - -s reports the classification time and hardware counters
+    (perf_counters.h) per value on stderr, parse included.
+
+ Usage:
+   bulkclassify [options] [file|-] predicate...
+     -b          input is raw native int32 instead of decimal text
+     -p          print the values that satisfy all predicates
+     -t <n>      number of threads (default: all online cores)
+     -s          print time and hardware counters per value to stderr
+   predicates: even odd neg pos zero range:LO:HI div:K
+
+ Build: gcc -O2 -pthread bulkclassify.c -o bulkclassify
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "cpu_dispatch.h"
+#if CD_X86
+#include <immintrin.h>
+#endif
+#include "fastout.h"
+#include "perf_counters.h"
+
+#define MAX_PREDS 16
+#define BLOCK 4096                  /* values classified per bitmap block */
+#define BLOCK_WORDS (BLOCK / 64)
+
+typedef enum { P_EVEN, P_ODD, P_NEG, P_POS, P_ZERO, P_RANGE, P_DIV } PredKind;
+
+typedef struct {
+    PredKind kind;
+    char label[32];
+    int32_t lo, hi;         /* range:LO:HI (inclusive) */
+    uint32_t div_inv;       /* div:K -> modular inverse of K's odd part */
+    uint32_t div_limit;     /* (2^32-1) / odd part */
+    uint32_t div_low_mask;  /* low bits that must be zero for K's power of two */
+} Predicate;
+
+typedef struct {
+    /* input slice */
+    const char* text;
+    size_t text_len;
+    const int32_t* bin;
+    size_t bin_len;
+    /* results */
+    uint64_t counts[MAX_PREDS];
+    uint64_t all_count;
+    uint64_t total;
+    uint64_t out_of_range;  /* text numbers that do not fit in int32 */
+    int32_t* selected;
+    size_t sel_len, sel_cap;
+    int oom;                /* selected[] could not grow; results incomplete */
+    int threaded;           /* ran on its own thread (needs a join) */
+} Slice;
+
+Predicate preds[MAX_PREDS];
+int num_preds = 0;
+int print_selected = 0;
+
+/* Parse "even", "range:-5:30", "div:7" ... Returns 0 on success. */
+int parse_predicate(const char* s, Predicate* p) {
+    memset(p, 0, sizeof(*p));
+    strncpy(p->label, s, sizeof(p->label) - 1);
+    if(strcmp(s, "even") == 0) { p->kind = P_EVEN; return 0; }
+    if(strcmp(s, "odd") == 0) { p->kind = P_ODD; return 0; }
+    if(strcmp(s, "neg") == 0) { p->kind = P_NEG; return 0; }
+    if(strcmp(s, "pos") == 0) { p->kind = P_POS; return 0; }
+    if(strcmp(s, "zero") == 0) { p->kind = P_ZERO; return 0; }
+    if(sscanf(s, "range:%d:%d", &p->lo, &p->hi) == 2) { p->kind = P_RANGE; return 0; }
+    int k;
+    if(sscanf(s, "div:%d", &k) == 1 && k > 0) {
+        /* n % k == 0  <=>  |n| has k's trailing zeros and |n| * inv(odd) <= limit */
+        uint32_t odd = (uint32_t)k, shift = 0;
+        while((odd & 1u) == 0) { odd >>= 1; shift++; }
+        uint32_t inv = odd;                 /* Newton iteration for the inverse mod 2^32 */
+        for(int i = 0; i < 5; i++) inv *= 2u - odd * inv;
+        p->kind = P_DIV;
+        p->div_inv = inv;
+        p->div_limit = UINT32_MAX / odd;
+        p->div_low_mask = (shift >= 32) ? UINT32_MAX : ((1u << shift) - 1u);
+        return 0;
+    }
+    return -1;
+}
+
+/* Scalar kernel: one bit per value into bits[] (n is a multiple of 64) */
+static void eval_scalar(const Predicate* p, const int32_t* v, int n, uint64_t* bits) {
+    for(int w = 0; w < n / 64; w++) {
+        uint64_t word = 0;
+        for(int i = 0; i < 64; i++) {
+            int32_t x = v[w * 64 + i];
+            uint32_t ax = x < 0 ? 0u - (uint32_t)x : (uint32_t)x;
+            int hit;
+            switch(p->kind) {
+            case P_EVEN: hit = (x & 1) == 0; break;
+            case P_ODD: hit = (x & 1) != 0; break;
+            case P_NEG: hit = x < 0; break;
+            case P_POS: hit = x > 0; break;
+            case P_ZERO: hit = x == 0; break;
+            case P_RANGE: hit = p->lo <= p->hi && (uint32_t)x - (uint32_t)p->lo <= (uint32_t)p->hi - (uint32_t)p->lo; break;
+            default: hit = (ax & p->div_low_mask) == 0 && (ax * p->div_inv) <= p->div_limit; break;
+            }
+            word |= (uint64_t)hit << i;
+        }
+        bits[w] = word;
+    }
+}
+
+#if CD_X86
+/* AVX2 kernel: 8 compares per instruction, movemask packs them into bits */
+CD_TARGET_AVX2 static void eval_avx2(const Predicate* p, const int32_t* v, int n, uint64_t* bits) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+    const __m256i lo = _mm256_set1_epi32(p->lo);
+    const __m256i span = _mm256_set1_epi32((int)(((uint32_t)p->hi - (uint32_t)p->lo) ^ 0x80000000u));
+    const __m256i inv = _mm256_set1_epi32((int)p->div_inv);
+    const __m256i limit = _mm256_set1_epi32((int)(p->div_limit ^ 0x80000000u));
+    const __m256i low = _mm256_set1_epi32((int)p->div_low_mask);
+
+    for(int w = 0; w < n / 64; w++) {
+        uint64_t word = 0;
+        for(int j = 0; j < 8; j++) {
+            __m256i x = _mm256_loadu_si256((const __m256i*)(v + w * 64 + j * 8));
+            __m256i m;
+            switch(p->kind) {
+            case P_EVEN: m = _mm256_cmpeq_epi32(_mm256_and_si256(x, one), zero); break;
+            case P_ODD: m = _mm256_cmpeq_epi32(_mm256_and_si256(x, one), one); break;
+            case P_NEG: m = _mm256_cmpgt_epi32(zero, x); break;
+            case P_POS: m = _mm256_cmpgt_epi32(x, zero); break;
+            case P_ZERO: m = _mm256_cmpeq_epi32(x, zero); break;
+            case P_RANGE:
+                /* unsigned (x - lo) <= (hi - lo): one compare for both bounds */
+                m = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_sub_epi32(x, lo), sign), span);
+                m = (p->lo <= p->hi) ? _mm256_xor_si256(m, _mm256_set1_epi32(-1)) : zero;
+                break;
+            default: {
+                __m256i ax = _mm256_abs_epi32(x);
+                __m256i prod = _mm256_mullo_epi32(ax, inv);
+                /* unsigned prod <= limit  via signed compare on sign-flipped values */
+                __m256i le = _mm256_xor_si256(_mm256_cmpgt_epi32(_mm256_xor_si256(prod, sign), limit),
+                                              _mm256_set1_epi32(-1));
+                m = _mm256_and_si256(le, _mm256_cmpeq_epi32(_mm256_and_si256(ax, low), zero));
+                break;
+            }
+            }
+            uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(m));
+            word |= (uint64_t)mask << (j * 8);
+        }
+        bits[w] = word;
+    }
+}
+#endif
+
+/* Bound in main() from the CPU features */
+static void (*eval_block)(const Predicate* p, const int32_t* v, int n, uint64_t* bits) = eval_scalar;
+
+/* Returns -1 (and flags the slice) when out of memory */
+static int slice_select(Slice* s, int32_t x) {
+    if(s->sel_len == s->sel_cap) {
+        size_t ncap = s->sel_cap ? s->sel_cap * 2 : 4096;
+        int32_t* ns = realloc(s->selected, ncap * sizeof(int32_t));
+        if(!ns) {
+            s->oom = 1;
+            return -1;
+        }
+        s->selected = ns;
+        s->sel_cap = ncap;
+    }
+    s->selected[s->sel_len++] = x;
+    return 0;
+}
+
+/* Classify n values (n <= BLOCK); the tail of v is padded up to 64 */
+static void classify_block(Slice* s, int32_t* v, int n) {
+    uint64_t bits[MAX_PREDS][BLOCK_WORDS];
+    uint64_t all[BLOCK_WORDS];
+    int padded = (n + 63) & ~63;
+    for(int i = n; i < padded; i++) v[i] = 0;
+    int words = padded / 64;
+    uint64_t tail = (n % 64) ? ((1ull << (n % 64)) - 1) : ~0ull;
+
+    for(int w = 0; w < words; w++) all[w] = ~0ull;
+    all[words - 1] = tail;
+    for(int k = 0; k < num_preds; k++) {
+        eval_block(&preds[k], v, padded, bits[k]);
+        bits[k][words - 1] &= tail;
+        for(int w = 0; w < words; w++) {
+            s->counts[k] += (uint64_t)__builtin_popcountll(bits[k][w]);
+            all[w] &= bits[k][w];
+        }
+    }
+    for(int w = 0; w < words; w++) {
+        s->all_count += (uint64_t)__builtin_popcountll(all[w]);
+        if(!print_selected) continue;
+        for(uint64_t m = all[w]; m && !s->oom; m &= m - 1) slice_select(s, v[w * 64 + __builtin_ctzll(m)]);
+    }
+    s->total += (uint64_t)n;
+}
+
+static void* classify_slice(void* arg) {
+    Slice* s = (Slice*)arg;
+    int32_t v[BLOCK];
+    int n = 0;
+
+    if(s->bin) {
+        for(size_t i = 0; i < s->bin_len && !s->oom; i++) {
+            v[n++] = s->bin[i];
+            if(n == BLOCK) { classify_block(s, v, n); n = 0; }
+        }
+    } else {
+        /* Hand-rolled decimal parser; anything that is not a digit or '-' separates numbers */
+        const char* p = s->text;
+        const char* end = s->text + s->text_len;
+        while(p < end && !s->oom) {
+            while(p < end && !(*p >= '0' && *p <= '9') && *p != '-') p++;
+            if(p >= end) break;
+            int neg = (*p == '-');
+            p += neg;
+            if(p >= end || *p < '0' || *p > '9') continue;
+            /* Saturates at 2^32, so arbitrarily long digit runs cannot wrap */
+            uint64_t x = 0;
+            while(p < end && *p >= '0' && *p <= '9') {
+                x = x * 10u + (uint64_t)(*p++ - '0');
+                x = x > (1ull << 32) ? (1ull << 32) : x;
+            }
+            if(x > (neg ? 1ull << 31 : (1ull << 31) - 1)) {
+                s->out_of_range++;
+                continue;
+            }
+            v[n++] = (int32_t)(neg ? 0u - (uint32_t)x : (uint32_t)x);
+            if(n == BLOCK) { classify_block(s, v, n); n = 0; }
+        }
+    }
+    if(n > 0 && !s->oom) classify_block(s, v, n);
+    return NULL;
+}
+
+static int is_sep(char c) { return !(c >= '0' && c <= '9') && c != '-'; }
+
+/* Read all of stdin into a heap buffer */
+static char* read_stdin(size_t* len) {
+    size_t cap = 1 << 20, n = 0;
+    char* buf = malloc(cap);
+    while(buf) {
+        if(n == cap) {
+            char* nb = realloc(buf, cap * 2);
+            if(!nb) { free(buf); return NULL; }
+            buf = nb;
+            cap *= 2;
+        }
+        ssize_t r = read(0, buf + n, cap - n);
+        if(r <= 0) break;
+        n += (size_t)r;
+    }
+    *len = n;
+    return buf;
+}
+
+void usage(const char* prog) {
+    printf("usage: %s [-b] [-p] [-s] [-t threads] [file|-] predicate...\n", prog);
+    printf("predicates: even odd neg pos zero range:LO:HI div:K\n");
+}
+
+int main(int argc, char** argv) {
+    int binary = 0, stats = 0;
+    int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char* path = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-b") == 0) binary = 1;
+        else if(strcmp(argv[i], "-p") == 0) print_selected = 1;
+        else if(strcmp(argv[i], "-s") == 0) stats = 1;
+        else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) nthreads = atoi(argv[++i]);
+        else if(num_preds < MAX_PREDS && parse_predicate(argv[i], &preds[num_preds]) == 0) num_preds++;
+        else if(!path) path = argv[i];
+        else { usage(argv[0]); return 1; }
+    }
+    if(num_preds == 0) { usage(argv[0]); return 1; }
+    if(nthreads < 1) nthreads = 1;
+#if CD_X86
+    if(cd_select_isa() >= CD_AVX2) eval_block = eval_avx2;
+#endif
+
+    /* Map the input (or slurp stdin) */
+    char* data = NULL;
+    size_t len = 0;
+    int mapped = 0;
+    if(path && strcmp(path, "-") != 0) {
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if(fd < 0 || fstat(fd, &st) != 0) { perror(path); return 1; }
+        len = (size_t)st.st_size;
+        if(len > 0) {
+            data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data == MAP_FAILED) { perror("mmap"); return 1; }
+            madvise(data, len, MADV_SEQUENTIAL);
+            mapped = 1;
+        }
+        close(fd);
+    } else {
+        data = read_stdin(&len);
+        if(!data) { fprintf(stderr, "out of memory\n"); return 1; }
+    }
+
+    /* Split into per-thread slices on number boundaries */
+    Slice* slices = calloc((size_t)nthreads, sizeof(Slice));
+    pthread_t* tids = malloc(sizeof(pthread_t) * (size_t)nthreads);
+    if(!slices || !tids) { fprintf(stderr, "out of memory\n"); return 1; }
+    if(binary) {
+        size_t count = len / sizeof(int32_t);
+        if(len % sizeof(int32_t))
+            fprintf(stderr, "warning: ignoring %zu trailing bytes (not a whole int32)\n", len % sizeof(int32_t));
+        for(int t = 0; t < nthreads; t++) {
+            size_t a = count * (size_t)t / (size_t)nthreads, b = count * (size_t)(t + 1) / (size_t)nthreads;
+            slices[t].bin = (const int32_t*)data + a;
+            slices[t].bin_len = b - a;
+        }
+    } else {
+        size_t a = 0;
+        for(int t = 0; t < nthreads; t++) {
+            size_t b = (t == nthreads - 1) ? len : len * (size_t)(t + 1) / (size_t)nthreads;
+            if(b < a) b = a;
+            while(b < len && !is_sep(data[b])) b++;
+            slices[t].text = data + a;
+            slices[t].text_len = b - a;
+            a = b;
+        }
+    }
+    PerfCounters pc;
+    PcSample ps;
+    if(stats) {
+        pc_open(&pc);
+        pc_start(&pc, &ps);
+    }
+    for(int t = 0; t < nthreads; t++) {
+        slices[t].threaded = pthread_create(&tids[t], NULL, classify_slice, &slices[t]) == 0;
+        if(!slices[t].threaded) classify_slice(&slices[t]);
+    }
+    for(int t = 0; t < nthreads; t++)
+        if(slices[t].threaded) pthread_join(tids[t], NULL);
+    if(stats) pc_stop(&pc, &ps);
+
+    uint64_t total = 0, all = 0, out_of_range = 0, counts[MAX_PREDS] = {0};
+    int oom = 0;
+    for(int t = 0; t < nthreads; t++) {
+        total += slices[t].total;
+        all += slices[t].all_count;
+        out_of_range += slices[t].out_of_range;
+        oom |= slices[t].oom;
+        for(int k = 0; k < num_preds; k++) counts[k] += slices[t].counts[k];
+    }
+    if(oom) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    if(out_of_range)
+        fprintf(stderr, "warning: skipped %llu numbers outside the int32 range\n", (unsigned long long)out_of_range);
+
+    if(print_selected) {
+        FastOut out;
+        if(fo_open(&out, 1) == 0) {
+            for(int t = 0; t < nthreads; t++) {
+                for(size_t i = 0; i < slices[t].sel_len; i++) {
+                    fo_int(&out, slices[t].selected[i]);
+                    fo_putc(&out, '\n');
+                }
+            }
+            fo_close(&out);
+        }
+    }
+
+    fprintf(print_selected ? stderr : stdout, "Total: %llu\n", (unsigned long long)total);
+    for(int k = 0; k < num_preds; k++) {
+        fprintf(print_selected ? stderr : stdout, "%-16s %llu\n", preds[k].label, (unsigned long long)counts[k]);
+    }
+    if(num_preds > 1) fprintf(print_selected ? stderr : stdout, "%-16s %llu\n", "all", (unsigned long long)all);
+    if(stats) {
+        fprintf(stderr, "\n");
+        pc_print_status(stderr, &pc);
+        pc_print_header(stderr, 12);
+        pc_print_row(stderr, 12, eval_block == eval_scalar ? "scalar" : "avx2", &ps, (double)total);
+        pc_close(&pc);
+    }
+
+    for(int t = 0; t < nthreads; t++) free(slices[t].selected);
+    free(slices);
+    free(tids);
+    if(mapped) munmap(data, len);
+    else free(data);
+    return 0;
+}
@@ -0,0 +1,484 @@
+/*
+ campaign_sim.c
+ Discrete-event simulator for multi-mission launch campaigns
+
+ Overview:
+  - Simulates a multi-year manifest flown from a small set of pads:
+    * pad turnaround and vehicle availability (fleet size and refurbish
+      time per rocket type)
+    * LEO tanker flights for refuelled missions (tankers per mission come
+      from evaluate_mission() in mission_core.h)
+    * launch windows from each body's epoch and synodic period; a window
+      missed before the main launch pushes the mission to the next one
+    * weather / technical scrubs; a flight scrubbed past the close of its
+      window stands down and the mission retries at the next window
+  - Events live in a pairing heap whose nodes come from a pooled free
+    list, so a run performs no allocation after start-up.
+  - Monte Carlo: many campaigns with different random seeds; the summary
+    reports mean and spread of completed missions, launches and end date.
+
+ Usage: campaign_sim [missions] [years] [pads] [runs] [seed]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "mission_core.h"
+
+#define CAMPAIGN_START "2026-01-01"
+#define PAD_TURNAROUND_DAYS 4.0
+#define SCRUB_PROBABILITY 0.15
+#define MAX_WINDOW_DAYS 20.0        /* window length cap; short synodic periods get 20% */
+#define MAX_PADS 64
+#define MAX_ATTEMPTS 12              /* windows tried before a mission is dropped */
+#define TANKER_LEAD_DAYS 30.0       /* tankers may fly this long before a window opens */
+#define ROCKET_TYPES (sizeof(rockets) / sizeof(rockets[0]))
+
+/* Per rocket type: vehicles available and days between flights of one
+   vehicle (refurbishment for reusable stacks, build cadence otherwise) */
+static const int fleet_size[] = {10, 1, 4, 3};
+static const double vehicle_turnaround[] = {7.0, 180.0, 30.0, 45.0};
+_Static_assert(sizeof(fleet_size) / sizeof(fleet_size[0]) == ROCKET_TYPES,
+               "fleet_size[] needs one entry per catalog rocket");
+_Static_assert(sizeof(vehicle_turnaround) / sizeof(vehicle_turnaround[0]) == ROCKET_TYPES,
+               "vehicle_turnaround[] needs one entry per catalog rocket");
+
+typedef enum {
+    EV_MISSION_READY,   /* payload delivered to the launch site */
+    EV_CAMPAIGN_OPEN,   /* tanker flights for a window may start */
+    EV_WINDOW_OPEN,     /* main launch may start */
+    EV_WINDOW_CLOSE,
+    EV_LAUNCH,          /* a flight lifts off (tanker or main) */
+    EV_PAD_FREE,
+    EV_VEHICLE_FREE
+} EventType;
+
+typedef struct Event {
+    double t;           /* days since campaign start */
+    EventType type;
+    int mission;
+    int arg;            /* pad index / rocket type / 1 for tanker flights */
+    struct Event* child;
+    struct Event* sibling;
+} Event;
+
+/* ---------------------------------------------------------------------- */
+/* Pooled pairing heap                                                     */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    Event* root;
+    Event* free_list;
+    Event* slab;
+    size_t slab_size;
+    size_t count;
+    long processed;
+} EventQueue;
+
+int eq_init(EventQueue* q, size_t capacity) {
+    memset(q, 0, sizeof(*q));
+    q->slab = malloc(sizeof(Event) * capacity);
+    if(!q->slab) return -1;
+    q->slab_size = capacity;
+    for(size_t i = 0; i < capacity; i++) {
+        q->slab[i].sibling = (i + 1 < capacity) ? &q->slab[i + 1] : NULL;
+    }
+    q->free_list = q->slab;
+    return 0;
+}
+
+/* Return every node to the free list without touching the slab size */
+void eq_reset(EventQueue* q) {
+    for(size_t i = 0; i < q->slab_size; i++) {
+        q->slab[i].sibling = (i + 1 < q->slab_size) ? &q->slab[i + 1] : NULL;
+    }
+    q->free_list = q->slab;
+    q->root = NULL;
+    q->count = 0;
+    q->processed = 0;
+}
+
+static Event* eq_meld(Event* a, Event* b) {
+    if(!a) return b;
+    if(!b) return a;
+    if(b->t < a->t) { Event* t = a; a = b; b = t; }
+    b->sibling = a->child;
+    a->child = b;
+    return a;
+}
+
+/* Schedule an event. Returns -1 if the pool is exhausted. */
+int eq_push(EventQueue* q, double t, EventType type, int mission, int arg) {
+    Event* e = q->free_list;
+    if(!e) return -1;
+    q->free_list = e->sibling;
+    e->t = t;
+    e->type = type;
+    e->mission = mission;
+    e->arg = arg;
+    e->child = NULL;
+    e->sibling = NULL;
+    q->root = eq_meld(q->root, e);
+    q->count++;
+    return 0;
+}
+
+/* Two-pass pairing of the root's children */
+static Event* eq_merge_pairs(Event* first) {
+    Event* merged = NULL;
+    /* Pass 1: meld pairs left to right, pushing results onto a stack */
+    while(first) {
+        Event* a = first;
+        Event* b = a->sibling;
+        first = b ? b->sibling : NULL;
+        a->sibling = NULL;
+        if(b) b->sibling = NULL;
+        Event* m = eq_meld(a, b);
+        m->sibling = merged;
+        merged = m;
+    }
+    /* Pass 2: meld the stack right to left */
+    Event* result = NULL;
+    while(merged) {
+        Event* next = merged->sibling;
+        merged->sibling = NULL;
+        result = eq_meld(result, merged);
+        merged = next;
+    }
+    return result;
+}
+
+/* Pop the earliest event into *out. Returns 0 if the queue is empty. */
+int eq_pop(EventQueue* q, Event* out) {
+    Event* r = q->root;
+    if(!r) return 0;
+    *out = *r;
+    q->root = eq_merge_pairs(r->child);
+    r->sibling = q->free_list;
+    q->free_list = r;
+    q->count--;
+    q->processed++;
+    return 1;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Campaign model                                                          */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    int rocket;
+    int body;
+    double ready_day;
+    int tankers;            /* tanker flights needed per attempt */
+    int tankers_flown;      /* for the current window */
+    int ready;
+    int window_open;        /* a window campaign (tankers or main) is active */
+    int window;             /* index of the current (or last) window campaign */
+    double main_from;       /* earliest day for the main launch */
+    int waiting;            /* has a launch request queued */
+    int in_flight;          /* a flight of this mission is scheduled to lift off */
+    int done;
+    int attempts;           /* windows missed so far */
+    double launch_day;
+} CampaignMission;
+
+typedef struct {
+    unsigned rng;
+    double pad_free_at[MAX_PADS];
+    int pads;
+    int vehicles_free[ROCKET_TYPES];
+    CampaignMission* missions;
+    int num_missions;
+    int* queue[ROCKET_TYPES];   /* per rocket type FIFO of missions waiting for a pad/vehicle */
+    int q_head[ROCKET_TYPES], q_len[ROCKET_TYPES];
+    long launches, tanker_flights, scrubs, missed_windows, dropped, stood_down;
+    int completed;
+    double last_launch;
+} Campaign;
+
+/* The pool is sized for the manifest up front; running out means the
+   statistics would silently lose events, so stop instead */
+static void schedule(EventQueue* q, double t, EventType type, int mission, int arg) {
+    if(eq_push(q, t, type, mission, arg) != 0) {
+        fprintf(stderr, "campaign_sim: event pool exhausted (%zu events)\n", q->slab_size);
+        exit(1);
+    }
+}
+
+/* EV_LAUNCH arg: pad, tanker flag and the window the flight belongs to */
+#define LAUNCH_ARG(window, pad, tanker) (((window) * MAX_PADS + (pad)) * 2 + (tanker))
+
+static double urand(unsigned* s) {
+    *s = *s * 1664525u + 1013904223u;
+    return (*s >> 8) / 16777216.0;
+}
+
+/* First window of each body on or after the campaign start (days) */
+double first_window[64];
+
+void build_window_calendar() {
+    time_t start = parse_date(CAMPAIGN_START);
+    for(int b = 0; b < NUM_BODIES && b < 64; b++) {
+        double offset = difftime(parse_date(bodies[b].epoch_date), start) / 86400.0;
+        double syn = bodies[b].synodic_days;
+        first_window[b] = offset - floor(offset / syn) * syn;
+    }
+}
+
+/* Days from campaign start to the k-th window of a body */
+static double window_open_day(int body, int k) {
+    return first_window[body] + k * bodies[body].synodic_days;
+}
+
+static double window_length(int body) {
+    double len = 0.2 * bodies[body].synodic_days;
+    return len < MAX_WINDOW_DAYS ? len : MAX_WINDOW_DAYS;
+}
+
+/* Next window index that opens at or after day t, or whose open period covers t */
+static int next_window(int body, double t) {
+    double syn = bodies[body].synodic_days;
+    double first = window_open_day(body, 0);
+    int k = (int)floor((t - first) / syn);
+    if(k < 0) k = 0;
+    while(window_open_day(body, k) + window_length(body) <= t) k++;
+    return k;
+}
+
+static void enqueue_request(Campaign* c, int mission) {
+    CampaignMission* m = &c->missions[mission];
+    if(m->waiting || m->in_flight || m->done) return;
+    m->waiting = 1;
+    int r = m->rocket;
+    c->queue[r][(c->q_head[r] + c->q_len[r]) % c->num_missions] = mission;
+    c->q_len[r]++;
+}
+
+static int free_pad(const Campaign* c, double now) {
+    for(int p = 0; p < c->pads; p++) if(c->pad_free_at[p] <= now) return p;
+    return -1;
+}
+
+/* Start every queued flight that has a pad and a vehicle now. Only rocket
+   types with a free vehicle are scanned, and scanning stops once the pads
+   are taken, so a long backlog costs nothing while resources are busy. */
+static void dispatch(Campaign* c, EventQueue* q, double now) {
+    for(int r = 0; r < NUM_ROCKETS; r++) {
+        int n = c->q_len[r];
+        for(int i = 0; i < n && c->vehicles_free[r] > 0; i++) {
+            int pad = free_pad(c, now);
+            if(pad < 0) return;
+            int mi = c->queue[r][c->q_head[r]];
+            c->q_head[r] = (c->q_head[r] + 1) % c->num_missions;
+            c->q_len[r]--;
+            CampaignMission* m = &c->missions[mi];
+            m->waiting = 0;
+            if(m->done || !m->window_open) continue;
+
+            int tanker = m->tankers_flown < m->tankers;
+            if(!tanker && now < m->main_from) continue;     /* EV_WINDOW_OPEN re-queues it */
+            c->vehicles_free[r]--;
+            m->in_flight = 1;
+            c->pad_free_at[pad] = INFINITY;
+            double delay = 0.0;
+            while(urand(&c->rng) < SCRUB_PROBABILITY) { delay += 1.0 + 2.0 * urand(&c->rng); c->scrubs++; }
+            schedule(q, now + delay, EV_LAUNCH, mi, LAUNCH_ARG(m->window, pad, tanker));
+        }
+    }
+}
+
+/* Schedule the campaign for window k: tankers may start TANKER_LEAD_DAYS early */
+static void schedule_window(EventQueue* q, const CampaignMission* m, int mission, int k, double now) {
+    double open = window_open_day(m->body, k);
+    double start = m->tankers > 0 ? open - TANKER_LEAD_DAYS : open;
+    schedule(q, start > now ? start : now, EV_CAMPAIGN_OPEN, mission, k);
+    schedule(q, open > now ? open : now, EV_WINDOW_OPEN, mission, k);
+}
+
+/* Run one campaign. Returns the number of events processed. */
+long run_campaign(Campaign* c, EventQueue* q, unsigned seed) {
+    eq_reset(q);
+    c->rng = seed;
+    memset(c->q_head, 0, sizeof(c->q_head));
+    memset(c->q_len, 0, sizeof(c->q_len));
+    c->launches = c->tanker_flights = c->scrubs = c->missed_windows = c->dropped = c->stood_down = 0;
+    c->completed = 0;
+    c->last_launch = 0.0;
+    for(int p = 0; p < c->pads; p++) c->pad_free_at[p] = 0.0;
+    for(int r = 0; r < NUM_ROCKETS; r++) c->vehicles_free[r] = fleet_size[r];
+    for(int i = 0; i < c->num_missions; i++) {
+        CampaignMission* m = &c->missions[i];
+        m->tankers_flown = m->attempts = 0;
+        m->ready = m->window_open = m->waiting = m->in_flight = m->done = 0;
+        schedule(q, m->ready_day, EV_MISSION_READY, i, 0);
+    }
+
+    Event e;
+    while(eq_pop(q, &e)) {
+        CampaignMission* m = &c->missions[e.mission];
+        switch(e.type) {
+        case EV_MISSION_READY:
+            m->ready = 1;
+            schedule_window(q, m, e.mission, next_window(m->body, e.t), e.t);
+            break;
+        case EV_CAMPAIGN_OPEN:
+            m->window_open = 1;
+            m->window = e.arg;
+            m->tankers_flown = 0;
+            m->main_from = window_open_day(m->body, e.arg);
+            schedule(q, window_open_day(m->body, e.arg) + window_length(m->body), EV_WINDOW_CLOSE, e.mission, e.arg);
+            enqueue_request(c, e.mission);
+            dispatch(c, q, e.t);
+            break;
+        case EV_WINDOW_OPEN:
+            enqueue_request(c, e.mission);
+            dispatch(c, q, e.t);
+            break;
+        case EV_WINDOW_CLOSE:
+            if(m->done || !m->window_open) break;
+            /* Missed: propellant loaded by tankers is lost, retry next window */
+            m->window_open = 0;
+            c->missed_windows++;
+            if(++m->attempts >= MAX_ATTEMPTS) { c->dropped++; break; }
+            schedule_window(q, m, e.mission, e.arg + 1, e.t);
+            break;
+        case EV_LAUNCH: {
+            int pad = (e.arg / 2) % MAX_PADS, tanker = e.arg & 1, window = e.arg / 2 / MAX_PADS;
+            m->in_flight = 0;
+            if(!m->window_open || window != m->window) {
+                /* Scrubbed past the close of its window (already counted as
+                   missed): stand down, pad and vehicle are free at once */
+                c->stood_down++;
+                c->pad_free_at[pad] = e.t;
+                c->vehicles_free[m->rocket]++;
+                if(!m->done && m->window_open) enqueue_request(c, e.mission);
+                dispatch(c, q, e.t);
+                break;
+            }
+            c->launches++;
+            c->last_launch = e.t;
+            if(tanker) {
+                c->tanker_flights++;
+                m->tankers_flown++;
+            } else {
+                m->done = 1;
+                m->launch_day = e.t;
+                c->completed++;
+            }
+            schedule(q, e.t + PAD_TURNAROUND_DAYS * (0.8 + 0.4 * urand(&c->rng)), EV_PAD_FREE, e.mission, pad);
+            schedule(q, e.t + vehicle_turnaround[m->rocket] * (0.8 + 0.4 * urand(&c->rng)), EV_VEHICLE_FREE, e.mission,
+                     m->rocket);
+            if(!m->done && m->window_open) enqueue_request(c, e.mission);
+            break;
+        }
+        case EV_PAD_FREE:
+            c->pad_free_at[e.arg] = e.t;
+            dispatch(c, q, e.t);
+            break;
+        case EV_VEHICLE_FREE:
+            c->vehicles_free[e.arg]++;
+            dispatch(c, q, e.t);
+            break;
+        }
+    }
+    return q->processed;
+}
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    int num = argc > 1 ? atoi(argv[1]) : 100;
+    double years = argc > 2 ? atof(argv[2]) : 5.0;
+    int pads = argc > 3 ? atoi(argv[3]) : 3;
+    int runs = argc > 4 ? atoi(argv[4]) : 1000;
+    unsigned seed = argc > 5 ? (unsigned)atoi(argv[5]) : 2026;
+    if(num < 1) num = 1;
+    if(pads < 1) pads = 1;
+    if(pads > MAX_PADS) pads = MAX_PADS;
+    if(runs < 1) runs = 1;
+
+    build_window_calendar();
+
+    /* Random manifest of feasible missions; rocket types are drawn in
+       proportion to the flight rate their fleet can sustain */
+    double rate_sum = 0.0;
+    for(int r = 0; r < NUM_ROCKETS; r++) rate_sum += fleet_size[r] / vehicle_turnaround[r];
+    Campaign c;
+    memset(&c, 0, sizeof(c));
+    c.pads = pads;
+    c.missions = calloc((size_t)num, sizeof(CampaignMission));
+    if(!c.missions) { printf("out of memory\n"); return 1; }
+    for(int r = 0; r < NUM_ROCKETS; r++) {
+        c.queue[r] = malloc(sizeof(int) * (size_t)num);
+        if(!c.queue[r]) { printf("out of memory\n"); return 1; }
+    }
+    unsigned rng = seed;
+    int skipped = 0, total_tankers = 0;
+    for(int tries = 0; c.num_missions < num && tries < num * 50; tries++) {
+        Mission m;
+        MissionResult res;
+        memset(&m, 0, sizeof(m));
+        double pick = urand(&rng) * rate_sum;
+        int r = 0;
+        while(r < NUM_ROCKETS - 1 && (pick -= fleet_size[r] / vehicle_turnaround[r]) > 0) r++;
+        int b = (int)(urand(&rng) * NUM_BODIES);
+        m.rocket = rockets[r];
+        m.body = bodies[b];
+        m.payload_kg = rockets[r].payload_leo_kg * (0.05 + 0.6 * urand(&rng));
+        if(!evaluate_mission(&m, &res)) { skipped++; continue; }
+        CampaignMission* cm = &c.missions[c.num_missions++];
+        cm->rocket = r;
+        cm->body = b;
+        cm->ready_day = urand(&rng) * years * 365.25;
+        cm->tankers = res.tankers;
+        total_tankers += res.tankers;
+    }
+
+    /* Each mission has at most a few live events, plus tanker/pad/vehicle events */
+    EventQueue q;
+    if(eq_init(&q, (size_t)c.num_missions * 8 + (size_t)pads * 4 + 64) != 0) { printf("out of memory\n"); return 1; }
+
+    printf("\n--- LAUNCH CAMPAIGN SIMULATION ---\n");
+    printf(" Manifest: %d missions over %.1f years (%d infeasible draws skipped, %d tanker flights/attempt)\n",
+           c.num_missions, years, skipped, total_tankers);
+    printf(" Pads: %d | Runs: %d\n", pads, runs);
+
+    double sum_done = 0, sum_done2 = 0, sum_end = 0, sum_launch = 0, sum_missed = 0, sum_scrub = 0, sum_drop = 0;
+    double sum_stand = 0;
+    long events = 0;
+    double t0 = now_sec();
+    for(int r = 0; r < runs; r++) {
+        events += run_campaign(&c, &q, seed * 7919u + (unsigned)r);
+        sum_done += c.completed;
+        sum_done2 += (double)c.completed * c.completed;
+        sum_end += c.last_launch;
+        sum_launch += c.launches;
+        sum_missed += c.missed_windows;
+        sum_scrub += c.scrubs;
+        sum_drop += c.dropped;
+        sum_stand += c.stood_down;
+    }
+    double el = now_sec() - t0;
+    double mean_done = sum_done / runs;
+    double sd_done = sqrt(fmax(sum_done2 / runs - mean_done * mean_done, 0.0));
+
+    char end_str[DATE_STRLEN];
+    format_date(parse_date(CAMPAIGN_START) + (time_t)(sum_end / runs * 86400.0), end_str);
+    printf(" Missions flown:      %.1f +/- %.1f of %d\n", mean_done, sd_done, c.num_missions);
+    printf(" Launches per run:    %.1f (incl. tankers)\n", sum_launch / runs);
+    printf(" Missed windows:      %.1f | Scrubs: %.1f | Stood down: %.1f | Dropped after %d windows: %.1f\n",
+           sum_missed / runs, sum_scrub / runs, sum_stand / runs, MAX_ATTEMPTS, sum_drop / runs);
+    printf(" Mean last launch:    %s\n", end_str);
+    printf(" Events: %ld in %.3f s (%.1f M events/s)\n", events, el, el > 0 ? events / el / 1e6 : 0.0);
+
+    free(q.slab);
+    free(c.missions);
+    for(int r = 0; r < NUM_ROCKETS; r++) free(c.queue[r]);
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ catalog_rcu.h
+ Hot-reloadable rocket/body catalogs for resident planners
+
+ Overview:
+  - A Catalog is an immutable snapshot (rockets, bodies, version) in one
+    allocation. Readers never see it change; edits publish a new snapshot.
+  - CatalogRcu holds the current snapshot behind an atomic pointer:
+    * readers bracket their work with rcu_read_lock()/rcu_read_unlock(),
+      which announce the global epoch in the reader's own cache line and
+      load the pointer; no locks or shared writes on the read path
+    * rcu_publish() swaps in a new snapshot, tags the old one with the
+      current epoch and advances the epoch
+    * a retired snapshot is freed once every reader is either outside a
+      read section or announced a later epoch, i.e. can no longer hold it
+    * retired snapshots are linked through the Catalog itself, so
+      publishing never allocates and cannot fail
+    * rcu_reclaimed() tells whether a version has been freed without
+      touching the snapshot, for debug checks in readers
+  - Caches derived from a catalog (pair constants, memoized evaluations)
+    store the version they were built from in an RcuTag; rcu_tag_stale()
+    tells the owner to flush them when a newer snapshot shows up.
+  - catalog_load()/catalog_save() read and write a plain text catalog:
+      R;name;wet_kg;dry_kg;isp;leo_kg;staging;refuel_dv
+      B;name;dv_transfer;dv_capture;synodic_days;epoch;transit_days
+    with '#' comment lines.
+*/
+
+#ifndef CATALOG_RCU_H
+#define CATALOG_RCU_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "mission_core.h"
+
+#define RCU_MAX_READERS 64
+#define RCU_CACHE_LINE 64
+
+typedef struct Catalog {
+    uint64_t version;
+    int nrockets, nbodies;
+    Rocket* rockets;
+    Body* bodies;
+    struct Catalog* retired_next;   /* retirement list, writer lock held */
+    uint64_t retired_epoch;
+} Catalog;
+
+/* One snapshot: header and both arrays in a single block */
+static inline Catalog* catalog_new(const Rocket* r, int nr, const Body* b, int nb) {
+    Catalog* c = (Catalog*)malloc(sizeof(Catalog) + sizeof(Rocket) * (size_t)nr + sizeof(Body) * (size_t)nb);
+    if(!c) return NULL;
+    c->version = 0;
+    c->retired_next = NULL;
+    c->retired_epoch = 0;
+    c->nrockets = nr;
+    c->nbodies = nb;
+    c->rockets = (Rocket*)(c + 1);
+    c->bodies = (Body*)(c->rockets + nr);
+    if(nr) memcpy(c->rockets, r, sizeof(Rocket) * (size_t)nr);
+    if(nb) memcpy(c->bodies, b, sizeof(Body) * (size_t)nb);
+    return c;
+}
+
+static inline Catalog* catalog_copy(const Catalog* c) {
+    return catalog_new(c->rockets, c->nrockets, c->bodies, c->nbodies);
+}
+
+static inline void catalog_free(Catalog* c) {
+    free(c);
+}
+
+static inline int catalog_find_rocket(const Catalog* c, const char* name) {
+    for(int i = 0; i < c->nrockets; i++)
+        if(strcmp(c->rockets[i].name, name) == 0) return i;
+    return -1;
+}
+
+static inline int catalog_find_body(const Catalog* c, const char* name) {
+    for(int i = 0; i < c->nbodies; i++)
+        if(strcmp(c->bodies[i].name, name) == 0) return i;
+    return -1;
+}
+
+/* Parse a text catalog. Returns NULL (and prints the line) on error or when
+   out of memory. */
+static inline Catalog* catalog_load(const char* path) {
+    FILE* f = fopen(path, "r");
+    if(!f) return NULL;
+    int cap_r = 8, cap_b = 8, nr = 0, nb = 0, lineno = 0, bad = 0, oom = 0;
+    Rocket* rs = (Rocket*)malloc(sizeof(Rocket) * (size_t)cap_r);
+    Body* bs = (Body*)malloc(sizeof(Body) * (size_t)cap_b);
+    char line[512];
+    if(!rs || !bs) oom = 1;
+    while(!bad && !oom && fgets(line, sizeof(line), f)) {
+        lineno++;
+        if(line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+        if(line[0] == 'R' && line[1] == ';') {
+            if(nr == cap_r) {
+                Rocket* grown = (Rocket*)realloc(rs, sizeof(Rocket) * (size_t)cap_r * 2);
+                if(!grown) {
+                    oom = 1;
+                    break;
+                }
+                rs = grown;
+                cap_r *= 2;
+            }
+            Rocket* r = &rs[nr];
+            memset(r, 0, sizeof(*r));
+            if(sscanf(line + 2, "%63[^;];%lf;%lf;%lf;%lf;%lf;%lf", r->name, &r->wet_mass_kg, &r->dry_mass_kg,
+                      &r->isp_avg, &r->payload_leo_kg, &r->staging_factor, &r->refuel_dv_per_tanker) == 7) {
+                nr++;
+                continue;
+            }
+        } else if(line[0] == 'B' && line[1] == ';') {
+            if(nb == cap_b) {
+                Body* grown = (Body*)realloc(bs, sizeof(Body) * (size_t)cap_b * 2);
+                if(!grown) {
+                    oom = 1;
+                    break;
+                }
+                bs = grown;
+                cap_b *= 2;
+            }
+            Body* b = &bs[nb];
+            memset(b, 0, sizeof(*b));
+            if(sscanf(line + 2, "%63[^;];%lf;%lf;%lf;%19[^;];%lf", b->name, &b->dv_transfer, &b->dv_capture,
+                      &b->synodic_days, b->epoch_date, &b->typical_transit_days) == 6) {
+                nb++;
+                continue;
+            }
+        }
+        fprintf(stderr, "%s:%d: cannot parse catalog line\n", path, lineno);
+        bad = 1;
+    }
+    fclose(f);
+    if(oom) fprintf(stderr, "%s: out of memory\n", path);
+    Catalog* c = (bad || oom || nr == 0 || nb == 0) ? NULL : catalog_new(rs, nr, bs, nb);
+    free(rs);
+    free(bs);
+    return c;
+}
+
+static inline int catalog_save(const Catalog* c, const char* path) {
+    FILE* f = fopen(path, "w");
+    if(!f) return -1;
+    fprintf(f, "# R;name;wet_kg;dry_kg;isp;leo_kg;staging;refuel_dv\n");
+    for(int i = 0; i < c->nrockets; i++) {
+        const Rocket* r = &c->rockets[i];
+        fprintf(f, "R;%s;%.15g;%.15g;%.15g;%.15g;%.15g;%.15g\n", r->name, r->wet_mass_kg, r->dry_mass_kg, r->isp_avg,
+                r->payload_leo_kg, r->staging_factor, r->refuel_dv_per_tanker);
+    }
+    fprintf(f, "# B;name;dv_transfer;dv_capture;synodic_days;epoch;transit_days\n");
+    for(int i = 0; i < c->nbodies; i++) {
+        const Body* b = &c->bodies[i];
+        fprintf(f, "B;%s;%.15g;%.15g;%.15g;%s;%.15g\n", b->name, b->dv_transfer, b->dv_capture, b->synodic_days,
+                b->epoch_date, b->typical_transit_days);
+    }
+    return fclose(f);
+}
+
+/* ---------------------------------------------------------------------- */
+/* RCU publication and epoch reclamation                                   */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    uint64_t epoch;         /* 0 outside a read section */
+    int used;
+    char pad[RCU_CACHE_LINE - sizeof(uint64_t) - sizeof(int)];
+} RcuReader;
+
+typedef struct {
+    Catalog* current;
+    char pad0[RCU_CACHE_LINE];
+    uint64_t epoch;         /* starts at 1 so 0 can mean "not reading" */
+    char pad1[RCU_CACHE_LINE];
+    RcuReader readers[RCU_MAX_READERS];
+    pthread_mutex_t writer_lock;
+    Catalog* retired;
+    uint64_t reclaimed;     /* highest version freed so far */
+    size_t published, freed, pending;
+} CatalogRcu;
+
+static inline void rcu_init(CatalogRcu* rcu, Catalog* initial) {
+    memset(rcu, 0, sizeof(*rcu));
+    initial->version = 1;
+    rcu->current = initial;
+    rcu->epoch = 1;
+    pthread_mutex_init(&rcu->writer_lock, NULL);
+}
+
+/* Claim a reader slot for the calling thread; -1 if all are taken */
+static inline int rcu_register(CatalogRcu* rcu) {
+    for(int i = 0; i < RCU_MAX_READERS; i++) {
+        int expected = 0;
+        if(__atomic_compare_exchange_n(&rcu->readers[i].used, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            return i;
+    }
+    return -1;
+}
+
+static inline void rcu_unregister(CatalogRcu* rcu, int slot) {
+    __atomic_store_n(&rcu->readers[slot].epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&rcu->readers[slot].used, 0, __ATOMIC_RELEASE);
+}
+
+/* The snapshot stays valid until the matching rcu_read_unlock() */
+static inline const Catalog* rcu_read_lock(CatalogRcu* rcu, int slot) {
+    uint64_t e = __atomic_load_n(&rcu->epoch, __ATOMIC_ACQUIRE);
+    /* seq_cst store: the announcement must be visible before the pointer load */
+    __atomic_store_n(&rcu->readers[slot].epoch, e, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&rcu->current, __ATOMIC_SEQ_CST);
+}
+
+static inline void rcu_read_unlock(CatalogRcu* rcu, int slot) {
+    __atomic_store_n(&rcu->readers[slot].epoch, 0, __ATOMIC_RELEASE);
+}
+
+/* Free retired snapshots no reader can still hold; writer lock held.
+   Versions and retirement epochs rise together, so the freed snapshots are
+   always the oldest versions and one watermark records them all. */
+static inline void rcu_reclaim_locked(CatalogRcu* rcu) {
+    uint64_t oldest = UINT64_MAX;
+    for(int i = 0; i < RCU_MAX_READERS; i++) {
+        uint64_t e = __atomic_load_n(&rcu->readers[i].epoch, __ATOMIC_SEQ_CST);
+        if(e != 0 && e < oldest) oldest = e;
+    }
+    Catalog** pp = &rcu->retired;
+    while(*pp) {
+        Catalog* c = *pp;
+        if(c->retired_epoch < oldest) {
+            *pp = c->retired_next;
+            if(c->version > rcu->reclaimed) __atomic_store_n(&rcu->reclaimed, c->version, __ATOMIC_RELEASE);
+            catalog_free(c);
+            rcu->freed++;
+            rcu->pending--;
+        } else {
+            pp = &c->retired_next;
+        }
+    }
+}
+
+/* 1 if the snapshot with this version has been freed; reads only the
+   watermark, so it is safe to call on a snapshot that may be gone */
+static inline int rcu_reclaimed(CatalogRcu* rcu, uint64_t version) {
+    return __atomic_load_n(&rcu->reclaimed, __ATOMIC_ACQUIRE) >= version;
+}
+
+/* Make next the current catalog (takes ownership); returns its version */
+static inline uint64_t rcu_publish(CatalogRcu* rcu, Catalog* next) {
+    pthread_mutex_lock(&rcu->writer_lock);
+    Catalog* old = rcu->current;
+    next->version = old->version + 1;
+    __atomic_store_n(&rcu->current, next, __ATOMIC_SEQ_CST);
+    old->retired_epoch = __atomic_load_n(&rcu->epoch, __ATOMIC_SEQ_CST);
+    old->retired_next = rcu->retired;
+    rcu->retired = old;
+    rcu->pending++;
+    __atomic_store_n(&rcu->epoch, old->retired_epoch + 1, __ATOMIC_SEQ_CST);
+    rcu->published++;
+    rcu_reclaim_locked(rcu);
+    uint64_t v = next->version;
+    pthread_mutex_unlock(&rcu->writer_lock);
+    return v;
+}
+
+static inline void rcu_reclaim(CatalogRcu* rcu) {
+    pthread_mutex_lock(&rcu->writer_lock);
+    rcu_reclaim_locked(rcu);
+    pthread_mutex_unlock(&rcu->writer_lock);
+}
+
+/* Call with no readers left */
+static inline void rcu_destroy(CatalogRcu* rcu) {
+    pthread_mutex_lock(&rcu->writer_lock);
+    rcu_reclaim_locked(rcu);
+    pthread_mutex_unlock(&rcu->writer_lock);
+    catalog_free(rcu->current);
+    rcu->current = NULL;
+    pthread_mutex_destroy(&rcu->writer_lock);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Version tags for derived caches                                         */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    uint64_t version;
+    size_t flushes;
+} RcuTag;
+
+/* Returns 1 (and adopts the new version) if data built for the tagged
+   version must be discarded */
+static inline int rcu_tag_stale(RcuTag* t, const Catalog* c) {
+    if(t->version == c->version) return 0;
+    t->version = c->version;
+    t->flushes++;
+    return 1;
+}
+
+#endif /* CATALOG_RCU_H */
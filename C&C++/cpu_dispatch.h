@@ -0,0 +1,124 @@
+/*
+ cpu_dispatch.h
+ Runtime CPU feature detection and ISA selection for SIMD kernels
+
+ Overview:
+  - cd_features() runs CPUID once (through __builtin_cpu_supports, which
+    also checks that the OS saves the wider registers) and caches the result.
+  - Kernels come in ISA levels, each implying the ones below it:
+      scalar   portable C, no vector instructions assumed
+      sse2     x86-64 baseline
+      avx2     AVX2 + FMA
+      avx512   AVX-512 F/BW/VL (plus AVX2 + FMA)
+  - cd_select_isa() returns the best level this CPU supports, unless the
+    SIMD_FORCE_ISA environment variable names another one (for testing the
+    narrower paths). A forced level above what the CPU supports is refused
+    with a warning rather than crashing on an illegal instruction.
+  - CD_TARGET_* attributes compile single functions for a level, so every
+    variant lives in the same translation unit and the program still runs
+    on the plain x86-64 baseline.
+  - On non-x86 builds everything resolves to scalar.
+*/
+
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum { CD_SCALAR, CD_SSE2, CD_AVX2, CD_AVX512, CD_NUM_ISA } CdIsa;
+
+typedef struct {
+    int sse2, sse42, avx, avx2, fma, avx512f, avx512bw, avx512vl;
+    int detected;
+} CdFeatures;
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CD_X86 1
+#define CD_TARGET_SSE2 __attribute__((target("sse2")))
+#define CD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define CD_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,fma")))
+#else
+#define CD_X86 0
+#define CD_TARGET_SSE2
+#define CD_TARGET_AVX2
+#define CD_TARGET_AVX512
+#endif
+
+static const char* cd_isa_names[CD_NUM_ISA] = {"scalar", "sse2", "avx2", "avx512"};
+
+static inline const char* cd_isa_name(CdIsa isa) {
+    return (isa >= 0 && isa < CD_NUM_ISA) ? cd_isa_names[isa] : "?";
+}
+
+/* -1 if name is not an ISA level */
+static inline int cd_parse_isa(const char* name) {
+    for(int i = 0; i < CD_NUM_ISA; i++)
+        if(strcmp(name, cd_isa_names[i]) == 0) return i;
+    return -1;
+}
+
+static inline const CdFeatures* cd_features() {
+    static CdFeatures f;
+    if(__atomic_load_n(&f.detected, __ATOMIC_ACQUIRE)) return &f;
+    CdFeatures d;
+    memset(&d, 0, sizeof(d));
+#if CD_X86
+    __builtin_cpu_init();
+    d.sse2 = __builtin_cpu_supports("sse2") != 0;
+    d.sse42 = __builtin_cpu_supports("sse4.2") != 0;
+    d.avx = __builtin_cpu_supports("avx") != 0;
+    d.avx2 = __builtin_cpu_supports("avx2") != 0;
+    d.fma = __builtin_cpu_supports("fma") != 0;
+    d.avx512f = __builtin_cpu_supports("avx512f") != 0;
+    d.avx512bw = __builtin_cpu_supports("avx512bw") != 0;
+    d.avx512vl = __builtin_cpu_supports("avx512vl") != 0;
+#endif
+    /* Racing initialisers compute identical values */
+    f = d;
+    __atomic_store_n(&f.detected, 1, __ATOMIC_RELEASE);
+    return &f;
+}
+
+static inline int cd_isa_supported(CdIsa isa) {
+    const CdFeatures* f = cd_features();
+    switch(isa) {
+    case CD_SCALAR: return 1;
+    case CD_SSE2: return f->sse2;
+    case CD_AVX2: return f->avx2 && f->fma;
+    case CD_AVX512: return f->avx512f && f->avx512bw && f->avx512vl && f->avx2 && f->fma;
+    default: return 0;
+    }
+}
+
+static inline CdIsa cd_best_isa() {
+    int isa = CD_NUM_ISA - 1;
+    while(isa > CD_SCALAR && !cd_isa_supported((CdIsa)isa)) isa--;
+    return (CdIsa)isa;
+}
+
+/* Best supported level, or SIMD_FORCE_ISA when set and supported */
+static inline CdIsa cd_select_isa() {
+    CdIsa best = cd_best_isa();
+    const char* force = getenv("SIMD_FORCE_ISA");
+    if(!force || !*force) return best;
+    int isa = cd_parse_isa(force);
+    if(isa < 0) {
+        fprintf(stderr, "SIMD_FORCE_ISA=%s: unknown level, using %s\n", force, cd_isa_name(best));
+        return best;
+    }
+    if(!cd_isa_supported((CdIsa)isa)) {
+        fprintf(stderr, "SIMD_FORCE_ISA=%s: not supported by this CPU, using %s\n", force, cd_isa_name(best));
+        return best;
+    }
+    return (CdIsa)isa;
+}
+
+static inline void cd_print_features(FILE* out) {
+    const CdFeatures* f = cd_features();
+    fprintf(out, "CPU features: sse2=%d sse4.2=%d avx=%d avx2=%d fma=%d avx512f=%d avx512bw=%d avx512vl=%d\n", f->sse2,
+            f->sse42, f->avx, f->avx2, f->fma, f->avx512f, f->avx512bw, f->avx512vl);
+}
+
+#endif /* CPU_DISPATCH_H */
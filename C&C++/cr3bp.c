@@ -0,0 +1,568 @@
+/*
+ cr3bp.c
+ Circular restricted three-body (Earth-Moon) propagation and halo orbits
+
+ Overview:
+  - Nondimensional CR3BP in the rotating frame (unit distance = Earth-Moon
+    distance, unit time = 1/mean motion) with an adaptive Dormand-Prince
+    5(4) integrator, optionally carrying the 6x6 state transition matrix.
+  - Batch propagation of many states across threads with Jacobi-constant
+    drift monitoring.
+  - Single-shooting differential corrector for symmetric halo orbits about
+    L1/L2 (fixed z0, correct x0 and vy0 at the y = 0 crossing).
+  - Family generation: a coarse sequential continuation produces seed
+    orbits, then the fine continuation between consecutive seeds runs in
+    parallel, one seed per thread. Both passes halve the z0 step when the
+    corrector fails and retry from the last converged member. A segment
+    whose thread cannot start is continued on the calling thread.
+  - NRHOs: z0 folds back near 76000 km (L2), so the family is continued
+    past the fold in x0 (correcting z0 and vy0) and the 9:2 synodic-resonant
+    NRHO is located by bisection on the period.
+  - Lunar capture cost from the transfer energy: the Jacobi constant of the
+    TLI state fixes the speed at periselene, so the LOI burn into a circular
+    low lunar orbit is computed instead of assumed (mission_core.h's bodies[]
+    uses a fixed 2.80 km/s). transfer_costs.h derives the Moon's capture the
+    same way, which is what SpaceRockets.c's derived cost table and
+    derive_body() report. No ballistic (low-energy) transfer trajectory is
+    corrected; the capture cost is the direct Hohmann-type TLI's.
+
+ Usage: cr3bp [L1|L2] [z_min_km] [z_max_km] [orbits] [threads]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "transfer_costs.h"
+
+#define MU_EM 0.012150585609624     /* Moon / (Earth + Moon) */
+#define LUNAR_DIST_KM 384400.0
+#define TIME_UNIT_S 375190.0        /* 1 / mean motion of the Moon (s) */
+#define VEL_UNIT_KMS (LUNAR_DIST_KM / TIME_UNIT_S)
+#define GM_EARTH 398600.4418
+#define GM_MOON 4902.800066
+#define R_EARTH_KM 6378.137
+#define R_MOON_KM 1737.4
+
+#define NSTATE 6
+#define NFULL 42                    /* state + 6x6 STM */
+#define RTOL 1e-12
+#define ATOL 1e-13
+#define MAX_CORRECTOR_ITERS 25
+#define CORRECTOR_TOL 1e-11
+#define MAX_STEP_HALVINGS 6         /* continuation step cut at most 64x */
+#define HALO_FIX_Z 0                /* natural parameter z0, correct x0 */
+#define HALO_FIX_X 1                /* natural parameter x0, correct z0 */
+#define NRHO_X_STEP 0.002           /* x0 step walking the family toward the Moon */
+#define SYNODIC_MONTH_D 29.530589
+
+typedef struct {
+    double x0, z0, vy0;     /* symmetric initial state (y = vx = vz = 0) */
+    double period;
+    double jacobi;
+    double stability;       /* (|lambda_max| + 1/|lambda_max|) / 2 */
+    double perilune_km;     /* closest approach to the Moon */
+    int converged;
+} HaloOrbit;
+
+/* Equations of motion; if n == NFULL also the variational equations */
+static void cr3bp_deriv(const double* s, double* ds, int n) {
+    double x = s[0], y = s[1], z = s[2];
+    double mu = MU_EM;
+    double r1x = x + mu, r2x = x - 1.0 + mu;
+    double r1 = sqrt(r1x * r1x + y * y + z * z);
+    double r2 = sqrt(r2x * r2x + y * y + z * z);
+    double r13 = r1 * r1 * r1, r23 = r2 * r2 * r2;
+
+    ds[0] = s[3];
+    ds[1] = s[4];
+    ds[2] = s[5];
+    ds[3] = 2.0 * s[4] + x - (1.0 - mu) * r1x / r13 - mu * r2x / r23;
+    ds[4] = -2.0 * s[3] + y - (1.0 - mu) * y / r13 - mu * y / r23;
+    ds[5] = -(1.0 - mu) * z / r13 - mu * z / r23;
+    if(n == NSTATE) return;
+
+    /* Hessian of the pseudo-potential */
+    double r15 = r13 * r1 * r1, r25 = r23 * r2 * r2;
+    double a = (1.0 - mu) / r13 + mu / r23;
+    double uxx = 1.0 - a + 3.0 * ((1.0 - mu) * r1x * r1x / r15 + mu * r2x * r2x / r25);
+    double uyy = 1.0 - a + 3.0 * y * y * ((1.0 - mu) / r15 + mu / r25);
+    double uzz = -a + 3.0 * z * z * ((1.0 - mu) / r15 + mu / r25);
+    double uxy = 3.0 * y * ((1.0 - mu) * r1x / r15 + mu * r2x / r25);
+    double uxz = 3.0 * z * ((1.0 - mu) * r1x / r15 + mu * r2x / r25);
+    double uyz = 3.0 * y * z * ((1.0 - mu) / r15 + mu / r25);
+    double A[6][6] = {
+        {0, 0, 0, 1, 0, 0},
+        {0, 0, 0, 0, 1, 0},
+        {0, 0, 0, 0, 0, 1},
+        {uxx, uxy, uxz, 0, 2, 0},
+        {uxy, uyy, uyz, -2, 0, 0},
+        {uxz, uyz, uzz, 0, 0, 0}
+    };
+    const double* phi = s + 6;
+    double* dphi = ds + 6;
+    for(int i = 0; i < 6; i++) {
+        for(int j = 0; j < 6; j++) {
+            double acc = 0.0;
+            for(int k = 0; k < 6; k++) acc += A[i][k] * phi[k * 6 + j];
+            dphi[i * 6 + j] = acc;
+        }
+    }
+}
+
+double jacobi_constant(const double* s) {
+    double mu = MU_EM;
+    double r1 = sqrt((s[0] + mu) * (s[0] + mu) + s[1] * s[1] + s[2] * s[2]);
+    double r2 = sqrt((s[0] - 1.0 + mu) * (s[0] - 1.0 + mu) + s[1] * s[1] + s[2] * s[2]);
+    double u = 0.5 * (s[0] * s[0] + s[1] * s[1]) + (1.0 - mu) / r1 + mu / r2;
+    return 2.0 * u - (s[3] * s[3] + s[4] * s[4] + s[5] * s[5]);
+}
+
+/* One Dormand-Prince 5(4) step. Returns the scaled error norm. */
+static double dp45_step(const double* y, double h, double* out, int n) {
+    static const double c[7][6] = {
+        {0},
+        {1.0 / 5},
+        {3.0 / 40, 9.0 / 40},
+        {44.0 / 45, -56.0 / 15, 32.0 / 9},
+        {19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729},
+        {9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656},
+        {35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84}
+    };
+    static const double e[7] = {71.0 / 57600, 0, -71.0 / 16695, 71.0 / 1920,
+                                -17253.0 / 339200, 22.0 / 525, -1.0 / 40};
+    double k[7][NFULL], tmp[NFULL];
+
+    cr3bp_deriv(y, k[0], n);
+    for(int st = 1; st < 7; st++) {
+        for(int i = 0; i < n; i++) {
+            double acc = 0.0;
+            for(int j = 0; j < st; j++) acc += c[st][j] * k[j][i];
+            tmp[i] = y[i] + h * acc;
+        }
+        cr3bp_deriv(tmp, k[st], n);
+    }
+    /* 5th order solution is the last stage input (FSAL) */
+    double err = 0.0;
+    for(int i = 0; i < n; i++) {
+        out[i] = tmp[i];
+        double ei = 0.0;
+        for(int j = 0; j < 7; j++) ei += e[j] * k[j][i];
+        double sc = ATOL + RTOL * fmax(fabs(y[i]), fabs(out[i]));
+        double r = h * ei / sc;
+        if(i < NSTATE) err = fmax(err, fabs(r));  /* control on the state only */
+    }
+    return err;
+}
+
+/* Propagate s (n = NSTATE or NFULL) from t = 0 to tf (may be negative) */
+void cr3bp_propagate(double* s, double tf, int n) {
+    double t = 0.0, h = (tf >= 0 ? 1e-3 : -1e-3);
+    double out[NFULL];
+    while((tf - t) * (tf >= 0 ? 1 : -1) > 1e-15) {
+        if((t + h - tf) * (tf >= 0 ? 1 : -1) > 0) h = tf - t;
+        double err = dp45_step(s, h, out, n);
+        if(err <= 1.0) {
+            t += h;
+            memcpy(s, out, sizeof(double) * n);
+        }
+        double fac = err > 0 ? 0.9 * pow(err, -0.2) : 5.0;
+        h *= fmin(5.0, fmax(0.2, fac));
+    }
+}
+
+/* Propagate (with STM) to the next y = 0 crossing after t > t_min.
+   Returns the crossing time, or -1 if none within t_max. */
+static double propagate_to_crossing(double* s, double t_min, double t_max) {
+    double t = 0.0, h = 1e-3;
+    double out[NFULL];
+    while(t < t_max) {
+        double err = dp45_step(s, h, out, NFULL);
+        if(err <= 1.0) {
+            if(t + h > t_min && s[1] * out[1] < 0.0) {
+                /* Newton on time for y(t) = 0 */
+                double tc = t + h;
+                memcpy(s, out, sizeof(out));
+                for(int i = 0; i < 8 && fabs(s[1]) > 1e-14; i++) {
+                    double dt = -s[1] / s[4];
+                    double step_out[NFULL];
+                    dp45_step(s, dt, step_out, NFULL);
+                    memcpy(s, step_out, sizeof(step_out));
+                    tc += dt;
+                }
+                return tc;
+            }
+            t += h;
+            memcpy(s, out, sizeof(out));
+        }
+        double fac = err > 0 ? 0.9 * pow(err, -0.2) : 5.0;
+        h *= fmin(5.0, fmax(0.2, fac));
+    }
+    return -1.0;
+}
+
+static void init_with_stm(double* s, double x0, double z0, double vy0) {
+    memset(s, 0, sizeof(double) * NFULL);
+    s[0] = x0;
+    s[2] = z0;
+    s[4] = vy0;
+    for(int i = 0; i < 6; i++) s[6 + i * 6 + i] = 1.0;
+}
+
+/* Correct vy0 and one of x0 / z0 (HALO_FIX_Z corrects x0, HALO_FIX_X
+   corrects z0) so the orbit crosses y = 0 perpendicularly */
+static int correct_halo_fixed(HaloOrbit* o, int fixed) {
+    int col = fixed == HALO_FIX_X ? 2 : 0;
+    double* free_coord = fixed == HALO_FIX_X ? &o->z0 : &o->x0;
+    double s[NFULL];
+    o->converged = 0;
+    for(int it = 0; it < MAX_CORRECTOR_ITERS; it++) {
+        init_with_stm(s, o->x0, o->z0, o->vy0);
+        double tc = propagate_to_crossing(s, 0.2, 6.0);
+        if(tc < 0) return -1;
+        double vx = s[3], vz = s[5];
+        if(fabs(vx) < CORRECTOR_TOL && fabs(vz) < CORRECTOR_TOL) {
+            o->period = 2.0 * tc;
+            o->converged = 1;
+            return 0;
+        }
+        double d[NSTATE];
+        cr3bp_deriv(s, d, NSTATE);
+        const double* phi = s + 6;
+        double vy = s[4];
+        /* Columns col (x0 or z0) and vy0 (4), rows vx (3) and vz (5), with
+           the crossing-time change dT = -(phi[1][.] / vy) folded in */
+        double a11 = phi[3 * 6 + col] - d[3] * phi[1 * 6 + col] / vy;
+        double a12 = phi[3 * 6 + 4] - d[3] * phi[1 * 6 + 4] / vy;
+        double a21 = phi[5 * 6 + col] - d[5] * phi[1 * 6 + col] / vy;
+        double a22 = phi[5 * 6 + 4] - d[5] * phi[1 * 6 + 4] / vy;
+        double det = a11 * a22 - a12 * a21;
+        if(fabs(det) < 1e-14) return -1;
+        double dx = (-vx * a22 + vz * a12) / det;
+        double dv = (-vz * a11 + vx * a21) / det;
+        *free_coord += dx;
+        o->vy0 += dv;
+    }
+    return -1;
+}
+
+/* Correct (x0, vy0) for fixed z0 */
+int correct_halo(HaloOrbit* o) {
+    return correct_halo_fixed(o, HALO_FIX_Z);
+}
+
+/* Jacobi constant and stability index of a converged orbit */
+void characterise_halo(HaloOrbit* o) {
+    double s[NFULL];
+    init_with_stm(s, o->x0, o->z0, o->vy0);
+    o->jacobi = jacobi_constant(s);
+    /* Perilune is one of the two x-z plane crossings */
+    double half[NSTATE] = {o->x0, 0, o->z0, 0, o->vy0, 0};
+    cr3bp_propagate(half, 0.5 * o->period, NSTATE);
+    double r0 = sqrt(pow(o->x0 - 1.0 + MU_EM, 2) + o->z0 * o->z0);
+    double r1 = sqrt(pow(half[0] - 1.0 + MU_EM, 2) + half[1] * half[1] + half[2] * half[2]);
+    o->perilune_km = fmin(r0, r1) * LUNAR_DIST_KM - R_MOON_KM;
+    cr3bp_propagate(s, o->period, NFULL);
+    /* Largest monodromy eigenvalue by power iteration */
+    const double* m = s + 6;
+    double v[6] = {1, 1, 1, 1, 1, 1}, lam = 0.0;
+    for(int it = 0; it < 200; it++) {
+        double w[6] = {0}, norm = 0.0;
+        for(int i = 0; i < 6; i++) for(int j = 0; j < 6; j++) w[i] += m[i * 6 + j] * v[j];
+        for(int i = 0; i < 6; i++) norm += w[i] * w[i];
+        norm = sqrt(norm);
+        if(norm == 0) break;
+        for(int i = 0; i < 6; i++) v[i] = w[i] / norm;
+        lam = norm;
+    }
+    o->stability = 0.5 * (lam + (lam > 0 ? 1.0 / lam : 0.0));
+}
+
+/* Walk the family in x0 from converged orbit o toward the Moon until the
+   period drops through period_target, then bisect on x0. Natural
+   continuation in z0 cannot get here: z0 peaks (about 76000 km for L2)
+   and turns back while x0 keeps moving, so past the fold the family is
+   parameterised by x0. Returns 0 with o on the target, or -1 if the family
+   reaches the Moon's surface first or the corrector fails. */
+int halo_by_period(HaloOrbit* o, double period_target) {
+    double toward = (1.0 - MU_EM) > o->x0 ? 1.0 : -1.0;
+    HaloOrbit last = *o, t;
+    if(last.period <= period_target) return -1;
+    for(;;) {
+        t = last;
+        t.x0 += toward * NRHO_X_STEP;
+        if(fabs(t.x0 - (1.0 - MU_EM)) * LUNAR_DIST_KM < R_MOON_KM) return -1;
+        if(correct_halo_fixed(&t, HALO_FIX_X) != 0) return -1;
+        if(t.period <= period_target) break;
+        last = t;
+    }
+    /* period is monotone over one step: bisect between last and t */
+    HaloOrbit lo = last, hi = t;
+    for(int it = 0; it < 40 && fabs(hi.x0 - lo.x0) > 1e-12; it++) {
+        HaloOrbit mid = lo;
+        mid.x0 = 0.5 * (lo.x0 + hi.x0);
+        mid.z0 = 0.5 * (lo.z0 + hi.z0);
+        mid.vy0 = 0.5 * (lo.vy0 + hi.vy0);
+        if(correct_halo_fixed(&mid, HALO_FIX_X) != 0) return -1;
+        if(mid.period > period_target) lo = mid;
+        else hi = mid;
+    }
+    *o = fabs(lo.period - period_target) < fabs(hi.period - period_target) ? lo : hi;
+    characterise_halo(o);
+    return 0;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Batch propagation and parallel family continuation                      */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    double* states;     /* count x NSTATE */
+    const double* tf;
+    size_t first, last;
+    double max_jacobi_drift;
+} BatchJob;
+
+static void* batch_worker(void* arg) {
+    BatchJob* j = (BatchJob*)arg;
+    j->max_jacobi_drift = 0.0;
+    for(size_t i = j->first; i < j->last; i++) {
+        double* s = j->states + i * NSTATE;
+        double c0 = jacobi_constant(s);
+        cr3bp_propagate(s, j->tf[i], NSTATE);
+        double drift = fabs(jacobi_constant(s) - c0);
+        if(drift > j->max_jacobi_drift) j->max_jacobi_drift = drift;
+    }
+    return NULL;
+}
+
+/* Propagate count states in place by tf[i] each. Returns the largest
+   Jacobi-constant drift seen, as an integration accuracy monitor. */
+double cr3bp_propagate_batch(double* states, const double* tf, size_t count, int nthreads) {
+    if(nthreads < 1) nthreads = 1;
+    BatchJob* jobs = calloc((size_t)nthreads, sizeof(BatchJob));
+    pthread_t* tids = malloc(sizeof(pthread_t) * (size_t)nthreads);
+    unsigned char* threaded = malloc((size_t)nthreads);
+    double worst = 0.0;
+    if(!jobs || !tids || !threaded) { free(jobs); free(tids); free(threaded); return -1.0; }
+    for(int t = 0; t < nthreads; t++) {
+        jobs[t].states = states;
+        jobs[t].tf = tf;
+        jobs[t].first = count * (size_t)t / (size_t)nthreads;
+        jobs[t].last = count * (size_t)(t + 1) / (size_t)nthreads;
+        /* a slice whose thread cannot start runs on this one */
+        threaded[t] = pthread_create(&tids[t], NULL, batch_worker, &jobs[t]) == 0;
+        if(!threaded[t]) batch_worker(&jobs[t]);
+    }
+    for(int t = 0; t < nthreads; t++) {
+        if(threaded[t]) pthread_join(tids[t], NULL);
+        if(jobs[t].max_jacobi_drift > worst) worst = jobs[t].max_jacobi_drift;
+    }
+    free(jobs);
+    free(tids);
+    free(threaded);
+    return worst;
+}
+
+/* Continue converged orbit o to z0 = z_target in steps of at most h. A
+   step the corrector cannot close is halved and retried from the last
+   converged orbit; after a success the step grows back. Returns 0 with o
+   converged at z_target, or -1 with o->converged = 0. */
+static int continue_halo(HaloOrbit* o, double z_target, double h) {
+    HaloOrbit last = *o;
+    int halvings = 0;
+    h = fabs(h);
+    while(last.z0 != z_target) {
+        double left = z_target - last.z0;
+        HaloOrbit t = last;
+        t.z0 = fabs(left) <= h ? z_target : last.z0 + copysign(h, left);
+        if(correct_halo(&t) == 0) {
+            last = t;
+            if(halvings > 0) { h *= 2.0; halvings--; }
+        } else {
+            if(++halvings > MAX_STEP_HALVINGS) { o->converged = 0; return -1; }
+            h *= 0.5;
+        }
+    }
+    *o = last;
+    return 0;
+}
+
+typedef struct {
+    HaloOrbit* family;  /* shared output array */
+    int first, last;    /* family[first] holds a converged seed */
+    double dz;
+} FamilyJob;
+
+/* Natural-parameter continuation in z0 from family[first] */
+static void* family_worker(void* arg) {
+    FamilyJob* j = (FamilyJob*)arg;
+    for(int i = j->first + 1; i < j->last; i++) {
+        HaloOrbit o = j->family[i - 1];
+        if(!o.converged) { j->family[i].converged = 0; continue; }
+        /* Linear extrapolation from the two previous members when possible */
+        if(i - 2 >= j->first && j->family[i - 2].converged) {
+            o.x0 = 2.0 * o.x0 - j->family[i - 2].x0;
+            o.vy0 = 2.0 * o.vy0 - j->family[i - 2].vy0;
+        }
+        o.z0 = j->family[i - 1].z0 + j->dz;
+        correct_halo(&o);
+        if(!o.converged) {
+            /* Extrapolated guess left the basin: walk in from the previous member */
+            o = j->family[i - 1];
+            continue_halo(&o, o.z0 + j->dz, 0.5 * j->dz);
+        }
+        if(o.converged) characterise_halo(&o);
+        j->family[i] = o;
+    }
+    return NULL;
+}
+
+/* Build count halo orbits from z_min to z_max starting from seed guess */
+int halo_family(HaloOrbit seed, double z_min, double z_max, HaloOrbit* family, int count, int nthreads) {
+    if(count < 2) count = 2;
+    if(nthreads < 1) nthreads = 1;
+    if(nthreads > count - 1) nthreads = count - 1;
+    double dz = (z_max - z_min) / (count - 1);
+
+    /* Coarse pass: sequentially converge one seed per thread segment */
+    int stride = (count - 1 + nthreads - 1) / nthreads;
+    seed.z0 = z_min;
+    if(correct_halo(&seed) != 0) return -1;
+    characterise_halo(&seed);
+    family[0] = seed;
+    HaloOrbit prev = seed;
+    for(int k = stride; k < count; k += stride) {
+        HaloOrbit o = prev;
+        /* small steps keep the coarse pass inside the basin */
+        if(continue_halo(&o, prev.z0 + dz * stride, dz * stride / 8) != 0) break;
+        characterise_halo(&o);
+        family[k] = o;
+        prev = o;
+    }
+
+    /* Fine pass: each thread fills the gap after its seed */
+    FamilyJob* jobs = calloc((size_t)nthreads, sizeof(FamilyJob));
+    pthread_t* tids = malloc(sizeof(pthread_t) * (size_t)nthreads);
+    unsigned char* threaded = calloc((size_t)nthreads, 1);
+    if(!jobs || !tids || !threaded) { free(jobs); free(tids); free(threaded); return -1; }
+    int started = 0;
+    for(int t = 0; t < nthreads; t++) {
+        int first = t * stride;
+        if(first >= count - 1) break;
+        jobs[t].family = family;
+        jobs[t].first = first;
+        jobs[t].last = (first + stride + 1 < count) ? first + stride : count;
+        jobs[t].dz = dz;
+        /* segments only read their own seed, so one can run here instead */
+        threaded[t] = pthread_create(&tids[t], NULL, family_worker, &jobs[t]) == 0;
+        if(!threaded[t]) family_worker(&jobs[t]);
+        started++;
+    }
+    for(int t = 0; t < started; t++) if(threaded[t]) pthread_join(tids[t], NULL);
+    free(jobs);
+    free(tids);
+    free(threaded);
+    return 0;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Lunar capture cost from transfer energy                                 */
+/* ---------------------------------------------------------------------- */
+
+/* LOI delta-v (km/s) into a circular orbit of alt_km above the Moon for a
+   trans-lunar injection from a circular LEO at leo_alt_km whose apogee
+   reaches the Moon's distance. The TLI state's Jacobi constant fixes the
+   rotating-frame speed at periselene. */
+double lunar_capture_dv(double leo_alt_km, double llo_alt_km) {
+    double rp = R_EARTH_KM + leo_alt_km;
+    double ra = LUNAR_DIST_KM;
+    double v_tli = sqrt(GM_EARTH * (2.0 / rp - 2.0 / (rp + ra)));
+
+    /* TLI state in the rotating frame: Earth at (-mu, 0), burn along +y */
+    double s[NSTATE] = {0};
+    s[0] = -MU_EM - rp / LUNAR_DIST_KM;
+    s[4] = -v_tli / VEL_UNIT_KMS - s[0] - MU_EM;    /* subtract omega x r, retrograde side */
+    double c = jacobi_constant(s);
+
+    /* Periselene on the far side of the Moon */
+    double rl = (R_MOON_KM + llo_alt_km) / LUNAR_DIST_KM;
+    double p[NSTATE] = {1.0 - MU_EM + rl, 0, 0, 0, 0, 0};
+    double u2 = jacobi_constant(p);             /* 2U at periselene */
+    double v_rot = sqrt(fmax(u2 - c, 0.0));
+    /* Moon-centred inertial speeds (rotating frame adds omega * r) */
+    double v_arr = (v_rot + rl) * VEL_UNIT_KMS;
+    double v_circ = sqrt(GM_MOON / (R_MOON_KM + llo_alt_km));
+    return v_arr - v_circ;
+}
+
+int main(int argc, char** argv) {
+    int l2 = !(argc > 1 && strcmp(argv[1], "L1") == 0);
+    double zmin_km = argc > 2 ? atof(argv[2]) : (l2 ? 6000.0 : 8600.0);
+    double zmax_km = argc > 3 ? atof(argv[3]) : (l2 ? 60000.0 : 40000.0);
+    int count = argc > 4 ? atoi(argv[4]) : 24;
+    int nthreads = argc > 5 ? atoi(argv[5]) : 4;
+    if(count < 2) count = 2;
+
+    HaloOrbit seed = {0};
+    seed.x0 = l2 ? 1.1809 : 0.8234;
+    seed.vy0 = l2 ? -0.1559 : 0.1343;
+    HaloOrbit* family = calloc((size_t)count, sizeof(HaloOrbit));
+    if(!family) { printf("out of memory\n"); return 1; }
+
+    printf("\n--- CR3BP EARTH-MOON %s HALO FAMILY ---\n", l2 ? "L2" : "L1");
+    if(halo_family(seed, zmin_km / LUNAR_DIST_KM, zmax_km / LUNAR_DIST_KM, family, count, nthreads) != 0) {
+        printf("Seed orbit did not converge\n");
+        free(family);
+        return 1;
+    }
+    printf(" %-10s | %-10s | %-10s | %-9s | %-9s | %-9s\n", "x0", "z0 (km)", "vy0", "Period(d)", "Jacobi", "Stability");
+    for(int i = 0; i < count; i++) {
+        HaloOrbit* o = &family[i];
+        if(!o->converged) { printf(" (not converged)\n"); continue; }
+        printf(" %-10.6f | %-10.0f | %-10.6f | %-9.3f | %-9.5f | %-9.2f\n", o->x0, o->z0 * LUNAR_DIST_KM,
+               o->vy0, o->period * TIME_UNIT_S / 86400.0, o->jacobi, o->stability);
+    }
+
+    /* 9:2 synodic-resonant NRHO (the Gateway orbit for L2), reached from
+       the last converged member by continuation in x0 */
+    HaloOrbit nrho = {0};
+    for(int i = count - 1; i >= 0; i--) if(family[i].converged) { nrho = family[i]; break; }
+    double nrho_days = 2.0 * SYNODIC_MONTH_D / 9.0;
+    if(nrho.converged && halo_by_period(&nrho, nrho_days * 86400.0 / TIME_UNIT_S) == 0)
+        printf("\n 9:2 NRHO: x0 %.6f, z0 %.0f km, vy0 %.6f, period %.3f d, perilune %.0f km alt, stability %.2f\n",
+               nrho.x0, nrho.z0 * LUNAR_DIST_KM, nrho.vy0, nrho.period * TIME_UNIT_S / 86400.0,
+               nrho.perilune_km, nrho.stability);
+    else
+        printf("\n 9:2 NRHO: family does not reach a %.3f d period before the Moon\n", nrho_days);
+
+    /* Jacobi drift check over one period of every member, in parallel */
+    double* states = malloc(sizeof(double) * NSTATE * count);
+    double* tf = malloc(sizeof(double) * count);
+    if(states && tf) {
+        int m = 0;
+        for(int i = 0; i < count; i++) {
+            if(!family[i].converged) continue;
+            double* s = states + m * NSTATE;
+            memset(s, 0, sizeof(double) * NSTATE);
+            s[0] = family[i].x0; s[2] = family[i].z0; s[4] = family[i].vy0;
+            tf[m++] = family[i].period;
+        }
+        double drift = cr3bp_propagate_batch(states, tf, (size_t)m, nthreads);
+        printf("\n Max Jacobi drift over one period: %.2e\n", drift);
+    }
+    free(states);
+    free(tf);
+
+    /* transfer_costs.h derives the Moon's capture from the same energy
+       argument; that is the value derive_body() hands to planners */
+    int moon = find_orbit_body("Moon");
+    const TransferCost* tc = transfer_cost(moon, 0, 0);
+    double assumed = NAN;
+    for(int i = 0; i < NUM_BODIES; i++) if(strcmp(bodies[i].name, "Moon") == 0) assumed = bodies[i].dv_capture;
+    printf(" Computed LOI into 100 km LLO from 200 km LEO TLI: %.2f km/s (derived table %.2f, bodies[] assumes %.2f)\n",
+           lunar_capture_dv(200.0, 100.0), tc ? tc->dv_capture : NAN, assumed);
+    free(family);
+    return 0;
+}
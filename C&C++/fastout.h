@@ -0,0 +1,306 @@
+/*
+ fastout.h
+ Fast bulk formatted output for the array display programs
+
+ Overview:
+  - Replaces per-element printf() in display loops with:
+    * Integer -> decimal conversion using a digit-pair lookup table
+      (length from a clz/pow10 table, no per-digit branches)
+    * A reusable output buffer flushed with large write() calls
+    * A multithreaded formatter that formats chunks of an int array in
+      parallel and writes the chunks back out strictly in order
+  - Header only; works from C and C++ (array3d.cpp).
+  - Anything already printed with printf() must be fflush(stdout)'d before
+    using these functions on the same descriptor.
+*/
+
+#ifndef FASTOUT_H
+#define FASTOUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <io.h>
+#define fo_sys_write(fd, p, n) _write((fd), (p), (unsigned)(n))
+#else
+#include <unistd.h>
+#define fo_sys_write(fd, p, n) write((fd), (p), (n))
+#endif
+
+#define FO_BUFSIZE (1 << 20)    /* 1 MiB output buffer per writer */
+#define FO_MAX_INT_CHARS 11     /* "-2147483648" */
+#define FO_CHUNK_ELEMS 65536    /* elements formatted per parallel chunk */
+
+/* "00" "01" ... "99" */
+static const char fo_digit_pairs[201] =
+    "00010203040506070809" "10111213141516171819"
+    "20212223242526272829" "30313233343536373839"
+    "40414243444546474849" "50515253545556575859"
+    "60616263646566676869" "70717273747576777879"
+    "80818283848586878889" "90919293949596979899";
+
+static const uint32_t fo_pow10[10] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u,
+    10000000u, 100000000u, 1000000000u
+};
+
+/* Number of decimal digits in v (1 for v == 0) without a digit loop */
+static inline int fo_u32_len(uint32_t v) {
+    uint32_t x = v | 1u;
+    int t = ((32 - __builtin_clz(x)) * 1233) >> 12; /* ~ log10(2) * bits */
+    return t + 1 - (x < fo_pow10[t]);
+}
+
+/* Write v in decimal at p, return pointer past the last digit */
+static inline char* fo_fmt_u32(char* p, uint32_t v) {
+    int len = fo_u32_len(v);
+    char* end = p + len;
+    char* q = end;
+    while(v >= 100) {
+        uint32_t i = (v % 100) * 2;
+        v /= 100;
+        q -= 2;
+        memcpy(q, fo_digit_pairs + i, 2);
+    }
+    if(v >= 10) {
+        q -= 2;
+        memcpy(q, fo_digit_pairs + v * 2, 2);
+    } else {
+        *--q = (char)('0' + v);
+    }
+    return end;
+}
+
+static inline char* fo_fmt_i32(char* p, int32_t v) {
+    uint32_t u = (uint32_t)v;
+    *p = '-';
+    p += (v < 0);
+    u = (v < 0) ? 0u - u : u;
+    return fo_fmt_u32(p, u);
+}
+
+static inline char* fo_fmt_str(char* p, const char* s, size_t n) {
+    memcpy(p, s, n);
+    return p + n;
+}
+
+/* Write all of buf to fd, retrying short writes. Returns 0 or -1. */
+static inline int fo_write_all(int fd, const char* buf, size_t n) {
+    while(n > 0) {
+        long w = (long)fo_sys_write(fd, buf, n);
+        if(w < 0) {
+            if(errno == EINTR) continue;
+            return -1;
+        }
+        buf += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Buffered writer                                                         */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    int fd;
+    size_t len;
+    int error;
+    char* buf;
+} FastOut;
+
+static inline int fo_open(FastOut* fo, int fd) {
+    fo->fd = fd;
+    fo->len = 0;
+    fo->error = 0;
+    fo->buf = (char*)malloc(FO_BUFSIZE);
+    return fo->buf ? 0 : -1;
+}
+
+static inline void fo_flush(FastOut* fo) {
+    if(fo->len > 0 && !fo->error) {
+        if(fo_write_all(fo->fd, fo->buf, fo->len) != 0) fo->error = 1;
+    }
+    fo->len = 0;
+}
+
+/* Flush if fewer than need bytes remain; returns the current write position */
+static inline char* fo_reserve(FastOut* fo, size_t need) {
+    if(fo->len + need > FO_BUFSIZE) fo_flush(fo);
+    return fo->buf + fo->len;
+}
+
+static inline void fo_commit(FastOut* fo, char* end) {
+    fo->len = (size_t)(end - fo->buf);
+}
+
+static inline void fo_puts(FastOut* fo, const char* s) {
+    size_t n = strlen(s);
+    if(n > FO_BUFSIZE) {
+        fo_flush(fo);
+        if(fo_write_all(fo->fd, s, n) != 0) fo->error = 1;
+        return;
+    }
+    fo_commit(fo, fo_fmt_str(fo_reserve(fo, n), s, n));
+}
+
+static inline void fo_putc(FastOut* fo, char c) {
+    char* p = fo_reserve(fo, 1);
+    *p++ = c;
+    fo_commit(fo, p);
+}
+
+static inline void fo_int(FastOut* fo, int v) {
+    fo_commit(fo, fo_fmt_i32(fo_reserve(fo, FO_MAX_INT_CHARS), v));
+}
+
+/* Flush and release the buffer. Returns -1 if any write failed. */
+static inline int fo_close(FastOut* fo) {
+    fo_flush(fo);
+    free(fo->buf);
+    fo->buf = NULL;
+    return fo->error ? -1 : 0;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Parallel ordered formatter                                              */
+/* ---------------------------------------------------------------------- */
+
+/* Formats element idx (value v) at p and returns the new end.
+   Must write at most max_elem_chars bytes. */
+typedef char* (*fo_elem_fn)(char* p, size_t idx, int v, void* ctx);
+
+typedef struct {
+    char* buf;
+    size_t len;
+    long chunk;      /* chunk index held by this slot, -1 when free */
+    int ready;
+} FoSlot;
+
+typedef struct {
+    const int* vals;
+    size_t n;
+    size_t nchunks;
+    fo_elem_fn fmt;
+    void* ctx;
+    size_t max_elem_chars;
+    size_t next_chunk;
+    FoSlot* slots;
+    int nslots;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} FoParallel;
+
+/* Format chunk c into slot s (called without the lock held) */
+static void fo_parallel_format(FoParallel* fp, size_t c, FoSlot* s) {
+    size_t begin = c * FO_CHUNK_ELEMS;
+    size_t end = begin + FO_CHUNK_ELEMS;
+    if(end > fp->n) end = fp->n;
+    char* p = s->buf;
+    for(size_t i = begin; i < end; i++) p = fp->fmt(p, i, fp->vals[i], fp->ctx);
+    s->len = (size_t)(p - s->buf);
+}
+
+static void* fo_parallel_worker(void* arg) {
+    FoParallel* fp = (FoParallel*)arg;
+    for(;;) {
+        pthread_mutex_lock(&fp->lock);
+        size_t c = fp->next_chunk++;
+        if(c >= fp->nchunks) {
+            pthread_mutex_unlock(&fp->lock);
+            return NULL;
+        }
+        /* Wait for the writer to drain the slot this chunk maps to */
+        FoSlot* s = &fp->slots[c % (size_t)fp->nslots];
+        while(s->chunk != -1) pthread_cond_wait(&fp->cond, &fp->lock);
+        s->chunk = (long)c;
+        s->ready = 0;
+        pthread_mutex_unlock(&fp->lock);
+
+        fo_parallel_format(fp, c, s);
+
+        pthread_mutex_lock(&fp->lock);
+        s->ready = 1;
+        pthread_cond_broadcast(&fp->cond);
+        pthread_mutex_unlock(&fp->lock);
+    }
+}
+
+/* Format n values with fmt using nthreads workers and write them to fd in
+   order. Memory use is bounded by 2*nthreads chunk buffers regardless of n.
+   Returns 0 on success, -1 on allocation or write failure. */
+static inline int fo_write_ints_parallel(int fd, const int* vals, size_t n,
+                                         fo_elem_fn fmt, void* ctx,
+                                         size_t max_elem_chars, int nthreads) {
+    if(n == 0) return 0;
+    if(nthreads < 1) nthreads = 1;
+
+    FoParallel fp;
+    memset(&fp, 0, sizeof(fp));
+    fp.vals = vals;
+    fp.n = n;
+    fp.nchunks = (n + FO_CHUNK_ELEMS - 1) / FO_CHUNK_ELEMS;
+    if((size_t)nthreads > fp.nchunks) nthreads = (int)fp.nchunks;
+    fp.fmt = fmt;
+    fp.ctx = ctx;
+    fp.max_elem_chars = max_elem_chars;
+    fp.nslots = nthreads * 2;
+    fp.slots = (FoSlot*)calloc((size_t)fp.nslots, sizeof(FoSlot));
+    if(!fp.slots) return -1;
+    int rc = 0;
+    for(int i = 0; i < fp.nslots; i++) {
+        fp.slots[i].chunk = -1;
+        fp.slots[i].buf = (char*)malloc(FO_CHUNK_ELEMS * max_elem_chars);
+        if(!fp.slots[i].buf) rc = -1;
+    }
+    pthread_t* tids = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)nthreads);
+    if(!tids) rc = -1;
+    if(rc != 0) {
+        for(int i = 0; i < fp.nslots; i++) free(fp.slots[i].buf);
+        free(fp.slots);
+        free(tids);
+        return -1;
+    }
+    pthread_mutex_init(&fp.lock, NULL);
+    pthread_cond_init(&fp.cond, NULL);
+
+    /* Workers share the chunks, so fewer threads than asked only costs speed */
+    int started = 0;
+    while(started < nthreads && pthread_create(&tids[started], NULL, fo_parallel_worker, &fp) == 0) started++;
+
+    /* Writer: this thread emits chunks in order as they become ready */
+    for(size_t c = 0; c < fp.nchunks; c++) {
+        FoSlot* s = &fp.slots[c % (size_t)fp.nslots];
+        if(started == 0) {
+            /* No worker could be started: format on this thread */
+            fo_parallel_format(&fp, c, s);
+            if(rc == 0 && fo_write_all(fd, s->buf, s->len) != 0) rc = -1;
+            continue;
+        }
+        pthread_mutex_lock(&fp.lock);
+        while(!(s->chunk == (long)c && s->ready)) pthread_cond_wait(&fp.cond, &fp.lock);
+        pthread_mutex_unlock(&fp.lock);
+
+        if(rc == 0 && fo_write_all(fd, s->buf, s->len) != 0) rc = -1;
+
+        pthread_mutex_lock(&fp.lock);
+        s->chunk = -1;
+        s->ready = 0;
+        pthread_cond_broadcast(&fp.cond);
+        pthread_mutex_unlock(&fp.lock);
+    }
+
+    for(int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    pthread_cond_destroy(&fp.cond);
+    pthread_mutex_destroy(&fp.lock);
+    for(int i = 0; i < fp.nslots; i++) free(fp.slots[i].buf);
+    free(fp.slots);
+    free(tids);
+    return rc;
+}
+
+#endif /* FASTOUT_H */
@@ -0,0 +1,132 @@
+/*
+ hdr_hist.h
+ HDR-style latency histograms with lock-free merging
+
+ Overview:
+  - Log-linear buckets: values below 2^HDR_SUB_BITS are counted exactly,
+    larger values keep HDR_SUB_BITS significant bits, so every recorded
+    value is off by less than 1/64 (1.6%) from its bucket bound. Values
+    are nanoseconds up to 2^HDR_MAX_BITS (about 18 minutes); larger ones
+    are clamped to the top bucket.
+  - Each histogram has a single writer (one per worker thread). Counters
+    are updated with relaxed atomic stores, so a collector thread can read
+    and merge them at any time without locks; a merged snapshot may miss
+    the records made while it was being read, never corrupt them.
+  - hdr_value_at() reports the highest value equivalent to the percentile's
+    bucket, as HdrHistogram does.
+  - hdr_write_prometheus() prints a summary (quantiles with 1 as the
+    maximum, _sum, _count, in seconds) in Prometheus text exposition format.
+*/
+
+#ifndef HDR_HIST_H
+#define HDR_HIST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define HDR_SUB_BITS 7
+#define HDR_SUB_COUNT (1 << HDR_SUB_BITS)
+#define HDR_HALF (HDR_SUB_COUNT / 2)
+#define HDR_MAX_BITS 40
+#define HDR_COUNTS ((HDR_MAX_BITS - HDR_SUB_BITS + 2) * HDR_HALF)
+
+typedef struct {
+    uint64_t counts[HDR_COUNTS];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t max;
+} HdrHist;
+
+static inline void hdr_init(HdrHist* h) {
+    memset(h, 0, sizeof(*h));
+}
+
+static inline int hdr_index(uint64_t v) {
+    if(v >= (1ull << HDR_MAX_BITS)) v = (1ull << HDR_MAX_BITS) - 1;
+    if(v < HDR_SUB_COUNT) return (int)v;
+    int shift = (63 - __builtin_clzll(v)) - (HDR_SUB_BITS - 1);
+    return (shift + 1) * HDR_HALF + (int)((v >> shift) - HDR_HALF);
+}
+
+/* Largest value that lands in bucket idx */
+static inline uint64_t hdr_bucket_high(int idx) {
+    if(idx < HDR_SUB_COUNT) return (uint64_t)idx;
+    int shift = idx / HDR_HALF - 1;
+    uint64_t sub = (uint64_t)(idx % HDR_HALF + HDR_HALF);
+    return ((sub + 1) << shift) - 1;
+}
+
+/* Single writer per histogram */
+static inline void hdr_record(HdrHist* h, uint64_t v) {
+    uint64_t* c = &h->counts[hdr_index(v)];
+    __atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->sum, h->sum + v, __ATOMIC_RELAXED);
+    if(v > h->max) __atomic_store_n(&h->max, v, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->total, h->total + 1, __ATOMIC_RELEASE);
+}
+
+/* dst += src, reading src while its writer may still be recording */
+static inline void hdr_merge(HdrHist* dst, const HdrHist* src) {
+    uint64_t total = 0;
+    for(int i = 0; i < HDR_COUNTS; i++) {
+        uint64_t c = __atomic_load_n(&src->counts[i], __ATOMIC_RELAXED);
+        dst->counts[i] += c;
+        total += c;
+    }
+    /* total from the buckets themselves keeps percentiles consistent */
+    dst->total += total;
+    dst->sum += __atomic_load_n(&src->sum, __ATOMIC_RELAXED);
+    uint64_t mx = __atomic_load_n(&src->max, __ATOMIC_RELAXED);
+    if(mx > dst->max) dst->max = mx;
+}
+
+/* Value at percentile p (0..100) */
+static inline uint64_t hdr_value_at(const HdrHist* h, double p) {
+    if(h->total == 0) return 0;
+    uint64_t target = (uint64_t)ceil(p / 100.0 * (double)h->total);
+    if(target < 1) target = 1;
+    uint64_t seen = 0;
+    for(int i = 0; i < HDR_COUNTS; i++) {
+        seen += h->counts[i];
+        if(seen >= target) {
+            uint64_t v = hdr_bucket_high(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+static inline double hdr_mean(const HdrHist* h) {
+    return h->total ? (double)h->sum / (double)h->total : 0.0;
+}
+
+/* Summary family header; follow with one hdr_write_prometheus_series() per label set */
+static inline void hdr_write_prometheus_header(FILE* f, const char* name, const char* help) {
+    fprintf(f, "# HELP %s %s\n# TYPE %s summary\n", name, help, name);
+}
+
+/* Quantiles (1 = maximum), _sum and _count in seconds; labels is "" or
+   e.g. "kind=\"sweep\"" */
+static inline void hdr_write_prometheus_series(FILE* f, const char* name, const char* labels, const HdrHist* h) {
+    static const double qs[] = {0.5, 0.9, 0.99, 0.999};
+    const char* sep = labels[0] ? "," : "";
+    for(int i = 0; i < 4; i++)
+        fprintf(f, "%s{%s%squantile=\"%g\"} %.9f\n", name, labels, sep, qs[i], hdr_value_at(h, qs[i] * 100.0) * 1e-9);
+    fprintf(f, "%s{%s%squantile=\"1\"} %.9f\n", name, labels, sep, h->max * 1e-9);
+    if(labels[0]) {
+        fprintf(f, "%s_sum{%s} %.9f\n", name, labels, h->sum * 1e-9);
+        fprintf(f, "%s_count{%s} %lu\n", name, labels, (unsigned long)h->total);
+    } else {
+        fprintf(f, "%s_sum %.9f\n", name, h->sum * 1e-9);
+        fprintf(f, "%s_count %lu\n", name, (unsigned long)h->total);
+    }
+}
+
+static inline void hdr_write_prometheus(FILE* f, const char* name, const char* help, const HdrHist* h) {
+    hdr_write_prometheus_header(f, name, help);
+    hdr_write_prometheus_series(f, name, "", h);
+}
+
+#endif /* HDR_HIST_H */
@@ -0,0 +1,105 @@
+/*
+ kepler_bench.c
+ Accuracy and throughput check for kepler_batch.h
+
+ Propagates a batch of random elliptic and hyperbolic heliocentric states
+ forward by dt and back by -dt, then reports the worst round-trip position
+ error, the worst specific-energy drift and propagations per second, with
+ hardware counters per propagation where perf_event_open() allows them.
+
+ Build: gcc -O3 -march=native -ffast-math kepler_bench.c -o kepler_bench -lm
+ Usage: kepler_bench [count] [repeats]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "kepler_batch.h"
+#include "perf_counters.h"
+
+#define MU_SUN 1.32712440018e11     /* km^3/s^2 */
+#define AU_KM 1.495978707e8
+
+static double frand(unsigned* s) {
+    *s = *s * 1664525u + 1013904223u;
+    return (*s >> 8) / 16777216.0;
+}
+
+static int alloc_soa(StateSoA* s, size_t n) {
+    double* block = malloc(sizeof(double) * n * 6);
+    if(!block) return -1;
+    s->x = block; s->y = block + n; s->z = block + 2 * n;
+    s->vx = block + 3 * n; s->vy = block + 4 * n; s->vz = block + 5 * n;
+    return 0;
+}
+
+static double energy(const StateSoA* s, size_t i) {
+    double r = sqrt(s->x[i] * s->x[i] + s->y[i] * s->y[i] + s->z[i] * s->z[i]);
+    double v2 = s->vx[i] * s->vx[i] + s->vy[i] * s->vy[i] + s->vz[i] * s->vz[i];
+    return v2 / 2.0 - MU_SUN / r;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? (size_t)atol(argv[1]) : 1000000;
+    int repeats = argc > 2 ? atoi(argv[2]) : 5;
+    StateSoA s0, s1, s2;
+    double* dt = calloc(n, sizeof(double));
+    double* ndt = calloc(n, sizeof(double));
+    if(!dt || !ndt || alloc_soa(&s0, n) || alloc_soa(&s1, n) || alloc_soa(&s2, n)) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    /* Random states at 0.3-30 AU with speeds from 0.5x to 1.6x circular
+       (elliptic up to sqrt(2)x, hyperbolic above), dt up to 5 years */
+    unsigned seed = 42;
+    for(size_t i = 0; i < n; i++) {
+        double r = (0.3 + 29.7 * frand(&seed)) * AU_KM;
+        double th = 2 * KB_PI * frand(&seed), inc = 0.5 * (frand(&seed) - 0.5);
+        double vc = sqrt(MU_SUN / r) * (0.5 + 1.1 * frand(&seed));
+        double fpa = 0.6 * (frand(&seed) - 0.5);
+        s0.x[i] = r * cos(th); s0.y[i] = r * sin(th) * cos(inc); s0.z[i] = r * sin(th) * sin(inc);
+        s0.vx[i] = vc * (-sin(th + fpa)); s0.vy[i] = vc * cos(th + fpa) * cos(inc); s0.vz[i] = vc * cos(th + fpa) * sin(inc);
+        dt[i] = (frand(&seed) - 0.2) * 5.0 * 365.25 * 86400.0;
+        ndt[i] = -dt[i];
+    }
+
+    size_t failed = kepler_propagate_batch(MU_SUN, &s0, dt, &s1, n);
+    failed += kepler_propagate_batch(MU_SUN, &s1, ndt, &s2, n);
+
+    double worst_pos = 0.0, worst_energy = 0.0;
+    size_t hyperbolic = 0;
+    for(size_t i = 0; i < n; i++) {
+        double dx = s2.x[i] - s0.x[i], dy = s2.y[i] - s0.y[i], dz = s2.z[i] - s0.z[i];
+        double r = sqrt(s0.x[i] * s0.x[i] + s0.y[i] * s0.y[i] + s0.z[i] * s0.z[i]);
+        double e = sqrt(dx * dx + dy * dy + dz * dz) / r;
+        if(e > worst_pos) worst_pos = e;
+        double e0 = energy(&s0, i), e1 = energy(&s1, i);
+        double de = fabs(e1 - e0) / fabs(e0);
+        if(de > worst_energy) worst_energy = de;
+        hyperbolic += e0 > 0;
+    }
+
+    PerfCounters pc;
+    PcSample ps;
+    pc_open(&pc);
+    pc_start(&pc, &ps);
+    for(int k = 0; k < repeats; k++) kepler_propagate_batch(MU_SUN, &s0, dt, &s1, n);
+    pc_stop(&pc, &ps);
+    double el = ps.seconds;
+
+    printf("States: %zu (%zu hyperbolic) | not converged: %zu\n", n, hyperbolic, failed);
+    printf("Worst round-trip position error: %.3e (relative)\n", worst_pos);
+    printf("Worst energy drift:              %.3e (relative)\n", worst_energy);
+    printf("Throughput: %.1f M propagations/s (%.1f ns/state)\n",
+           n * (double)repeats / el / 1e6, el * 1e9 / (n * (double)repeats));
+    pc_print_status(stdout, &pc);
+    pc_print_header(stdout, 12);
+    pc_print_row(stdout, 12, "propagation", &ps, n * (double)repeats);
+    pc_close(&pc);
+
+    free(s0.x); free(s1.x); free(s2.x);
+    free(dt); free(ndt);
+    return 0;
+}
@@ -0,0 +1,536 @@
+/*
+ manifest_opt.c
+ Manifest optimizer: pack payloads onto rockets and launch windows
+
+ Overview:
+  - Each payload has a mass, a destination and a ready date, which fixes
+    its earliest launch window. Payloads to the same body in the same
+    window may rideshare on one launch, and a payload may slip up to
+    MAX_DELAY windows.
+  - A launch flies the cheapest rocket whose limit covers its total mass.
+    The limit per rocket/body is the largest mass for which every lighter
+    payload is feasible under evaluate_mission() (mission_core.h), computed
+    once, so every feasibility check while searching is a table lookup.
+    The same pass records the tanker flights a refuelled launch needs at
+    each mass step; they count as launches of that rocket.
+  - Objective: fewest flights (launches plus tankers) first, then rocket
+    cost, then slip.
+  - Search: greedy best-fit-decreasing construction, then large
+    neighbourhood search (remove whole launches or random payloads and
+    re-insert them best-fit), accepting equal-or-better moves and undoing
+    the rest. Independent restarts with different seeds run on all threads.
+  - Restart 0 searches from the greedy solution. Every other restart
+    builds its own start: payload masses jittered by up to +-50% per seed
+    before the decreasing sort, then the same best-fit insertion, so the
+    restarts explore different basins instead of one.
+  - Each restart keeps its working solution and undo buffers in its own
+    arena (arena.h), so a worker calls malloc once per chunk, not once per
+    buffer, and frees everything in one call when it finishes.
+
+ Usage: manifest_opt [payloads] [seconds] [threads] [seed]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "mission_core.h"
+#include "arena.h"
+
+#define MAX_DELAY 2                 /* windows a payload may slip */
+#define LAUNCH_WEIGHT 1000.0        /* objective weight of one launch */
+#define DELAY_WEIGHT 5.0            /* objective weight of one window of slip */
+#define MASS_STEP_KG 50.0           /* resolution of the feasibility table */
+#define MAX_BODIES 16
+#define MAX_ROCKETS 16
+
+/* Relative cost of one flight of each rocket (tie-breaker after launch count) */
+static const double rocket_cost[] = {1.0, 4.0, 1.5, 0.5};
+_Static_assert(sizeof(rocket_cost) / sizeof(rocket_cost[0]) == sizeof(rockets) / sizeof(rockets[0]),
+               "rocket_cost[] needs one entry per catalog rocket");
+
+typedef struct {
+    double mass;
+    int body;
+    int earliest;           /* earliest window index */
+} Payload;
+
+typedef struct {
+    int body;
+    int window;
+    int count;
+    double mass;
+} Launch;
+
+typedef struct {
+    Launch* bins;
+    int* assign;            /* payload -> bin */
+    int num_bins;
+    double objective;
+} Solution;
+
+/* Shared, read-only after set-up */
+Payload* payloads;
+int num_payloads;
+double max_mass[MAX_ROCKETS][MAX_BODIES];   /* feasibility limits */
+double body_limit[MAX_BODIES];              /* best rocket limit per body */
+int* tankers_at[MAX_ROCKETS][MAX_BODIES];   /* tanker flights at mass step i (i * MASS_STEP_KG) */
+
+static unsigned xorshift(unsigned* s) {
+    unsigned x = *s;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return *s = x;
+}
+
+static double urand(unsigned* s) { return (xorshift(s) >> 8) / 16777216.0; }
+
+/* Largest mass m such that every payload in (0, m] is feasible, and the
+   tankers needed at each step up to it. Returns 0, or -1 when out of memory. */
+int build_feasibility_table() {
+    for(int r = 0; r < NUM_ROCKETS; r++) {
+        int steps = (int)(rockets[r].payload_leo_kg / MASS_STEP_KG) + 1;
+        for(int b = 0; b < NUM_BODIES; b++) {
+            int* tk = calloc((size_t)steps, sizeof(int));
+            if(!tk) return -1;
+            tankers_at[r][b] = tk;
+            double limit = 0.0;
+            int i = 1;
+            for(double m = MASS_STEP_KG; m <= rockets[r].payload_leo_kg; m += MASS_STEP_KG, i++) {
+                Mission ms;
+                MissionResult res;
+                memset(&ms, 0, sizeof(ms));
+                ms.rocket = rockets[r];
+                ms.body = bodies[b];
+                ms.payload_kg = m;
+                if(!evaluate_mission(&ms, &res)) break;
+                limit = m;
+                tk[i] = res.tankers;
+            }
+            tk[0] = tk[1 < steps ? 1 : 0];
+            max_mass[r][b] = limit;
+            if(limit > body_limit[b]) body_limit[b] = limit;
+        }
+    }
+    return 0;
+}
+
+/* Tanker flights rocket r needs to fly mass (<= its limit) to body, taken
+   at the next table step up, so never fewer than evaluate_mission() asks */
+static int tankers_for(int r, int body, double mass) {
+    return tankers_at[r][body][(int)ceil(mass / MASS_STEP_KG)];
+}
+
+/* Cheapest rocket able to fly mass to body counting its tanker flights,
+   -1 if none. Sets *tankers for the chosen rocket. */
+static int rocket_for(int body, double mass, int* tankers) {
+    int best = -1;
+    double best_cost = 0.0;
+    *tankers = 0;
+    for(int r = 0; r < NUM_ROCKETS; r++) {
+        if(mass > max_mass[r][body]) continue;
+        int t = tankers_for(r, body, mass);
+        double cost = (1 + t) * (LAUNCH_WEIGHT + rocket_cost[r]);
+        if(best < 0 || cost < best_cost) {
+            best = r;
+            best_cost = cost;
+            *tankers = t;
+        }
+    }
+    return best;
+}
+
+/* Launch plus its tanker flights, each weighted like a launch */
+static double bin_cost(const Launch* l) {
+    if(l->count == 0) return 0.0;
+    int t;
+    int r = rocket_for(l->body, l->mass, &t);
+    return r >= 0 ? (1 + t) * (LAUNCH_WEIGHT + rocket_cost[r]) : LAUNCH_WEIGHT + 1e9;
+}
+
+/* Move payload p to bin `to` (-1 = unassigned), keeping the objective current */
+static void move_payload(Solution* s, int p, int to) {
+    int from = s->assign[p];
+    const Payload* py = &payloads[p];
+    if(from >= 0) {
+        Launch* l = &s->bins[from];
+        s->objective -= bin_cost(l) + DELAY_WEIGHT * (l->window - py->earliest);
+        l->count--;
+        l->mass -= py->mass;
+        if(l->count == 0) l->mass = 0.0;
+        s->objective += bin_cost(l);
+    }
+    if(to >= 0) {
+        Launch* l = &s->bins[to];
+        s->objective -= bin_cost(l);
+        l->count++;
+        l->mass += py->mass;
+        s->objective += bin_cost(l) + DELAY_WEIGHT * (l->window - py->earliest);
+    }
+    s->assign[p] = to;
+}
+
+/* Empty bin slot, or -1 */
+static int free_bin(const Solution* s) {
+    for(int i = 0; i < s->num_bins; i++) if(s->bins[i].count == 0) return i;
+    return -1;
+}
+
+/* Best-fit insertion of payload p. Returns 0 on success. */
+static int insert_best(Solution* s, int p) {
+    const Payload* py = &payloads[p];
+    int best = -1;
+    double best_delta = 0.0;
+    for(int i = 0; i < s->num_bins; i++) {
+        Launch* l = &s->bins[i];
+        if(l->count == 0 || l->body != py->body) continue;
+        if(l->window < py->earliest || l->window > py->earliest + MAX_DELAY) continue;
+        double nm = l->mass + py->mass;
+        if(nm > body_limit[py->body]) continue;
+        Launch tmp = *l;
+        tmp.count++;
+        tmp.mass = nm;
+        double delta = bin_cost(&tmp) - bin_cost(l) + DELAY_WEIGHT * (l->window - py->earliest);
+        /* Prefer the fullest bin among equal costs (best fit) */
+        delta -= 1e-9 * nm;
+        if(best < 0 || delta < best_delta) { best = i; best_delta = delta; }
+    }
+    /* A launch of its own, tankers included, may be cheaper than joining */
+    Launch alone = {py->body, py->earliest, 1, py->mass};
+    if(best < 0 || best_delta >= bin_cost(&alone)) {
+        int nb = free_bin(s);
+        if(nb < 0) return -1;
+        s->bins[nb].body = py->body;
+        s->bins[nb].window = py->earliest;
+        s->bins[nb].mass = 0.0;
+        best = nb;
+    }
+    move_payload(s, p, best);
+    return 0;
+}
+
+int solution_alloc(Solution* s, int bins) {
+    s->bins = calloc((size_t)bins, sizeof(Launch));
+    s->assign = malloc(sizeof(int) * (size_t)num_payloads);
+    s->num_bins = bins;
+    s->objective = 0.0;
+    if(!s->bins || !s->assign) return -1;
+    for(int i = 0; i < num_payloads; i++) s->assign[i] = -1;
+    return 0;
+}
+
+void solution_copy(Solution* dst, const Solution* src) {
+    memcpy(dst->bins, src->bins, sizeof(Launch) * (size_t)src->num_bins);
+    memcpy(dst->assign, src->assign, sizeof(int) * (size_t)num_payloads);
+    dst->objective = src->objective;
+}
+
+/* Solution carved from a worker's arena; freed with the arena */
+int solution_alloc_in(Solution* s, int bins, Arena* a) {
+    s->bins = (Launch*)arena_calloc(a, (size_t)bins, sizeof(Launch));
+    s->assign = ARENA_NEW(a, int, num_payloads);
+    s->num_bins = bins;
+    s->objective = 0.0;
+    if(!s->bins || !s->assign) return -1;
+    for(int i = 0; i < num_payloads; i++) s->assign[i] = -1;
+    return 0;
+}
+
+void solution_free(Solution* s) {
+    free(s->bins);
+    free(s->assign);
+}
+
+int launches_in(const Solution* s) {
+    int n = 0;
+    for(int i = 0; i < s->num_bins; i++) n += s->bins[i].count > 0;
+    return n;
+}
+
+int tankers_in(const Solution* s) {
+    int n = 0, t;
+    for(int i = 0; i < s->num_bins; i++)
+        if(s->bins[i].count > 0 && rocket_for(s->bins[i].body, s->bins[i].mass, &t) >= 0) n += t;
+    return n;
+}
+
+static const Payload* sort_base;
+static int by_mass_desc(const void* a, const void* b) {
+    double ma = sort_base[*(const int*)a].mass, mb = sort_base[*(const int*)b].mass;
+    return (ma < mb) - (ma > mb);
+}
+
+/* Greedy best-fit decreasing over the feasible payloads */
+void construct(Solution* s, const int* order, int n) {
+    for(int i = 0; i < n; i++) insert_best(s, order[i]);
+}
+
+typedef struct {
+    double key;
+    int p;
+} OrderKey;
+
+static int by_key_desc(const void* a, const void* b) {
+    double ka = ((const OrderKey*)a)->key, kb = ((const OrderKey*)b)->key;
+    return (ka < kb) - (ka > kb);
+}
+
+/* Best-fit insertion in decreasing order of mass jittered by up to +-50%.
+   The sort keys are released back to the arena. Returns 0, or -1 when out
+   of memory. */
+static int construct_randomized(Solution* s, const int* order, int n, unsigned* rng, Arena* a) {
+    ArenaMark mark = arena_mark(a);
+    OrderKey* keys = ARENA_NEW(a, OrderKey, n);
+    int* shuffled = ARENA_NEW(a, int, n);
+    if(!keys || !shuffled) {
+        arena_release(a, mark);
+        return -1;
+    }
+    for(int i = 0; i < n; i++) {
+        keys[i].p = order[i];
+        keys[i].key = payloads[order[i]].mass * (0.5 + urand(rng));
+    }
+    qsort(keys, (size_t)n, sizeof(OrderKey), by_key_desc);
+    for(int i = 0; i < n; i++) shuffled[i] = keys[i].p;
+    construct(s, shuffled, n);
+    arena_release(a, mark);
+    return 0;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Large neighbourhood search                                              */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    const Solution* start;
+    const int* order;       /* feasible payloads, heaviest first */
+    int num_order;
+    int randomize;          /* build a randomized start instead of copying start */
+    int start_launches;
+    Solution best;
+    unsigned seed;
+    double seconds;
+    long iterations;
+    long improvements;
+    int ran;                /* search completed; best is valid */
+} SearchJob;
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void* lns_worker(void* arg) {
+    SearchJob* j = (SearchJob*)arg;
+    Solution cur;
+    Arena scratch;
+    unsigned rng = j->seed;
+    arena_init(&scratch, 0);
+    int* removed = ARENA_NEW(&scratch, int, num_payloads);
+    int* undo_bin = ARENA_NEW(&scratch, int, num_payloads);
+    Launch* undo_launch = ARENA_NEW(&scratch, Launch, num_payloads);
+    if(!removed || !undo_bin || !undo_launch || solution_alloc_in(&cur, j->start->num_bins, &scratch) != 0 ||
+       (j->randomize && construct_randomized(&cur, j->order, j->num_order, &rng, &scratch) != 0)) {
+        arena_free(&scratch);
+        return NULL;
+    }
+    if(!j->randomize) solution_copy(&cur, j->start);
+    solution_copy(&j->best, &cur);
+    j->start_launches = launches_in(&cur);
+
+    double t_end = now_sec() + j->seconds;
+
+    while(1) {
+        if((j->iterations & 63) == 0 && now_sec() > t_end) break;
+        j->iterations++;
+        double before = cur.objective;
+        int nrem = 0;
+
+        /* Destroy: empty 1-3 random launches, or pull 5-40 random payloads */
+        if(urand(&rng) < 0.5) {
+            int k = 1 + (int)(urand(&rng) * 3);
+            for(int t = 0; t < k * 8 && k > 0; t++) {
+                int b = (int)(urand(&rng) * cur.num_bins);
+                if(cur.bins[b].count == 0) continue;
+                for(int p = 0; p < num_payloads; p++) {
+                    if(cur.assign[p] != b) continue;
+                    undo_bin[nrem] = b;
+                    undo_launch[nrem] = cur.bins[b];
+                    removed[nrem++] = p;
+                    move_payload(&cur, p, -1);
+                }
+                k--;
+            }
+        } else {
+            int k = 5 + (int)(urand(&rng) * 36);
+            for(int t = 0; t < k; t++) {
+                int p = (int)(urand(&rng) * num_payloads);
+                if(cur.assign[p] < 0) continue;
+                undo_bin[nrem] = cur.assign[p];
+                undo_launch[nrem] = cur.bins[cur.assign[p]];
+                removed[nrem++] = p;
+                move_payload(&cur, p, -1);
+            }
+        }
+        if(nrem == 0) continue;
+
+        /* Repair: heaviest first, best fit, with a little random order noise */
+        for(int i = nrem - 1; i > 0; i--) {
+            int k = (int)(urand(&rng) * (i + 1));
+            int tp = removed[i]; removed[i] = removed[k]; removed[k] = tp;
+            int tb = undo_bin[i]; undo_bin[i] = undo_bin[k]; undo_bin[k] = tb;
+            Launch tl = undo_launch[i]; undo_launch[i] = undo_launch[k]; undo_launch[k] = tl;
+        }
+        int ok = 1;
+        for(int pass = 0; pass < 2; pass++) {
+            for(int i = 0; i < nrem; i++) {
+                const Payload* py = &payloads[removed[i]];
+                int heavy = py->mass > 0.25 * body_limit[py->body];
+                if(heavy != (pass == 0) || cur.assign[removed[i]] >= 0) continue;
+                if(insert_best(&cur, removed[i]) != 0) ok = 0;
+            }
+        }
+
+        if(ok && cur.objective <= before + 1e-9) {
+            if(cur.objective < j->best.objective - 1e-9) {
+                solution_copy(&j->best, &cur);
+                j->improvements++;
+            }
+        } else {
+            /* Undo: take the repaired payloads out, put the originals back.
+               A bin emptied by the destroy step may have been reused for a
+               different window during repair, so restore its key too. */
+            for(int i = 0; i < nrem; i++) move_payload(&cur, removed[i], -1);
+            for(int i = 0; i < nrem; i++) {
+                Launch* l = &cur.bins[undo_bin[i]];
+                if(l->count == 0) {
+                    l->body = undo_launch[i].body;
+                    l->window = undo_launch[i].window;
+                }
+                move_payload(&cur, removed[i], undo_bin[i]);
+            }
+        }
+    }
+    arena_free(&scratch);
+    j->ran = 1;
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000;
+    double seconds = argc > 2 ? atof(argv[2]) : 5.0;
+    int nthreads = argc > 3 ? atoi(argv[3]) : 4;
+    unsigned seed = argc > 4 ? (unsigned)atoi(argv[4]) : 7;
+    if(n < 1) n = 1;
+    if(nthreads < 1) nthreads = 1;
+    if(NUM_ROCKETS > MAX_ROCKETS || NUM_BODIES > MAX_BODIES) { printf("catalog too large\n"); return 1; }
+
+    if(build_feasibility_table() != 0) { printf("out of memory\n"); return 1; }
+
+    /* Random payload list: mostly small satellites, some heavy landers */
+    payloads = malloc(sizeof(Payload) * (size_t)n);
+    int* order = malloc(sizeof(int) * (size_t)n);
+    if(!payloads || !order) { printf("out of memory\n"); return 1; }
+    unsigned rng = seed ? seed : 1;
+    int infeasible = 0;
+    num_payloads = n;
+    int feasible = 0;
+    for(int i = 0; i < n; i++) {
+        Payload* p = &payloads[i];
+        p->body = (int)(urand(&rng) * NUM_BODIES);
+        double u = urand(&rng);
+        p->mass = u < 0.7 ? 100.0 + 1400.0 * urand(&rng) : 2000.0 + 60000.0 * urand(&rng) * urand(&rng);
+        p->earliest = (int)(urand(&rng) * (bodies[p->body].synodic_days < 100 ? 60 : 4));
+        if(p->mass > body_limit[p->body]) infeasible++;
+        else order[feasible++] = i;
+    }
+    sort_base = payloads;
+    qsort(order, (size_t)feasible, sizeof(int), by_mass_desc);
+
+    Solution init;
+    if(solution_alloc(&init, feasible + 1) != 0) { printf("out of memory\n"); return 1; }
+    double t0 = now_sec();
+    construct(&init, order, feasible);
+    double t_build = now_sec() - t0;
+
+    printf("\n--- MANIFEST OPTIMIZER ---\n");
+    printf(" Payloads: %d (%d too heavy for any rocket/destination)\n", n, infeasible);
+    printf(" Greedy best-fit decreasing: %d launches + %d tanker flights (%.3f s)\n", launches_in(&init),
+           tankers_in(&init), t_build);
+
+    SearchJob* jobs = calloc((size_t)nthreads, sizeof(SearchJob));
+    pthread_t* tids = malloc(sizeof(pthread_t) * (size_t)nthreads);
+    if(!jobs || !tids) { printf("out of memory\n"); return 1; }
+    for(int t = 0; t < nthreads; t++) {
+        jobs[t].start = &init;
+        jobs[t].order = order;
+        jobs[t].num_order = feasible;
+        jobs[t].randomize = t > 0;
+        jobs[t].seed = seed * 2654435761u + (unsigned)t * 40503u + 1u;
+        jobs[t].seconds = seconds;
+        if(solution_alloc(&jobs[t].best, init.num_bins) != 0) { printf("out of memory\n"); return 1; }
+    }
+    int* started = calloc((size_t)nthreads, sizeof(int));
+    if(!started) { printf("out of memory\n"); return 1; }
+    for(int t = 0; t < nthreads; t++) started[t] = pthread_create(&tids[t], NULL, lns_worker, &jobs[t]) == 0;
+
+    /* Only restarts that ran to the end have a valid best; the greedy
+       solution stands in if none did */
+    int best_t = -1, lo = 0, hi = 0, randomized = 0, failed = 0;
+    long iters = 0;
+    for(int t = 0; t < nthreads; t++) {
+        if(started[t]) pthread_join(tids[t], NULL);
+        if(!jobs[t].ran) {
+            failed++;
+            continue;
+        }
+        iters += jobs[t].iterations;
+        if(best_t < 0 || jobs[t].best.objective < jobs[best_t].best.objective) best_t = t;
+        if(t > 0) {
+            if(!randomized || jobs[t].start_launches < lo) lo = jobs[t].start_launches;
+            if(!randomized || jobs[t].start_launches > hi) hi = jobs[t].start_launches;
+            randomized++;
+        }
+    }
+    if(randomized) printf(" Randomized restart starts: %d-%d launches\n", lo, hi);
+    if(failed) printf(" Note: %d of %d restarts could not run (thread or memory)\n", failed, nthreads);
+    const Solution* best = best_t >= 0 ? &jobs[best_t].best : &init;
+
+    int per_rocket[MAX_ROCKETS] = {0}, tankers_per_rocket[MAX_ROCKETS] = {0}, shared = 0, slipped = 0;
+    for(int i = 0; i < best->num_bins; i++) {
+        const Launch* l = &best->bins[i];
+        if(l->count == 0) continue;
+        int t;
+        int r = rocket_for(l->body, l->mass, &t);
+        if(r >= 0) {
+            per_rocket[r]++;
+            tankers_per_rocket[r] += t;
+        }
+        if(l->count > 1) shared += l->count;
+    }
+    for(int p = 0; p < n; p++) {
+        int b = best->assign[p];
+        if(b >= 0 && best->bins[b].window > payloads[p].earliest) slipped++;
+    }
+    if(best_t >= 0)
+        printf(" LNS (%d threads, %.1f s, %ld iterations): %d launches + %d tanker flights (best from restart %d)\n",
+               nthreads, seconds, iters, launches_in(best), tankers_in(best), best_t);
+    else
+        printf(" LNS did not run; reporting the greedy manifest\n");
+    for(int r = 0; r < NUM_ROCKETS; r++)
+        printf("  - %-28s %d launches, %d tanker flights\n", rockets[r].name, per_rocket[r], tankers_per_rocket[r]);
+    printf(" Rideshared payloads: %d | Slipped a window: %d\n", shared, slipped);
+
+    for(int t = 0; t < nthreads; t++) solution_free(&jobs[t].best);
+    solution_free(&init);
+    free(jobs);
+    free(tids);
+    free(started);
+    free(payloads);
+    free(order);
+    for(int r = 0; r < NUM_ROCKETS; r++)
+        for(int b = 0; b < NUM_BODIES; b++) free(tankers_at[r][b]);
+    return 0;
+}
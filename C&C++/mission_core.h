@@ -0,0 +1,222 @@
+/*
+ mission_core.h
+ Shared planner data: rocket/body catalogs, mission record and core math
+
+ Overview:
+  - Types and predefined catalogs used by SpaceRockets.c and the tools
+    built around it (transfer tables, sweeps, simulators).
+  - Date helpers and the rocket-equation capability estimate.
+  - Each program is a single translation unit, so the catalogs are defined
+    here directly.
+*/
+
+#ifndef MISSION_CORE_H
+#define MISSION_CORE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/* Constants */
+#define G0 9.80665
+#define EARTH_ASCENT_COST 9.30 /* km/s - approximate delta-v to escape from LEO incl. losses */
+
+#define DATE_STRLEN 20
+
+/* Data structures */
+typedef struct {
+    char name[64];
+    double wet_mass_kg;     /* total wet mass in kg */
+    double dry_mass_kg;     /* dry mass in kg (no fuel) */
+    double isp_avg;         /* average specific impulse (s) */
+    double payload_leo_kg;  /* practical payload to LEO */
+    double staging_factor;  /* empirical multiplier for multi-stage performance */
+    double refuel_dv_per_tanker; /* extra delta-v (km/s) gained per tanker refuel mission (estimate) */
+} Rocket;
+
+typedef struct {
+    char name[64];
+    double dv_transfer;     /* km/s - transfer DV estimate */
+    double dv_capture;      /* km/s - capture/braking DV estimate */
+    double synodic_days;    /* days between favorable windows (synodic) */
+    char epoch_date[DATE_STRLEN];    /* reference epoch for windows */
+    double typical_transit_days; /* typical travel days (approx) */
+} Body;
+
+typedef struct {
+    Rocket rocket;
+    Body body;
+    char start_date[DATE_STRLEN];
+    double payload_kg;
+    int strategy; /* 0=direct,1=oberth,2=gravity-assist,3=refuel,4=kick-stage,-1=impossible */
+    char notes[256];
+} Mission;
+
+/* Numbers produced by evaluate_mission() */
+typedef struct {
+    double capability;          /* rocket base capability (km/s) */
+    double total_required;      /* ascent + transfer + capture (km/s) */
+    double final_capability;    /* capability including strategy bonus/tankers */
+    double final_margin;
+    int tankers;
+    int success;
+} MissionResult;
+
+/* Predefined rockets and bodies (expanded metadata) */
+Rocket rockets[] = {
+    {"SpaceX's Starship", 5000000.0, 200000.0, 350.0, 150000.0, 1.4, 5.5},
+    {"NASA's SLS", 2600000.0, 110000.0, 400.0, 95000.0, 1.5, 0.0},
+    {"Blue Origin's New Glenn", 1700000.0, 100000.0, 340.0, 45000.0, 1.4, 0.0},
+    {"ISRO's Mangalyaan 1 (PSLV)", 320000.0, 42000.0, 275.0, 1750.0, 1.2, 0.0}
+};
+
+Body bodies[] = {
+    {"Moon", 3.12, 2.80, 29.5, "2025-01-13", 3.0},
+    {"Mars", 3.80, 2.10, 780.0, "2025-01-16", 210.0},
+    {"Titan (Saturn)", 7.30, 3.00, 378.1, "2025-09-21", 1000.0}
+};
+
+int NUM_ROCKETS = sizeof(rockets)/sizeof(rockets[0]);
+int NUM_BODIES  = sizeof(bodies)/sizeof(bodies[0]);
+
+/* Parse date string YYYY-MM-DD to epoch time (at 00:00:00 local). Returns -1 on error. */
+time_t parse_date(const char* s) {
+    struct tm tm = {0};
+    int y,m,d;
+    if(!s || strlen(s) < 8) return -1;
+    if(sscanf(s,"%d-%d-%d",&y,&m,&d)!=3) return -1;
+    tm.tm_year = y - 1900;
+    tm.tm_mon  = m - 1;
+    tm.tm_mday = d;
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+/* Format time_t -> YYYY-MM-DD */
+void format_date(time_t t, char* s) {
+    if(t < 0) { strcpy(s, "----"); return; }
+    struct tm* tm = localtime(&t);
+    strftime(s, DATE_STRLEN, "%Y-%m-%d", tm);
+}
+
+/* Compute delta-v capability of a rocket for given payload (simple rocket equation macro) */
+double calc_capability(const Rocket* r, double payload) {
+    /* If payload exceeds practical LEO payload we consider it impossible for direct insertion */
+    if(payload > r->payload_leo_kg) return 0.0;
+    double m0 = r->wet_mass_kg + payload;
+    double mf = r->dry_mass_kg + payload;
+    if(mf <= 0 || m0 <= mf) return 0.0;
+    double dv = (r->isp_avg * G0 * log(m0/mf)) / 1000.0; /* km/s */
+    dv *= r->staging_factor; /* empirical boost for staging */
+    return dv;
+}
+
+/* Suggest refuel plan if applicable */
+int compute_tanker_plan(const Mission* m, double shortage, int* tankers_needed) {
+    /* Only rockets with non-zero refuel_dv_per_tanker realistically can use tankers (Starship) */
+    double per_tanker = m->rocket.refuel_dv_per_tanker;
+    if(per_tanker <= 0.0 || shortage <= 0.0) {
+        *tankers_needed = 0;
+        return 0;
+    }
+    int needed = (int)ceil(shortage / per_tanker);
+    *tankers_needed = needed;
+    return needed;
+}
+
+/* Choose a strategy for the mission and compute its delta-v budget without
+   printing anything. Sets m->strategy and m->notes. Returns 1 if feasible. */
+int evaluate_mission(Mission* m, MissionResult* res) {
+    /* Base delta-v requirements */
+    double p1 = EARTH_ASCENT_COST;
+    double p2 = m->body.dv_transfer;
+    double p3 = m->body.dv_capture;
+    double total_req = p1 + p2 + p3;
+
+    /* Compute rocket capability for payload */
+    double cap = calc_capability(&m->rocket, m->payload_kg);
+
+    /* Initialize strategy and notes */
+    m->strategy = 0;
+    strcpy(m->notes, "None");
+
+    /* Decision logic: determine strategy if margin insufficient */
+    double margin = cap - total_req;
+    double bonus_dv = 0.0;
+
+    if(margin < 0) {
+        /* First consider gravity assist for long-reach bodies (Titan) */
+        if(strstr(m->body.name, "Titan")) {
+            m->strategy = 2;
+            bonus_dv = 4.5; /* assumed gain via multi-flyby (VEEGA) */
+            strcpy(m->notes, "Alternate route: VEEGA gravity assist (~7 year flight)");
+        }
+        /* If rocket can be refueled (e.g., Starship) suggest refueling */
+        else if(strstr(m->rocket.name, "Starship")) {
+            m->strategy = 3;
+            /* In refuel strategy, we treat final capability as a fixed assumption or computed from tankers */
+            strcpy(m->notes, "Assumption: LEO refueling by tanker missions");
+            /* We'll compute tankers later */
+        }
+        /* If small negative margin, a kick stage may be assumed */
+        else if(margin > -1.5) {
+            m->strategy = 4;
+            bonus_dv = 2.0;
+            strcpy(m->notes, "Assumption: Added 'Star 48' solid kick stage");
+        } else {
+            /* Mark impossible initially */
+            m->strategy = -1;
+            strcpy(m->notes, "No feasible profile found with current assumptions");
+        }
+    } else {
+        /* If rocket is small but the mission is Mars and payload light, might use Oberth/Perigee kicks */
+        if(strstr(m->rocket.name, "PSLV") && strstr(m->body.name, "Mars") && m->payload_kg <= 1500) {
+            m->strategy = 1;
+            bonus_dv = 6.5;
+            strcpy(m->notes, "Oberth/Kick-perigee method for low-mass Mars mission");
+        }
+    }
+
+    /* If strategy is refuel, compute how many tankers required */
+    int tankers_needed = 0;
+    double final_cap = cap;
+    double final_margin;
+
+    if(m->strategy == 3) {
+        /* If Starship, use its refuel_dv_per_tanker to estimate number of tankers.
+           Compute positive shortage and plan tankers. */
+        double shortage = total_req - cap;
+        if(shortage <= 0) {
+            tankers_needed = 0;
+            final_cap = cap;
+        } else {
+            tankers_needed = compute_tanker_plan(m, shortage, &tankers_needed);
+            if(tankers_needed < 0) tankers_needed = 0;
+            final_cap = cap + (tankers_needed * m->rocket.refuel_dv_per_tanker);
+            /* add note about tankers */
+            char tmp[256];
+            snprintf(tmp, sizeof(tmp), "LEO refueling: estimated %d tanker(s) required", tankers_needed);
+            strncpy(m->notes, tmp, sizeof(m->notes)-1);
+        }
+    } else {
+        final_cap = cap + bonus_dv;
+    }
+
+    final_margin = final_cap - total_req;
+    int success = (final_margin >= 0 && m->strategy != -1);
+
+    res->capability = cap;
+    res->total_required = total_req;
+    res->final_capability = final_cap;
+    res->final_margin = final_margin;
+    res->tankers = tankers_needed;
+    res->success = success;
+    return success;
+}
+
+#endif /* MISSION_CORE_H */
@@ -0,0 +1,655 @@
+/*
+ mission_import.c
+ Bulk CSV importer for analyst mission lists
+
+ Overview:
+  - Reads "rocket,body,payload_kg,start_date" lists (optional header row
+    naming those columns, quoted fields, CRLF or LF) and evaluates every row with
+    evaluate_mission() instead of going through the SpaceRockets menu.
+  - Stage 1 maps the file and classifies it 64 bytes at a time: comma,
+    newline and quote bitmasks come from the csv_separators kernel in
+    simd_kernels.h (AVX-512/AVX2/SSE2/scalar, picked at startup), a prefix
+    XOR over the quote bits masks out separators inside quoted fields, and
+    the remaining bits are turned into separator offsets.
+  - Stage 2 walks the offsets field by field: payloads and YYYY-MM-DD dates
+    are parsed and validated by hand, and rocket/body names are interned in
+    a hash table so each distinct spelling is matched against the catalogs
+    once (exact name first, then a unique case-insensitive substring such as
+    "Starship" or "Titan").
+  - Parsed rows are evaluated in batches of IMPORT_BATCH missions; results
+    can be written as CSV through async_out.h. Bad rows are reported with
+    their record number and skipped.
+  - --compare also times the fgets/sscanf/mktime path the menu uses (which
+    lets mktime() normalise out-of-range dates instead of rejecting them).
+  - --generate writes a sample list with mixed spellings and a few bad rows.
+
+ Build: gcc -O3 mission_import.c -o mission_import -lm -pthread
+ Usage: mission_import [--compare] <list.csv> [results.csv]
+        mission_import --generate <rows> <list.csv>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <time.h>
+#include "mission_core.h"
+#include "arena.h"
+#include "async_out.h"
+#include "simd_kernels.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define IMPORT_WINDOW (1 << 16)     /* bytes classified per stage-1 pass */
+#define IMPORT_BATCH 1024           /* missions evaluated together */
+#define IMPORT_FIELDS 4
+#define MAX_NAME 128
+#define MAX_REPORTED_ERRORS 10
+
+/* ---------------------------------------------------------------------- */
+/* Input mapping                                                           */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    int mapped;
+} InputFile;
+
+static int input_open(InputFile* in, const char* path) {
+    memset(in, 0, sizeof(*in));
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return -1;
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    in->len = (size_t)st.st_size;
+    if(in->len > 0) {
+        void* p = mmap(NULL, in->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p != MAP_FAILED) {
+            madvise(p, in->len, MADV_SEQUENTIAL);
+            in->data = (const uint8_t*)p;
+            in->mapped = 1;
+        }
+    }
+    close(fd);
+    if(in->mapped || in->len == 0) return 0;
+#endif
+    FILE* f = fopen(path, "rb");
+    if(!f) return -1;
+    fseek(f, 0, SEEK_END);
+    in->len = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = (uint8_t*)malloc(in->len + 1);
+    if(!buf || fread(buf, 1, in->len, f) != in->len) {
+        free(buf);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    in->data = buf;
+    return 0;
+}
+
+static void input_close(InputFile* in) {
+#ifndef _WIN32
+    if(in->mapped) {
+        munmap((void*)in->data, in->len);
+        return;
+    }
+#endif
+    free((void*)in->data);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Stage 1: separator bitmasks                                             */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    size_t* pos;            /* separator offsets (commas and newlines outside quotes) */
+    size_t count, cap;
+    uint64_t in_quote;      /* all ones if the last block ended inside a quoted field */
+} SepIndex;
+
+static void sep_reserve(SepIndex* ix, size_t extra) {
+    if(ix->count + extra <= ix->cap) return;
+    while(ix->cap < ix->count + extra) ix->cap = ix->cap ? ix->cap * 2 : IMPORT_WINDOW;
+    ix->pos = (size_t*)realloc(ix->pos, ix->cap * sizeof(size_t));
+    if(!ix->pos) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+}
+
+/* Classify data[begin, end); begin is a multiple of 64 apart from the tail */
+static void sep_scan(SepIndex* ix, const uint8_t* data, size_t begin, size_t end) {
+    sep_reserve(ix, end - begin);
+    ix->count += sk_kernels()->csv_separators(data, begin, end, &ix->in_quote, ix->pos + ix->count);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Interned names                                                          */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    uint64_t hash;
+    const char* key;        /* NUL-terminated copy in the table's arena */
+    size_t len;
+    int rocket;             /* catalog index, -1 if the name is no rocket */
+    int body;
+} InternEntry;
+
+typedef struct {
+    InternEntry* slots;
+    size_t cap, count;
+    Arena arena;
+    long lookups, resolves;
+} InternTable;
+
+static inline uint64_t fnv1a(const char* s, size_t n) {
+    uint64_t h = 1469598103934665603ull;
+    for(size_t i = 0; i < n; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/* 2 = same name ignoring case, 1 = key is a substring ignoring case */
+static int name_match(const char* catalog, const char* key, size_t len) {
+    size_t cl = strlen(catalog);
+    if(len == 0 || len > cl) return 0;
+    for(size_t start = 0; start + len <= cl; start++) {
+        size_t i = 0;
+        while(i < len && tolower((unsigned char)catalog[start + i]) == tolower((unsigned char)key[i])) i++;
+        if(i == len) return cl == len ? 2 : 1;
+    }
+    return 0;
+}
+
+/* Exact match, else the only catalog entry containing key; -1 otherwise */
+static int resolve(const char* key, size_t len, const char* names, size_t stride, int count) {
+    int found = -1, partial = 0;
+    for(int i = 0; i < count; i++) {
+        int m = name_match(names + stride * (size_t)i, key, len);
+        if(m == 2) return i;
+        if(m == 1) {
+            found = i;
+            partial++;
+        }
+    }
+    return partial == 1 ? found : -1;
+}
+
+static int intern_init(InternTable* t) {
+    t->cap = 64;
+    t->count = 0;
+    t->slots = (InternEntry*)calloc(t->cap, sizeof(InternEntry));
+    arena_init(&t->arena, 0);
+    t->lookups = t->resolves = 0;
+    return t->slots ? 0 : -1;
+}
+
+static int intern_grow(InternTable* t) {
+    size_t cap = t->cap * 2;
+    InternEntry* slots = (InternEntry*)calloc(cap, sizeof(InternEntry));
+    if(!slots) return -1;
+    for(size_t i = 0; i < t->cap; i++) {
+        if(!t->slots[i].key) continue;
+        size_t j = t->slots[i].hash & (cap - 1);
+        while(slots[j].key) j = (j + 1) & (cap - 1);
+        slots[j] = t->slots[i];
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->cap = cap;
+    return 0;
+}
+
+/* Entry for s, added on first sight; NULL when out of memory */
+static const InternEntry* intern(InternTable* t, const char* s, size_t n) {
+    uint64_t h = fnv1a(s, n);
+    size_t j = h & (t->cap - 1);
+    t->lookups++;
+    for(;;) {
+        InternEntry* e = &t->slots[j];
+        if(!e->key) break;
+        if(e->hash == h && e->len == n && memcmp(e->key, s, n) == 0) return e;
+        j = (j + 1) & (t->cap - 1);
+    }
+    if(2 * (t->count + 1) > t->cap) {
+        if(intern_grow(t) != 0) return NULL;
+        return intern(t, s, n);
+    }
+    InternEntry* e = &t->slots[j];
+    char* key = (char*)arena_alloc(&t->arena, n + 1);
+    if(!key) return NULL;
+    memcpy(key, s, n);
+    key[n] = '\0';
+    e->hash = h;
+    e->key = key;
+    e->len = n;
+    e->rocket = resolve(key, n, rockets[0].name, sizeof(Rocket), NUM_ROCKETS);
+    e->body = resolve(key, n, bodies[0].name, sizeof(Body), NUM_BODIES);
+    t->count++;
+    t->resolves++;
+    return e;
+}
+
+static void intern_free(InternTable* t) {
+    free(t->slots);
+    arena_free(&t->arena);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Stage 2: fields                                                         */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    const char* p;
+    size_t n;
+} Field;
+
+static inline Field trim(const uint8_t* data, size_t b, size_t e) {
+    while(b < e && (data[b] == ' ' || data[b] == '\t')) b++;
+    while(e > b && (data[e - 1] == ' ' || data[e - 1] == '\t' || data[e - 1] == '\r')) e--;
+    Field f = {(const char*)data + b, e - b};
+    return f;
+}
+
+/* Strip surrounding quotes and collapse "" into buf; returns -1 if too long */
+static inline int unquote(Field* f, char* buf) {
+    if(f->n < 2 || f->p[0] != '"' || f->p[f->n - 1] != '"') return 0;
+    size_t n = 0;
+    for(size_t i = 1; i + 1 < f->n; i++) {
+        if(n >= MAX_NAME) return -1;
+        buf[n++] = f->p[i];
+        if(f->p[i] == '"' && f->p[i + 1] == '"') i++;
+    }
+    f->p = buf;
+    f->n = n;
+    return 0;
+}
+
+/* Field equals name ignoring case and surrounding quotes */
+static inline int field_is(Field f, const char* name) {
+    if(f.n >= 2 && f.p[0] == '"' && f.p[f.n - 1] == '"') {
+        f.p++;
+        f.n -= 2;
+    }
+    return f.n == strlen(name) && strncasecmp(f.p, name, f.n) == 0;
+}
+
+/* Digits with an optional fraction; no sign, exponent or locale */
+static inline int parse_payload(Field f, double* out) {
+    static const double frac_scale[10] = {1, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9};
+    size_t i = 0;
+    uint64_t ip = 0, fp = 0;
+    int idig = 0, fdig = 0;
+    while(i < f.n && f.p[i] >= '0' && f.p[i] <= '9' && idig < 15) {
+        ip = ip * 10 + (uint64_t)(f.p[i++] - '0');
+        idig++;
+    }
+    if(i < f.n && f.p[i] == '.') {
+        i++;
+        while(i < f.n && f.p[i] >= '0' && f.p[i] <= '9') {
+            if(fdig < 9) {
+                fp = fp * 10 + (uint64_t)(f.p[i] - '0');
+                fdig++;
+            }
+            i++;
+        }
+    }
+    if(i != f.n || idig + fdig == 0) return -1;
+    *out = (double)ip + (double)fp * frac_scale[fdig];
+    return 0;
+}
+
+static inline int digits(const char* p, int n) {
+    int v = 0;
+    for(int i = 0; i < n; i++) {
+        unsigned d = (unsigned)(p[i] - '0');
+        if(d > 9) return -1;
+        v = v * 10 + (int)d;
+    }
+    return v;
+}
+
+/* Strict YYYY-MM-DD with calendar validation */
+static inline int parse_ymd(Field f, char* out) {
+    static const int mdays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if(f.n != 10 || f.p[4] != '-' || f.p[7] != '-') return -1;
+    int y = digits(f.p, 4), m = digits(f.p + 5, 2), d = digits(f.p + 8, 2);
+    if(y < 1970 || m < 1 || m > 12 || d < 1) return -1;
+    int leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    if(d > mdays[m - 1] + (m == 2 && leap)) return -1;
+    memcpy(out, f.p, 10);
+    out[10] = '\0';
+    return 0;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Import driver                                                           */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    InternTable names;
+    Mission* batch;
+    size_t* batch_record;
+    int batch_n;
+    AsyncOut* out;
+    size_t records, imported, feasible, errors, header;
+    size_t by_strategy[6];      /* -1..4 */
+    double t_scan, t_parse, t_eval;
+} Importer;
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void row_error(Importer* im, size_t record, const char* what, Field f) {
+    im->errors++;
+    if(im->errors <= MAX_REPORTED_ERRORS)
+        fprintf(stderr, "record %zu: %s '%.*s'\n", record, what, (int)(f.n > 40 ? 40 : f.n), f.p);
+}
+
+static void field_count_error(Importer* im, size_t record, int nf) {
+    im->errors++;
+    if(im->errors <= MAX_REPORTED_ERRORS)
+        fprintf(stderr, "record %zu: expected %d fields, got %d\n", record, IMPORT_FIELDS, nf);
+}
+
+static void flush_batch(Importer* im) {
+    double t = now_sec();
+    for(int i = 0; i < im->batch_n; i++) {
+        Mission* m = &im->batch[i];
+        MissionResult res;
+        int ok = evaluate_mission(m, &res);
+        im->feasible += (size_t)ok;
+        im->by_strategy[m->strategy + 1]++;
+        if(im->out) {
+            ao_printf(im->out, "%zu,%s,%s,%s,%.3f,%d,%d,%d,%.6f\n", im->batch_record[i], m->rocket.name,
+                      m->body.name, m->start_date, m->payload_kg, m->strategy, res.tankers, ok, res.final_margin);
+        }
+    }
+    im->imported += (size_t)im->batch_n;
+    im->batch_n = 0;
+    im->t_eval += now_sec() - t;
+}
+
+static void import_row(Importer* im, const uint8_t* data, const size_t* fb, const size_t* fe, int nf) {
+    size_t record = ++im->records;
+    Field f[IMPORT_FIELDS];
+    char qbuf[2][MAX_NAME];
+    if(nf == 1 && trim(data, fb[0], fe[0]).n == 0) {
+        im->records--;          /* blank line */
+        return;
+    }
+    for(int i = 0; i < IMPORT_FIELDS && i < nf; i++) f[i] = trim(data, fb[i], fe[i]);
+    if(nf != IMPORT_FIELDS) {
+        field_count_error(im, record, nf);
+        return;
+    }
+    if(record == 1 && field_is(f[0], "rocket") && field_is(f[1], "body") && field_is(f[2], "payload_kg") &&
+       field_is(f[3], "start_date")) {
+        im->header = 1;
+        return;
+    }
+    for(int i = 0; i < 2; i++) {
+        if(unquote(&f[i], qbuf[i]) != 0) {
+            row_error(im, record, "name too long", f[i]);
+            return;
+        }
+    }
+    Mission* m = &im->batch[im->batch_n];
+    if(parse_payload(f[2], &m->payload_kg) != 0) {
+        row_error(im, record, "bad payload", f[2]);
+        return;
+    }
+    const InternEntry* r = intern(&im->names, f[0].p, f[0].n);
+    const InternEntry* b = r ? intern(&im->names, f[1].p, f[1].n) : NULL;
+    if(!b) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    if(r->rocket < 0) {
+        row_error(im, record, "unknown or ambiguous rocket", f[0]);
+        return;
+    }
+    if(b->body < 0) {
+        row_error(im, record, "unknown or ambiguous body", f[1]);
+        return;
+    }
+    if(parse_ymd(f[3], m->start_date) != 0) {
+        row_error(im, record, "bad date", f[3]);
+        return;
+    }
+    m->rocket = rockets[r->rocket];
+    m->body = bodies[b->body];
+    im->batch_record[im->batch_n++] = record;
+    if(im->batch_n == IMPORT_BATCH) flush_batch(im);
+}
+
+/* Parse complete records among the indexed separators; keeps the
+   separators of a trailing partial record for the next window */
+static size_t parse_records(Importer* im, const uint8_t* data, SepIndex* ix, size_t row_start, int at_eof,
+                            size_t len) {
+    size_t fb[IMPORT_FIELDS], fe[IMPORT_FIELDS];
+    size_t start = row_start, keep = 0;
+    int nf = 0;
+    for(size_t k = 0; k < ix->count; k++) {
+        size_t p = ix->pos[k];
+        if(nf < IMPORT_FIELDS) {
+            fb[nf] = start;
+            fe[nf] = p;
+        }
+        nf++;
+        start = p + 1;
+        if(data[p] == '\n') {
+            import_row(im, data, fb, fe, nf);
+            nf = 0;
+            row_start = start;
+            keep = k + 1;
+        }
+    }
+    if(at_eof) {
+        if(row_start < len) {
+            if(nf < IMPORT_FIELDS) {
+                fb[nf] = start;
+                fe[nf] = len;
+            }
+            import_row(im, data, fb, fe, nf + 1);
+        }
+        ix->count = 0;
+        return len;
+    }
+    memmove(ix->pos, ix->pos + keep, (ix->count - keep) * sizeof(size_t));
+    ix->count -= keep;
+    return row_start;
+}
+
+static int run_import(const char* path, const char* out_path) {
+    InputFile in;
+    if(input_open(&in, path) != 0) {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return -1;
+    }
+    Importer im;
+    memset(&im, 0, sizeof(im));
+    int names_ok = intern_init(&im.names) == 0;
+    im.batch = (Mission*)calloc(IMPORT_BATCH, sizeof(Mission));
+    im.batch_record = (size_t*)malloc(IMPORT_BATCH * sizeof(size_t));
+    if(!names_ok || !im.batch || !im.batch_record) {
+        fprintf(stderr, "Out of memory\n");
+        free(im.batch);
+        free(im.batch_record);
+        intern_free(&im.names);
+        input_close(&in);
+        return -1;
+    }
+    if(out_path) {
+        im.out = ao_open(out_path, 0, AO_BLOCK_DEFAULT, 4);
+        if(!im.out) {
+            fprintf(stderr, "Cannot open %s\n", out_path);
+            free(im.batch);
+            free(im.batch_record);
+            intern_free(&im.names);
+            input_close(&in);
+            return -1;
+        }
+        ao_printf(im.out, "record,rocket,body,start_date,payload_kg,strategy,tankers,success,final_margin\n");
+    }
+
+    SepIndex ix;
+    memset(&ix, 0, sizeof(ix));
+    size_t row_start = 0;
+    double t0 = now_sec();
+    for(size_t off = 0; off < in.len; off += IMPORT_WINDOW) {
+        size_t end = off + IMPORT_WINDOW < in.len ? off + IMPORT_WINDOW : in.len;
+        double t = now_sec();
+        sep_scan(&ix, in.data, off, end);
+        double t1 = now_sec();
+        im.t_scan += t1 - t;
+        row_start = parse_records(&im, in.data, &ix, row_start, end == in.len, in.len);
+        im.t_parse += now_sec() - t1;
+    }
+    flush_batch(&im);
+    double total = now_sec() - t0;
+    im.t_parse -= im.t_eval;        /* parse time included the batch flushes */
+
+    int rc = 0;
+    if(im.out && ao_close(im.out) != 0) {
+        fprintf(stderr, "Error writing %s\n", out_path);
+        rc = -1;
+    }
+    if(im.errors > MAX_REPORTED_ERRORS) fprintf(stderr, "... %zu more bad records\n", im.errors - MAX_REPORTED_ERRORS);
+
+    double mb = in.len / 1e6;
+    printf("Imported %zu of %zu records from %s (%.1f MB)%s, %zu rejected\n", im.imported, im.records - im.header,
+           path, mb, im.header ? ", header skipped" : "", im.errors);
+    printf("Distinct names: %zu (%ld lookups)\n", im.names.count, im.names.lookups);
+    printf("Feasible: %zu   direct %zu  oberth %zu  assist %zu  refuel %zu  kick %zu  impossible %zu\n", im.feasible,
+           im.by_strategy[1], im.by_strategy[2], im.by_strategy[3], im.by_strategy[4], im.by_strategy[5],
+           im.by_strategy[0]);
+    printf("Time: scan %.1f ms (%.2f GB/s), parse %.1f ms, evaluate %.1f ms, total %.1f ms (%.0f ns/record)\n",
+           im.t_scan * 1e3, mb / 1e3 / (im.t_scan > 0 ? im.t_scan : 1e-9), im.t_parse * 1e3, im.t_eval * 1e3,
+           total * 1e3, total * 1e9 / (im.records ? im.records : 1));
+
+    free(ix.pos);
+    free(im.batch);
+    free(im.batch_record);
+    intern_free(&im.names);
+    input_close(&in);
+    return rc;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Baseline: one line at a time, as the menu reads input                   */
+/* ---------------------------------------------------------------------- */
+
+static void strip_quotes(char* s) {
+    size_t n = strlen(s);
+    if(n >= 2 && s[0] == '"' && s[n - 1] == '"') {
+        memmove(s, s + 1, n - 2);
+        s[n - 2] = '\0';
+    }
+}
+
+static int find_rocket(const char* s) {
+    for(int i = 0; i < NUM_ROCKETS; i++)
+        if(strcasecmp(rockets[i].name, s) == 0) return i;
+    return resolve(s, strlen(s), rockets[0].name, sizeof(Rocket), NUM_ROCKETS);
+}
+
+static int find_body(const char* s) {
+    for(int i = 0; i < NUM_BODIES; i++)
+        if(strcasecmp(bodies[i].name, s) == 0) return i;
+    return resolve(s, strlen(s), bodies[0].name, sizeof(Body), NUM_BODIES);
+}
+
+static void run_baseline(const char* path) {
+    FILE* f = fopen(path, "r");
+    if(!f) return;
+    char line[512], rn[MAX_NAME], bn[MAX_NAME], date[DATE_STRLEN];
+    double payload;
+    size_t ok_rows = 0, feasible = 0;
+    double t0 = now_sec();
+    while(fgets(line, sizeof(line), f)) {
+        if(sscanf(line, " %127[^,], %127[^,], %lf, %19s", rn, bn, &payload, date) != 4) continue;
+        strip_quotes(rn);
+        strip_quotes(bn);
+        int r = find_rocket(rn), b = find_body(bn);
+        if(r < 0 || b < 0 || parse_date(date) < 0) continue;
+        Mission m;
+        MissionResult res;
+        memset(&m, 0, sizeof(m));
+        m.rocket = rockets[r];
+        m.body = bodies[b];
+        m.payload_kg = payload;
+        snprintf(m.start_date, DATE_STRLEN, "%s", date);
+        feasible += (size_t)evaluate_mission(&m, &res);
+        ok_rows++;
+    }
+    fclose(f);
+    double t = now_sec() - t0;
+    printf("Baseline fgets/sscanf/mktime: %zu rows, %zu feasible, %.1f ms (%.0f ns/row)\n", ok_rows, feasible, t * 1e3,
+           t * 1e9 / (ok_rows ? ok_rows : 1));
+}
+
+/* ---------------------------------------------------------------------- */
+/* Sample list generator                                                   */
+/* ---------------------------------------------------------------------- */
+
+static int generate(size_t rows, const char* path) {
+    static const char* rocket_names[] = {"SpaceX's Starship", "Starship", "starship", "\"NASA's SLS\"", "SLS",
+                                         "New Glenn", "\"ISRO's Mangalyaan 1 (PSLV)\"", "PSLV"};
+    static const char* body_names[] = {"Moon", "Mars", "mars", "Titan", "\"Titan (Saturn)\""};
+    FILE* f = fopen(path, "wb");
+    if(!f) return -1;
+    srand(42);
+    fprintf(f, "rocket,body,payload_kg,start_date\r\n");
+    for(size_t i = 0; i < rows; i++) {
+        const char* r = rocket_names[rand() % 8];
+        const char* b = body_names[rand() % 5];
+        int y = 2025 + rand() % 15, mo = 1 + rand() % 12, d = 1 + rand() % 28;
+        if(i % 997 == 500) r = "Falcon 9";          /* not in the catalog */
+        if(i % 1009 == 700) mo = 13;                /* invalid date */
+        fprintf(f, "%s, %s,%d.%d,%04d-%02d-%02d\r\n", r, b, 100 + rand() % 200000, rand() % 10, y, mo, d);
+    }
+    return fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    int compare = 0, a = 1;
+    if(argc >= 4 && strcmp(argv[1], "--generate") == 0) {
+        size_t rows = (size_t)atol(argv[2]);
+        if(generate(rows, argv[3]) != 0) {
+            fprintf(stderr, "Cannot write %s\n", argv[3]);
+            return 1;
+        }
+        printf("Wrote %zu sample missions to %s\n", rows, argv[3]);
+        return 0;
+    }
+    if(a < argc && strcmp(argv[a], "--compare") == 0) {
+        compare = 1;
+        a++;
+    }
+    if(a >= argc) {
+        fprintf(stderr, "Usage: %s [--compare] <list.csv> [results.csv]\n"
+                        "       %s --generate <rows> <list.csv>\n", argv[0], argv[0]);
+        return 1;
+    }
+    if(run_import(argv[a], a + 1 < argc ? argv[a + 1] : NULL) != 0) return 1;
+    if(compare) run_baseline(argv[a]);
+    return 0;
+}
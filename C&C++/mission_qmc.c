@@ -0,0 +1,193 @@
+/*
+ mission_qmc.c
+ Probability of mission success under vehicle and trajectory dispersions
+
+ Overview:
+  - Each sample perturbs the rocket (Isp, dry mass, staging factor), the
+    target (transfer and capture delta-v) and the payload mass with normal
+    dispersions, then runs evaluate_mission() from mission_core.h.
+  - Two estimators at the same evaluation budget:
+    * Monte Carlo: independent pseudo-random samples, error = s / sqrt(N)
+    * Randomized QMC: R independently scrambled Sobol sequences (sobol.h)
+      of N/R points each; error = spread of the R replicate means / sqrt(R)
+  - A large RQMC run serves as the reference value, and the report shows
+    the actual error of each estimator and how many Monte Carlo samples
+    would be needed to match the RQMC standard error.
+
+ Usage: mission_qmc [rocket] [body] [payload_kg] [max_n]
+        rocket/body are catalog indices (default Starship -> Titan);
+        payload 0 picks the payload with the smallest nominal margin.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "mission_core.h"
+#include "sobol.h"
+
+#define NUM_DISP 6
+#define RQMC_REPLICATES 16
+#define REF_POINTS (1u << 20)
+
+/* 1-sigma dispersions, as fractions of the nominal value */
+static const double sigma[NUM_DISP] = {
+    0.015,  /* Isp */
+    0.030,  /* dry mass */
+    0.020,  /* staging factor */
+    0.040,  /* transfer delta-v */
+    0.060,  /* capture delta-v */
+    0.020   /* payload mass */
+};
+
+/* Outcome of one dispersed mission */
+typedef struct {
+    double success;
+    double margin;
+} Sample;
+
+static Sample evaluate_dispersed(const Mission* base, const double* u) {
+    Mission m = *base;
+    MissionResult res;
+    double z[NUM_DISP];
+    for(int i = 0; i < NUM_DISP; i++) z[i] = sb_norm_inv(u[i]) * sigma[i];
+    m.rocket.isp_avg *= 1.0 + z[0];
+    m.rocket.dry_mass_kg *= 1.0 + z[1];
+    m.rocket.staging_factor *= 1.0 + z[2];
+    m.body.dv_transfer *= 1.0 + z[3];
+    m.body.dv_capture *= 1.0 + z[4];
+    m.payload_kg *= 1.0 + z[5];
+    Sample s;
+    s.success = evaluate_mission(&m, &res) ? 1.0 : 0.0;
+    s.margin = res.final_margin;
+    return s;
+}
+
+typedef struct {
+    double p, p_err;        /* probability of success and its std error */
+    double margin, margin_err;
+} Estimate;
+
+static unsigned long long mc_state = 88172645463325252ull;
+
+static double mc_uniform() {
+    mc_state ^= mc_state << 13;
+    mc_state ^= mc_state >> 7;
+    mc_state ^= mc_state << 17;
+    return ((mc_state >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+Estimate monte_carlo(const Mission* base, unsigned n) {
+    double sp = 0, sp2 = 0, sm = 0, sm2 = 0;
+    double u[NUM_DISP];
+    for(unsigned i = 0; i < n; i++) {
+        for(int d = 0; d < NUM_DISP; d++) u[d] = mc_uniform();
+        Sample s = evaluate_dispersed(base, u);
+        sp += s.success; sp2 += s.success * s.success;
+        sm += s.margin;  sm2 += s.margin * s.margin;
+    }
+    Estimate e;
+    e.p = sp / n;
+    e.margin = sm / n;
+    e.p_err = n > 1 ? sqrt(fmax(sp2 / n - e.p * e.p, 0.0) / (n - 1)) : 0.0;
+    e.margin_err = n > 1 ? sqrt(fmax(sm2 / n - e.margin * e.margin, 0.0) / (n - 1)) : 0.0;
+    return e;
+}
+
+/* R scrambled replicates of n/R points each (total n evaluations) */
+Estimate rqmc(const Mission* base, unsigned n, int replicates, uint64_t seed) {
+    unsigned per = n / (unsigned)replicates;
+    double* pts = malloc(sizeof(double) * NUM_DISP * 4096);
+    double rp[64], rm[64];
+    Estimate e = {0, 0, 0, 0};
+    if(!pts || per == 0 || replicates > 64) { free(pts); return e; }
+    for(int r = 0; r < replicates; r++) {
+        Sobol sb;
+        sobol_init(&sb, NUM_DISP, seed + (uint64_t)r * 7919u + 1u);
+        double sp = 0, sm = 0;
+        for(unsigned done = 0; done < per; ) {
+            unsigned batch = per - done < 4096 ? per - done : 4096;
+            sobol_fill(&sb, pts, batch);
+            for(unsigned i = 0; i < batch; i++) {
+                Sample s = evaluate_dispersed(base, pts + (size_t)i * NUM_DISP);
+                sp += s.success;
+                sm += s.margin;
+            }
+            done += batch;
+        }
+        rp[r] = sp / per;
+        rm[r] = sm / per;
+    }
+    double mp = 0, mm = 0, vp = 0, vm = 0;
+    for(int r = 0; r < replicates; r++) { mp += rp[r]; mm += rm[r]; }
+    mp /= replicates; mm /= replicates;
+    for(int r = 0; r < replicates; r++) {
+        vp += (rp[r] - mp) * (rp[r] - mp);
+        vm += (rm[r] - mm) * (rm[r] - mm);
+    }
+    e.p = mp;
+    e.margin = mm;
+    e.p_err = sqrt(vp / (replicates - 1) / replicates);
+    e.margin_err = sqrt(vm / (replicates - 1) / replicates);
+    free(pts);
+    return e;
+}
+
+/* Payload at which the nominal mission margin is closest to zero */
+double marginal_payload(const Mission* base) {
+    double best = base->rocket.payload_leo_kg, best_abs = 1e30;
+    for(double m = 100.0; m <= base->rocket.payload_leo_kg; m += 100.0) {
+        Mission t = *base;
+        MissionResult res;
+        t.payload_kg = m;
+        evaluate_mission(&t, &res);
+        if(fabs(res.final_margin) < best_abs) { best_abs = fabs(res.final_margin); best = m; }
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    int ri = argc > 1 ? atoi(argv[1]) : 0;
+    int bi = argc > 2 ? atoi(argv[2]) : 2;
+    unsigned max_n = argc > 4 ? (unsigned)atoi(argv[4]) : 65536;
+    if(ri < 0 || ri >= NUM_ROCKETS || bi < 0 || bi >= NUM_BODIES) {
+        printf("Invalid rocket or body index\n");
+        return 1;
+    }
+    Mission base;
+    memset(&base, 0, sizeof(base));
+    base.rocket = rockets[ri];
+    base.body = bodies[bi];
+    base.payload_kg = argc > 3 ? atof(argv[3]) : 0.0;
+    if(base.payload_kg <= 0.0) base.payload_kg = marginal_payload(&base);
+    if(max_n < 1024) max_n = 1024;
+
+    MissionResult nominal;
+    Mission nm = base;
+    evaluate_mission(&nm, &nominal);
+    printf("\n--- MISSION UNCERTAINTY (QMC) ---\n");
+    printf(" %s -> %s, payload %.0f kg\n", base.rocket.name, base.body.name, base.payload_kg);
+    printf(" Nominal margin %.3f km/s (%s)\n", nominal.final_margin, nominal.success ? "success" : "fail");
+
+    clock_t t0 = clock();
+    Estimate ref = rqmc(&base, REF_POINTS, RQMC_REPLICATES, 12345);
+    double t_ref = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    printf(" Reference (RQMC, %u evals, %.2f s): P(success) = %.5f +/- %.5f, E[margin] = %.5f +/- %.6f\n",
+           REF_POINTS, t_ref, ref.p, ref.p_err, ref.margin, ref.margin_err);
+
+    printf("\n %8s | %-37s | %-37s | %s\n", "evals", "P(success): MC (err) / RQMC (err)",
+           "E[margin]: MC (err) / RQMC (err)", "MC evals for RQMC P err");
+    printf(" ---------+---------------------------------------+---------------------------------------+------------------------\n");
+    for(unsigned n = 1024; n <= max_n; n *= 4) {
+        Estimate mc = monte_carlo(&base, n);
+        Estimate q = rqmc(&base, n, RQMC_REPLICATES, n * 31u);
+        /* MC error scales as 1/sqrt(N): samples needed to reach RQMC's error */
+        double equiv = q.p_err > 0 ? n * (mc.p_err / q.p_err) * (mc.p_err / q.p_err) : 0.0;
+        printf(" %8u | %.5f (%.5f) / %.5f (%.5f) | %8.4f (%.5f) / %8.4f (%.5f) | %.0f\n",
+               n, mc.p, mc.p_err, q.p, q.p_err, mc.margin, mc.margin_err, q.margin, q.margin_err, equiv);
+    }
+    printf("\n Errors in brackets are one standard error; RQMC errors come from the\n");
+    printf(" spread of %d independently scrambled replicates.\n", RQMC_REPLICATES);
+    return 0;
+}
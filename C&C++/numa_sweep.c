@@ -0,0 +1,409 @@
+/*
+ numa_sweep.c
+ NUMA-aware capability sweep: pinned workers, node-local data, huge pages
+
+ Overview:
+  - Sweeps margin and feasibility for every rocket/body pair over a large
+    payload grid and stores the results in big arrays, twice:
+    * naive: results allocated and zeroed by the main thread (so they all
+      land on one node), one shared catalog, threads left unpinned
+    * NUMA-aware: each worker is pinned to a core, interleaved across
+      nodes; each node gets its own copy of the catalog, made by a worker
+      on that node; each worker first-touches the slice of the result
+      arrays it will later write, so the pages are local to it
+  - Result arrays can be backed by transparent huge pages (madvise) or
+    explicit hugetlbfs pages (MAP_HUGETLB, falling back to normal pages
+    when none are reserved) to cut TLB misses on large sweeps.
+  - Topology is read from /sys/devices/system/node and intersected with
+    the process affinity mask, so inside a cpuset only permitted CPUs are
+    counted and pinned to; without sysfs the mask is treated as a single
+    node. No libnuma dependency. Workers that fail to pin are counted and
+    reported.
+  - Capability comes from the runtime-dispatched kernel in simd_kernels.h,
+    once per rocket and payload chunk, and is shared by every body.
+  - Hardware counters (perf_counters.h) cover each layout's workers from
+    thread start to join, first touch included, and are reported per
+    result per pass; dTLB misses show what the huge pages buy.
+
+ Usage: numa_sweep [payloads_per_pair] [threads] [passes] [none|thp|hugetlb]
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include "mission_core.h"
+#include "simd_kernels.h"
+#include "perf_counters.h"
+
+#define MAX_NODES 64
+#define MAX_CPUS 1024
+#define HUGE_2M (2u << 20)
+#define SWEEP_CHUNK 256     /* payloads per capability kernel call */
+
+#define HP_NONE 0
+#define HP_THP 1
+#define HP_HUGETLB 2
+
+typedef struct {
+    int num_nodes;
+    int num_cpus[MAX_NODES];
+    int* cpus[MAX_NODES];
+} Topology;
+
+/* Per-node copy of everything the sweep reads */
+typedef struct {
+    Rocket rockets[8];
+    Body bodies[8];
+    double required[8];     /* ascent + transfer + capture per body */
+} Catalog;
+
+typedef struct {
+    double* margin;         /* [pair][payload] */
+    unsigned char* success;
+    size_t bytes_margin, bytes_success;
+    int huge;               /* huge page mode actually in effect */
+} Results;
+
+typedef struct Sweep Sweep;
+
+typedef struct {
+    Sweep* sw;
+    int id;
+    int node;
+    int cpu;                /* -1 when not pinned */
+    int pin_failed;
+    size_t begin, end;      /* payload index range */
+    double seconds;
+} Worker;
+
+struct Sweep {
+    int numa;
+    int nthreads, passes;
+    size_t n;               /* payloads per pair */
+    int pairs;
+    Results res;
+    const Catalog* shared;
+    Catalog* replica[MAX_NODES];
+    /* start gate: a barrier whose count can drop if a worker fails to start */
+    pthread_mutex_t gate_lock;
+    pthread_cond_t gate_cond;
+    int gate_arrived, gate_expected;
+    int abort;
+    Worker* workers;
+};
+
+/* ---------------------------------------------------------------------- */
+/* Topology                                                                */
+/* ---------------------------------------------------------------------- */
+
+/* Parse a sysfs cpulist such as "0-3,8-11" */
+static int parse_cpulist(const char* s, int* out, int max) {
+    int n = 0;
+    while(*s && *s != '\n') {
+        char* end;
+        long a = strtol(s, &end, 10);
+        long b = a;
+        if(end == s) break;
+        s = end;
+        if(*s == '-') b = strtol(s + 1, (char**)&s, 10);
+        for(long c = a; c <= b && n < max; c++) out[n++] = (int)c;
+        if(*s == ',') s++;
+    }
+    return n;
+}
+
+/* Returns 0, or -1 when out of memory */
+int read_topology(Topology* t) {
+    memset(t, 0, sizeof(*t));
+    cpu_set_t allowed;
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        for(int c = 0; c < CPU_SETSIZE; c++) CPU_SET(c, &allowed);
+    }
+    for(int node = 0; node < MAX_NODES; node++) {
+        char path[96], buf[4096];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE* f = fopen(path, "r");
+        if(!f) continue;
+        int ok = fgets(buf, sizeof(buf), f) != NULL;
+        fclose(f);
+        if(!ok) continue;
+        int tmp[MAX_CPUS];
+        int listed = parse_cpulist(buf, tmp, MAX_CPUS), n = 0;
+        for(int i = 0; i < listed; i++)
+            if(tmp[i] < CPU_SETSIZE && CPU_ISSET(tmp[i], &allowed)) tmp[n++] = tmp[i];
+        if(n == 0) continue;    /* memory-only node, or none of its CPUs allowed */
+        int idx = t->num_nodes;
+        t->cpus[idx] = malloc(sizeof(int) * (size_t)n);
+        if(!t->cpus[idx]) return -1;
+        t->num_nodes++;
+        memcpy(t->cpus[idx], tmp, sizeof(int) * (size_t)n);
+        t->num_cpus[idx] = n;
+    }
+    if(t->num_nodes == 0) {
+        int n = 0;
+        t->cpus[0] = malloc(sizeof(int) * MAX_CPUS);
+        if(!t->cpus[0]) return -1;
+        for(int c = 0; c < CPU_SETSIZE && n < MAX_CPUS; c++) if(CPU_ISSET(c, &allowed)) t->cpus[0][n++] = c;
+        t->num_cpus[0] = n;
+        t->num_nodes = 1;
+    }
+    return 0;
+}
+
+static int pin_to_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Memory                                                                  */
+/* ---------------------------------------------------------------------- */
+
+/* Reserve (not touch) a large region, using huge pages if asked */
+static void* big_alloc(size_t bytes, int* huge) {
+    size_t len = (bytes + HUGE_2M - 1) & ~(size_t)(HUGE_2M - 1);
+    void* p = MAP_FAILED;
+    if(*huge == HP_HUGETLB) {
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(p == MAP_FAILED) *huge = HP_THP;     /* no reserved pages: fall back */
+    }
+    if(p == MAP_FAILED) p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED) return NULL;
+    if(*huge == HP_THP && madvise(p, len, MADV_HUGEPAGE) != 0) *huge = HP_NONE;
+    return p;
+}
+
+static void big_free(void* p, size_t bytes) {
+    if(p) munmap(p, (bytes + HUGE_2M - 1) & ~(size_t)(HUGE_2M - 1));
+}
+
+static void fill_catalog(Catalog* c) {
+    memcpy(c->rockets, rockets, sizeof(Rocket) * (size_t)NUM_ROCKETS);
+    memcpy(c->bodies, bodies, sizeof(Body) * (size_t)NUM_BODIES);
+    for(int b = 0; b < NUM_BODIES; b++)
+        c->required[b] = EARTH_ASCENT_COST + bodies[b].dv_transfer + bodies[b].dv_capture;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Sweep                                                                   */
+/* ---------------------------------------------------------------------- */
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sweep_slice(const Catalog* cat, Results* res, size_t n, size_t begin, size_t end) {
+    const SimdKernels* k = sk_kernels();
+    double payload[SWEEP_CHUNK], cap[SWEEP_CHUNK];
+    for(int r = 0; r < NUM_ROCKETS; r++) {
+        const Rocket* rk = &cat->rockets[r];
+        SkRocket sr = {rk->wet_mass_kg, rk->dry_mass_kg, rk->isp_avg * G0 / 1000.0 * rk->staging_factor,
+                       rk->payload_leo_kg};
+        double step = rk->payload_leo_kg / (double)n;
+        for(size_t i = begin; i < end; i += SWEEP_CHUNK) {
+            size_t len = end - i < SWEEP_CHUNK ? end - i : SWEEP_CHUNK;
+            for(size_t j = 0; j < len; j++) payload[j] = step * (double)(i + j);
+            k->capability(payload, len, &sr, cap);
+            for(int b = 0; b < NUM_BODIES; b++) {
+                size_t pair = (size_t)(r * NUM_BODIES + b);
+                double req = cat->required[b];
+                double* m = res->margin + pair * n + i;
+                unsigned char* s = res->success + pair * n + i;
+                for(size_t j = 0; j < len; j++) {
+                    double margin = cap[j] - req;
+                    m[j] = margin;
+                    s[j] = margin >= 0.0;
+                }
+            }
+        }
+    }
+}
+
+static void* worker_main(void* arg) {
+    Worker* w = (Worker*)arg;
+    Sweep* sw = w->sw;
+    if(w->cpu >= 0 && pin_to_cpu(w->cpu) != 0) {
+        w->pin_failed = 1;
+        w->cpu = -1;
+    }
+
+    if(sw->numa) {
+        /* Lowest-numbered worker on each node builds that node's catalog
+           copy; the start gate below publishes it to the others */
+        int first = 1;
+        for(int k = 0; k < w->id; k++) first &= sw->workers[k].node != w->node;
+        if(first) {
+            Catalog* c = malloc(sizeof(Catalog));
+            if(c) fill_catalog(c);
+            sw->replica[w->node] = c;
+        }
+        /* First touch: this worker's slice of every result row */
+        for(int p = 0; p < sw->pairs; p++) {
+            memset(sw->res.margin + (size_t)p * sw->n + w->begin, 0, sizeof(double) * (w->end - w->begin));
+            memset(sw->res.success + (size_t)p * sw->n + w->begin, 0, w->end - w->begin);
+        }
+    }
+    pthread_mutex_lock(&sw->gate_lock);
+    sw->gate_arrived++;
+    pthread_cond_broadcast(&sw->gate_cond);
+    while(sw->gate_arrived < sw->gate_expected) pthread_cond_wait(&sw->gate_cond, &sw->gate_lock);
+    int abort_run = sw->abort;
+    pthread_mutex_unlock(&sw->gate_lock);
+    if(abort_run) return NULL;
+    const Catalog* cat = sw->numa && sw->replica[w->node] ? sw->replica[w->node] : sw->shared;
+
+    double t0 = now_sec();
+    for(int pass = 0; pass < sw->passes; pass++) sweep_slice(cat, &sw->res, sw->n, w->begin, w->end);
+    w->seconds = now_sec() - t0;
+    return NULL;
+}
+
+static double run_sweep(const Topology* topo, int numa, int nthreads, size_t n, int passes, int huge,
+                        int* huge_used, int* pin_failures, double* checksum, PerfCounters* pc, PcSample* ps) {
+    Sweep sw;
+    memset(&sw, 0, sizeof(sw));
+    sw.numa = numa;
+    sw.nthreads = nthreads;
+    sw.passes = passes;
+    sw.n = n;
+    sw.pairs = NUM_ROCKETS * NUM_BODIES;
+    sw.res.bytes_margin = sizeof(double) * n * (size_t)sw.pairs;
+    sw.res.bytes_success = n * (size_t)sw.pairs;
+    sw.res.huge = huge;
+    sw.res.margin = big_alloc(sw.res.bytes_margin, &sw.res.huge);
+    sw.res.success = big_alloc(sw.res.bytes_success, &sw.res.huge);
+    *huge_used = sw.res.huge;
+    Catalog* shared = malloc(sizeof(Catalog));
+    sw.workers = calloc((size_t)nthreads, sizeof(Worker));
+    pthread_t* tids = malloc(sizeof(pthread_t) * (size_t)nthreads);
+    if(!sw.res.margin || !sw.res.success || !shared || !sw.workers || !tids) {
+        printf("out of memory\n");
+        exit(1);
+    }
+    fill_catalog(shared);
+    sw.shared = shared;
+    if(!numa) {
+        /* Naive layout: the main thread touches everything */
+        memset(sw.res.margin, 0, sw.res.bytes_margin);
+        memset(sw.res.success, 0, sw.res.bytes_success);
+    }
+
+    pthread_mutex_init(&sw.gate_lock, NULL);
+    pthread_cond_init(&sw.gate_cond, NULL);
+    sw.gate_expected = nthreads;
+    for(int t = 0; t < nthreads; t++) {
+        Worker* w = &sw.workers[t];
+        w->sw = &sw;
+        w->id = t;
+        /* Interleave workers across nodes, then across each node's cores */
+        w->node = numa ? t % topo->num_nodes : 0;
+        w->cpu = numa ? topo->cpus[w->node][(t / topo->num_nodes) % topo->num_cpus[w->node]] : -1;
+        w->begin = n * (size_t)t / (size_t)nthreads;
+        w->end = n * (size_t)(t + 1) / (size_t)nthreads;
+    }
+    pc_start(pc, ps);
+    int started = 0;
+    while(started < nthreads && pthread_create(&tids[started], NULL, worker_main, &sw.workers[started]) == 0)
+        started++;
+    if(started < nthreads) {
+        /* Release the workers already waiting at the gate and stop them */
+        pthread_mutex_lock(&sw.gate_lock);
+        sw.abort = 1;
+        sw.gate_expected = started;
+        pthread_cond_broadcast(&sw.gate_cond);
+        pthread_mutex_unlock(&sw.gate_lock);
+    }
+    double slowest = 0.0;
+    *pin_failures = 0;
+    for(int t = 0; t < started; t++) {
+        pthread_join(tids[t], NULL);
+        if(sw.workers[t].seconds > slowest) slowest = sw.workers[t].seconds;
+        *pin_failures += sw.workers[t].pin_failed;
+    }
+    pc_stop(pc, ps);
+    if(started < nthreads) {
+        printf("cannot start worker thread %d of %d\n", started + 1, nthreads);
+        exit(1);
+    }
+
+    double sum = 0.0;
+    for(size_t i = 0; i < n * (size_t)sw.pairs; i += 4099) sum += sw.res.margin[i] + sw.res.success[i];
+    *checksum = sum;
+
+    pthread_cond_destroy(&sw.gate_cond);
+    pthread_mutex_destroy(&sw.gate_lock);
+    for(int k = 0; k < MAX_NODES; k++) free(sw.replica[k]);
+    free(shared);
+    free(sw.workers);
+    free(tids);
+    big_free(sw.res.margin, sw.res.bytes_margin);
+    big_free(sw.res.success, sw.res.bytes_success);
+    return slowest;
+}
+
+int main(int argc, char** argv) {
+    Topology topo;
+    if(read_topology(&topo) != 0) {
+        printf("out of memory\n");
+        return 1;
+    }
+    int all_cpus = 0;
+    for(int k = 0; k < topo.num_nodes; k++) all_cpus += topo.num_cpus[k];
+
+    size_t n = argc > 1 ? (size_t)atol(argv[1]) : 2000000;
+    int nthreads = argc > 2 ? atoi(argv[2]) : all_cpus;
+    int passes = argc > 3 ? atoi(argv[3]) : 5;
+    int huge = HP_NONE;
+    if(argc > 4 && strcmp(argv[4], "thp") == 0) huge = HP_THP;
+    if(argc > 4 && strcmp(argv[4], "hugetlb") == 0) huge = HP_HUGETLB;
+    if(n < 1024) n = 1024;
+    if(nthreads < 1) nthreads = 1;
+    if(passes < 1) passes = 1;
+    if(NUM_ROCKETS > 8 || NUM_BODIES > 8) { printf("catalog too large\n"); return 1; }
+
+    static const char* hp_names[] = {"none", "thp", "hugetlb"};
+    size_t cells = n * (size_t)(NUM_ROCKETS * NUM_BODIES);
+    printf("\n--- NUMA SWEEP ---\n");
+    printf(" Nodes: %d | CPUs: %d | threads: %d | results: %zu (%.0f MiB) | passes: %d | kernels: %s\n",
+           topo.num_nodes, all_cpus, nthreads, cells, cells * 9.0 / (1 << 20), passes, cd_isa_name(sk_kernels()->isa));
+
+    double c1, c2;
+    int h1, h2, pf1, pf2;
+    PerfCounters pc;
+    PcSample ps[2];
+    pc_open(&pc);
+    double t_naive = run_sweep(&topo, 0, nthreads, n, passes, HP_NONE, &h1, &pf1, &c1, &pc, &ps[0]);
+    double t_numa = run_sweep(&topo, 1, nthreads, n, passes, huge, &h2, &pf2, &c2, &pc, &ps[1]);
+    printf(" %-34s %8.3f s  %7.1f M results/s\n", "naive (shared, unpinned)", t_naive,
+           cells * (double)passes / t_naive / 1e6);
+    printf(" %-23s pages=%-5s %8.3f s  %7.1f M results/s  (%.2fx)\n",
+           pf2 == 0 ? "NUMA-aware (pinned)" : pf2 < nthreads ? "NUMA-aware (part pin)" : "NUMA-aware (unpinned)",
+           hp_names[h2], t_numa,
+           cells * (double)passes / t_numa / 1e6, t_naive / t_numa);
+    if(fabs(c1 - c2) > 1e-6 * fabs(c1)) printf(" WARNING: results differ between layouts\n");
+    if(pf2 > 0) printf(" Note: %d of %d workers could not be pinned to their CPU\n", pf2, nthreads);
+    if(huge != h2) printf(" Note: requested %s pages were not available, used %s\n", hp_names[huge], hp_names[h2]);
+
+    printf("\n");
+    pc_print_status(stdout, &pc);
+    printf("Counter rows: per result per pass, thread start to join (first touch included)\n");
+    pc_print_header(stdout, 12);
+    pc_print_row(stdout, 12, "naive", &ps[0], cells * (double)passes);
+    pc_print_row(stdout, 12, "NUMA-aware", &ps[1], cells * (double)passes);
+    pc_close(&pc);
+
+    for(int k = 0; k < topo.num_nodes; k++) free(topo.cpus[k]);
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ orbit_elements.h
+ Batch conversions between Cartesian states and orbital elements
+
+ Overview:
+  - Cartesian <-> classical (a, e, i, RAAN, argument of periapsis, true
+    anomaly) and Cartesian <-> modified equinoctial (p, f, g, h, k, L)
+    on structure-of-arrays batches (StateSoA from kepler_batch.h).
+  - Classical elements are undefined for circular and/or equatorial orbits.
+    Instead of branching, every state picks a node direction (the x axis
+    when equatorial) and a periapsis direction (the node when circular), so:
+    * circular inclined:   argp = 0, nu = argument of latitude
+    * elliptic equatorial: RAAN = 0, argp = longitude of periapsis
+    * circular equatorial: RAAN = argp = 0, nu = true longitude
+    and the reverse conversion reproduces the same state.
+  - Modified equinoctial elements have no circular or equatorial
+    singularity. Their remaining one at i = 180 deg is avoided with the
+    retrograde factor: states with negative h_z use fr = -1, which swaps
+    tan(i/2) for cot(i/2) and flips the frame so i = 180 deg becomes regular.
+  - Loops are straight-line with selects instead of branches, so they
+    auto-vectorise like the Kepler kernels
+    (gcc -O3 -march=native -ffast-math with glibc's vector libm).
+
+ Units are whatever mu uses; angles are radians in [0, 2*pi).
+*/
+
+#ifndef ORBIT_ELEMENTS_H
+#define ORBIT_ELEMENTS_H
+
+#include <math.h>
+#include <stddef.h>
+#include "kepler_batch.h"
+
+#define OE_EPS 1e-11            /* e and sin(i) below this count as zero */
+
+typedef struct {
+    double* a;                  /* semi-major axis (negative for hyperbolas) */
+    double* e;
+    double* i;
+    double* raan;
+    double* argp;
+    double* nu;
+} ClassicalSoA;
+
+typedef struct {
+    double* p;                  /* semi-latus rectum */
+    double* f;                  /* e cos(argp + raan) */
+    double* g;                  /* e sin(argp + raan) */
+    double* h;                  /* tan(i/2)^fr cos(raan) */
+    double* k;                  /* tan(i/2)^fr sin(raan) */
+    double* L;                  /* true longitude, measured in the equinoctial frame */
+    double* fr;                 /* retrograde factor, +1 or -1 */
+} EquinoctialSoA;
+
+static inline double oe_wrap(double a) {
+    return a < 0.0 ? a + 2.0 * KB_PI : a;
+}
+
+/* Equinoctial frame vectors f and g for (h, k) and retrograde factor fr */
+static inline void oe_frame(double h, double k, double fr, double* f, double* g) {
+    double is2 = 1.0 / (1.0 + h * h + k * k);
+    f[0] = (1.0 - k * k + h * h) * is2;
+    f[1] = 2.0 * h * k * is2;
+    f[2] = -2.0 * fr * k * is2;
+    g[0] = 2.0 * fr * h * k * is2;
+    g[1] = fr * (1.0 + k * k - h * h) * is2;
+    g[2] = 2.0 * h * is2;
+}
+
+/* Cartesian -> classical elements */
+static inline void cart_to_classical_batch(double mu, const StateSoA* s, ClassicalSoA* o, size_t n) {
+    for(size_t j = 0; j < n; j++) {
+        double rx = s->x[j], ry = s->y[j], rz = s->z[j];
+        double vx = s->vx[j], vy = s->vy[j], vz = s->vz[j];
+        double r = sqrt(rx * rx + ry * ry + rz * rz);
+        double v2 = vx * vx + vy * vy + vz * vz;
+        double rv = rx * vx + ry * vy + rz * vz;
+
+        /* Angular momentum and its unit vector */
+        double hx = ry * vz - rz * vy, hy = rz * vx - rx * vz, hz = rx * vy - ry * vx;
+        double hm = sqrt(hx * hx + hy * hy + hz * hz);
+        double ux = hx / hm, uy = hy / hm, uz = hz / hm;
+
+        /* Eccentricity vector */
+        double c1 = v2 / mu - 1.0 / r, c2 = rv / mu;
+        double ex = c1 * rx - c2 * vx, ey = c1 * ry - c2 * vy, ez = c1 * rz - c2 * vz;
+        double e = sqrt(ex * ex + ey * ey + ez * ez);
+
+        /* Node direction, x axis when equatorial */
+        double nxy = sqrt(hx * hx + hy * hy);
+        int equatorial = nxy <= OE_EPS * hm;
+        double Nx = equatorial ? 1.0 : -hy / nxy;
+        double Ny = equatorial ? 0.0 : hx / nxy;
+
+        /* Periapsis direction, the node when circular */
+        int circular = e <= OE_EPS;
+        double Px = circular ? Nx : ex / e;
+        double Py = circular ? Ny : ey / e;
+        double Pz = circular ? 0.0 : ez / e;
+
+        o->a[j] = 1.0 / (2.0 / r - v2 / mu);
+        o->e[j] = e;
+        o->i[j] = atan2(nxy, hz);
+        o->raan[j] = oe_wrap(atan2(Ny, Nx));
+        /* Angle from N to P and from P to r, measured about h */
+        double sa = (Ny * Pz) * ux - (Nx * Pz) * uy + (Nx * Py - Ny * Px) * uz;
+        o->argp[j] = oe_wrap(atan2(sa, Nx * Px + Ny * Py));
+        double sn = (Py * rz - Pz * ry) * ux + (Pz * rx - Px * rz) * uy + (Px * ry - Py * rx) * uz;
+        o->nu[j] = oe_wrap(atan2(sn, Px * rx + Py * ry + Pz * rz));
+    }
+}
+
+/* Classical elements -> Cartesian (not defined for exactly parabolic a) */
+static inline void classical_to_cart_batch(double mu, const ClassicalSoA* o, StateSoA* s, size_t n) {
+    for(size_t j = 0; j < n; j++) {
+        double e = o->e[j];
+        double p = o->a[j] * (1.0 - e * e);
+        double cn = cos(o->nu[j]), sn = sin(o->nu[j]);
+        double r = p / (1.0 + e * cn);
+        double sp = sqrt(mu / p);
+        /* Perifocal position and velocity */
+        double xp = r * cn, yp = r * sn;
+        double vxp = -sp * sn, vyp = sp * (e + cn);
+
+        double cO = cos(o->raan[j]), sO = sin(o->raan[j]);
+        double cw = cos(o->argp[j]), sw = sin(o->argp[j]);
+        double ci = cos(o->i[j]), si = sin(o->i[j]);
+        /* Columns of R3(-raan) R1(-i) R3(-argp) */
+        double P0 = cO * cw - sO * sw * ci, P1 = sO * cw + cO * sw * ci, P2 = sw * si;
+        double Q0 = -cO * sw - sO * cw * ci, Q1 = -sO * sw + cO * cw * ci, Q2 = cw * si;
+
+        s->x[j] = P0 * xp + Q0 * yp;
+        s->y[j] = P1 * xp + Q1 * yp;
+        s->z[j] = P2 * xp + Q2 * yp;
+        s->vx[j] = P0 * vxp + Q0 * vyp;
+        s->vy[j] = P1 * vxp + Q1 * vyp;
+        s->vz[j] = P2 * vxp + Q2 * vyp;
+    }
+}
+
+/* Cartesian -> modified equinoctial elements */
+static inline void cart_to_equinoctial_batch(double mu, const StateSoA* s, EquinoctialSoA* o, size_t n) {
+    for(size_t j = 0; j < n; j++) {
+        double rx = s->x[j], ry = s->y[j], rz = s->z[j];
+        double vx = s->vx[j], vy = s->vy[j], vz = s->vz[j];
+        double r = sqrt(rx * rx + ry * ry + rz * rz);
+        double v2 = vx * vx + vy * vy + vz * vz;
+        double rv = rx * vx + ry * vy + rz * vz;
+        double hx = ry * vz - rz * vy, hy = rz * vx - rx * vz, hz = rx * vy - ry * vx;
+        double hm2 = hx * hx + hy * hy + hz * hz;
+        double hm = sqrt(hm2);
+
+        double fr = hz >= 0.0 ? 1.0 : -1.0;
+        double den = hm + fr * hz;      /* hm * (1 + |cos i|) */
+        double h = -hy / den, k = hx / den;
+        double F[3], G[3];
+        oe_frame(h, k, fr, F, G);
+
+        double c1 = v2 / mu - 1.0 / r, c2 = rv / mu;
+        double ex = c1 * rx - c2 * vx, ey = c1 * ry - c2 * vy, ez = c1 * rz - c2 * vz;
+
+        o->p[j] = hm2 / mu;
+        o->f[j] = ex * F[0] + ey * F[1] + ez * F[2];
+        o->g[j] = ex * G[0] + ey * G[1] + ez * G[2];
+        o->h[j] = h;
+        o->k[j] = k;
+        o->fr[j] = fr;
+        o->L[j] = oe_wrap(atan2(rx * G[0] + ry * G[1] + rz * G[2], rx * F[0] + ry * F[1] + rz * F[2]));
+    }
+}
+
+/* Modified equinoctial elements -> Cartesian */
+static inline void equinoctial_to_cart_batch(double mu, const EquinoctialSoA* o, StateSoA* s, size_t n) {
+    for(size_t j = 0; j < n; j++) {
+        double p = o->p[j], f = o->f[j], g = o->g[j];
+        double cL = cos(o->L[j]), sL = sin(o->L[j]);
+        double F[3], G[3];
+        oe_frame(o->h[j], o->k[j], o->fr[j], F, G);
+        double r = p / (1.0 + f * cL + g * sL);
+        double sp = sqrt(mu / p);
+        /* r = r (cos L F + sin L G), v = sqrt(mu/p) (-(sin L + g) F + (cos L + f) G) */
+        double a1 = r * cL, b1 = r * sL;
+        double a2 = -sp * (sL + g), b2 = sp * (cL + f);
+
+        s->x[j] = a1 * F[0] + b1 * G[0];
+        s->y[j] = a1 * F[1] + b1 * G[1];
+        s->z[j] = a1 * F[2] + b1 * G[2];
+        s->vx[j] = a2 * F[0] + b2 * G[0];
+        s->vy[j] = a2 * F[1] + b2 * G[1];
+        s->vz[j] = a2 * F[2] + b2 * G[2];
+    }
+}
+
+#endif /* ORBIT_ELEMENTS_H */
@@ -0,0 +1,160 @@
+/*
+ orbit_elements_bench.c
+ Accuracy and throughput check for orbit_elements.h
+
+ Builds random heliocentric states in six classes (general elliptic,
+ hyperbolic, exactly circular, exactly equatorial, circular equatorial and
+ retrograde equatorial), converts them to classical and equinoctial
+ elements and back, and reports the worst round-trip error per class and
+ conversions per second for each kernel, followed by hardware counters per
+ conversion where perf_event_open() allows them.
+
+ Build: gcc -O3 -march=native -ffast-math orbit_elements_bench.c -o orbit_elements_bench -lm
+ Usage: orbit_elements_bench [count] [repeats]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "orbit_elements.h"
+#include "perf_counters.h"
+
+#define MU_SUN 1.32712440018e11     /* km^3/s^2 */
+#define AU_KM 1.495978707e8
+#define NUM_CLASSES 6
+
+static const char* class_names[NUM_CLASSES] = {
+    "elliptic", "hyperbolic", "circular", "equatorial", "circ+equatorial", "retro equatorial"
+};
+
+static double frand(unsigned* s) {
+    *s = *s * 1664525u + 1013904223u;
+    return (*s >> 8) / 16777216.0;
+}
+
+/* Each SoA takes one allocation, freed through its first member */
+static int alloc_state(StateSoA* s, size_t n) {
+    double* block = malloc(sizeof(double) * n * 6);
+    if(!block) return -1;
+    s->x = block; s->y = block + n; s->z = block + 2 * n;
+    s->vx = block + 3 * n; s->vy = block + 4 * n; s->vz = block + 5 * n;
+    return 0;
+}
+
+static int alloc_classical(ClassicalSoA* c, size_t n) {
+    double* block = malloc(sizeof(double) * n * 6);
+    if(!block) return -1;
+    c->a = block; c->e = block + n; c->i = block + 2 * n;
+    c->raan = block + 3 * n; c->argp = block + 4 * n; c->nu = block + 5 * n;
+    return 0;
+}
+
+static int alloc_equinoctial(EquinoctialSoA* q, size_t n) {
+    double* block = malloc(sizeof(double) * n * 7);
+    if(!block) return -1;
+    q->p = block; q->f = block + n; q->g = block + 2 * n; q->h = block + 3 * n;
+    q->k = block + 4 * n; q->L = block + 5 * n; q->fr = block + 6 * n;
+    return 0;
+}
+
+/* Relative position and velocity error between two states */
+static void state_error(const StateSoA* a, const StateSoA* b, size_t i, double* ep, double* ev) {
+    double dx = a->x[i] - b->x[i], dy = a->y[i] - b->y[i], dz = a->z[i] - b->z[i];
+    double dvx = a->vx[i] - b->vx[i], dvy = a->vy[i] - b->vy[i], dvz = a->vz[i] - b->vz[i];
+    double r = sqrt(a->x[i] * a->x[i] + a->y[i] * a->y[i] + a->z[i] * a->z[i]);
+    double v = sqrt(a->vx[i] * a->vx[i] + a->vy[i] * a->vy[i] + a->vz[i] * a->vz[i]);
+    *ep = sqrt(dx * dx + dy * dy + dz * dz) / r;
+    *ev = sqrt(dvx * dvx + dvy * dvy + dvz * dvz) / v;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? (size_t)atol(argv[1]) : 1000000;
+    int repeats = argc > 2 ? atoi(argv[2]) : 5;
+    if(n < NUM_CLASSES) n = NUM_CLASSES;
+    StateSoA s0, s1, s2;
+    ClassicalSoA ce;
+    EquinoctialSoA ee;
+    int* cls = malloc(sizeof(int) * n);
+    if(!cls || alloc_state(&s0, n) || alloc_state(&s1, n) || alloc_state(&s2, n) ||
+       alloc_classical(&ce, n) || alloc_equinoctial(&ee, n)) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    /* Generate from elements so the special classes are exact; hyperbolic
+       states have e in (1, 3) and |nu| inside the asymptotes */
+    unsigned seed = 42;
+    for(size_t j = 0; j < n; j++) {
+        int c = (int)(j % NUM_CLASSES);
+        cls[j] = c;
+        double e = c == 1 ? 1.0 + 2.0 * frand(&seed) : 0.95 * frand(&seed);
+        double rp = (0.3 + 9.7 * frand(&seed)) * AU_KM;
+        double inc = KB_PI * frand(&seed);
+        if(c == 2 || c == 4) e = 0.0;
+        if(c == 3 || c == 4) inc = 0.0;
+        if(c == 5) inc = KB_PI;
+        ce.a[j] = rp / (1.0 - e);
+        ce.e[j] = e;
+        ce.i[j] = inc;
+        ce.raan[j] = 2.0 * KB_PI * frand(&seed);
+        ce.argp[j] = 2.0 * KB_PI * frand(&seed);
+        double numax = e > 1.0 ? acos(-1.0 / e) * 0.95 : KB_PI;
+        ce.nu[j] = oe_wrap((2.0 * frand(&seed) - 1.0) * numax);
+    }
+    classical_to_cart_batch(MU_SUN, &ce, &s0, n);
+
+    /* Round trips */
+    cart_to_classical_batch(MU_SUN, &s0, &ce, n);
+    classical_to_cart_batch(MU_SUN, &ce, &s1, n);
+    cart_to_equinoctial_batch(MU_SUN, &s0, &ee, n);
+    equinoctial_to_cart_batch(MU_SUN, &ee, &s2, n);
+
+    double wc[NUM_CLASSES][2] = {{0}}, we[NUM_CLASSES][2] = {{0}};
+    for(size_t j = 0; j < n; j++) {
+        double ep, ev;
+        int c = cls[j];
+        state_error(&s0, &s1, j, &ep, &ev);
+        if(!(ep <= wc[c][0])) wc[c][0] = ep;
+        if(!(ev <= wc[c][1])) wc[c][1] = ev;
+        state_error(&s0, &s2, j, &ep, &ev);
+        if(!(ep <= we[c][0])) we[c][0] = ep;
+        if(!(ev <= we[c][1])) we[c][1] = ev;
+    }
+    printf("States: %zu\n", n);
+    printf("Worst relative round-trip error   classical (pos / vel)   equinoctial (pos / vel)\n");
+    for(int c = 0; c < NUM_CLASSES; c++) {
+        printf("  %-18s %14.3e %10.3e %14.3e %10.3e\n", class_names[c], wc[c][0], wc[c][1], we[c][0], we[c][1]);
+    }
+
+    PerfCounters pc;
+    PcSample ps[4];
+    pc_open(&pc);
+    pc_start(&pc, &ps[0]);
+    for(int k = 0; k < repeats; k++) cart_to_classical_batch(MU_SUN, &s0, &ce, n);
+    pc_stop(&pc, &ps[0]);
+    pc_start(&pc, &ps[1]);
+    for(int k = 0; k < repeats; k++) classical_to_cart_batch(MU_SUN, &ce, &s1, n);
+    pc_stop(&pc, &ps[1]);
+    pc_start(&pc, &ps[2]);
+    for(int k = 0; k < repeats; k++) cart_to_equinoctial_batch(MU_SUN, &s0, &ee, n);
+    pc_stop(&pc, &ps[2]);
+    pc_start(&pc, &ps[3]);
+    for(int k = 0; k < repeats; k++) equinoctial_to_cart_batch(MU_SUN, &ee, &s2, n);
+    pc_stop(&pc, &ps[3]);
+    static const char* kernels[4] = {"cart -> classical", "classical -> cart", "cart -> equinoctial", "equinoctial -> cart"};
+    printf("Throughput:\n");
+    for(int k = 0; k < 4; k++) {
+        printf("  %-20s %7.1f M/s (%.1f ns/state)\n", kernels[k],
+               n * (double)repeats / ps[k].seconds / 1e6, ps[k].seconds * 1e9 / (n * (double)repeats));
+    }
+    pc_print_status(stdout, &pc);
+    pc_print_header(stdout, 20);
+    for(int k = 0; k < 4; k++) pc_print_row(stdout, 20, kernels[k], &ps[k], n * (double)repeats);
+    pc_close(&pc);
+
+    free(s0.x); free(s1.x); free(s2.x);
+    free(ce.a); free(ee.p);
+    free(cls);
+    return 0;
+}
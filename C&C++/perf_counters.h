@@ -0,0 +1,243 @@
+/*
+ perf_counters.h
+ Hardware performance counters around benchmark cases
+
+ Overview:
+  - Counts cycles, instructions, cache misses (last level), branch misses
+    and data TLB misses with perf_event_open() while a benchmark case
+    runs, and prints them per operation next to ns/op.
+  - Each event is opened on its own rather than as a group: if the PMU
+    has fewer counters than events the kernel multiplexes them, and the
+    counts are scaled by time enabled / time running (rows measured that
+    way are marked '~').
+  - Counters are opened with inherit set, so threads the case starts
+    after pc_open() are counted too (once they have been joined). Counts
+    are start/stop deltas: PERF_EVENT_IOC_RESET does not clear the totals
+    already folded in from exited threads.
+  - Graceful degradation: events the kernel refuses (no PMU in a VM or
+    container, seccomp, perf_event_paranoid) are reported as n/a and the
+    benchmark still runs; pc_open() records why in pc->reason.
+    PERF_COUNTERS=0 turns collection off; non-Linux builds always get n/a.
+  - Typical use:
+      PerfCounters pc;  pc_open(&pc);
+      pc_print_header(stdout, 20);
+      pc_start(&pc, &sample);  ... run case ...;  pc_stop(&pc, &sample);
+      pc_add(&total, &sample);      (optional, to sum several runs)
+      pc_print_row(stdout, 20, "case", &sample, ops);
+      pc_close(&pc);
+*/
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+typedef enum {
+    PC_CYCLES,
+    PC_INSTRUCTIONS,
+    PC_CACHE_MISSES,
+    PC_BRANCH_MISSES,
+    PC_DTLB_MISSES,
+    PC_NUM_EVENTS
+} PcEvent;
+
+static const char* pc_event_names[PC_NUM_EVENTS] = {"cycles", "instructions", "cache-misses", "branch-misses",
+                                                    "dTLB-misses"};
+
+typedef struct {
+    int fd[PC_NUM_EVENTS];          /* -1 when the event is unavailable */
+    int available;                  /* number of events that opened */
+    char reason[96];                /* why the first unavailable event failed */
+    uint64_t base[PC_NUM_EVENTS][3];    /* readings at pc_start() */
+} PerfCounters;
+
+/* One measurement; counts are already scaled for multiplexing */
+typedef struct {
+    double seconds;
+    double count[PC_NUM_EVENTS];
+    int valid[PC_NUM_EVENTS];
+    int scaled;                     /* some event ran for only part of the case */
+} PcSample;
+
+static inline double pc_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#ifdef __linux__
+static inline void pc_event_attr(PcEvent e, struct perf_event_attr* a) {
+    memset(a, 0, sizeof(*a));
+    a->size = sizeof(*a);
+    a->type = PERF_TYPE_HARDWARE;
+    a->disabled = 1;
+    a->inherit = 1;
+    a->exclude_kernel = 1;          /* allowed at perf_event_paranoid 2 */
+    a->exclude_hv = 1;
+    a->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch(e) {
+    case PC_CYCLES: a->config = PERF_COUNT_HW_CPU_CYCLES; break;
+    case PC_INSTRUCTIONS: a->config = PERF_COUNT_HW_INSTRUCTIONS; break;
+    case PC_CACHE_MISSES: a->config = PERF_COUNT_HW_CACHE_MISSES; break;
+    case PC_BRANCH_MISSES: a->config = PERF_COUNT_HW_BRANCH_MISSES; break;
+    default:
+        a->type = PERF_TYPE_HW_CACHE;
+        a->config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    }
+}
+#endif
+
+/* Open every event for the calling thread (and threads it starts later).
+   Returns the number of events available; 0 is not an error. */
+static inline int pc_open(PerfCounters* pc) {
+    pc->available = 0;
+    snprintf(pc->reason, sizeof(pc->reason), "ok");
+    for(int e = 0; e < PC_NUM_EVENTS; e++) pc->fd[e] = -1;
+    const char* env = getenv("PERF_COUNTERS");
+    if(env && strcmp(env, "0") == 0) {
+        snprintf(pc->reason, sizeof(pc->reason), "disabled by PERF_COUNTERS=0");
+        return 0;
+    }
+#ifdef __linux__
+    for(int e = 0; e < PC_NUM_EVENTS; e++) {
+        struct perf_event_attr a;
+        pc_event_attr((PcEvent)e, &a);
+        long fd = syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+        if(fd < 0) {
+            if(pc->available == e) {    /* keep the first failure */
+                const char* why = errno == ENOENT || errno == EOPNOTSUPP ? "no such PMU event (VM or container?)"
+                                  : errno == EACCES || errno == EPERM    ? "not permitted, see perf_event_paranoid"
+                                  : errno == ENOSYS                      ? "perf_event_open not available"
+                                                                         : strerror(errno);
+                snprintf(pc->reason, sizeof(pc->reason), "%s: %s", pc_event_names[e], why);
+            }
+            continue;
+        }
+        pc->fd[e] = (int)fd;
+        pc->available++;
+    }
+#else
+    snprintf(pc->reason, sizeof(pc->reason), "perf_event_open is Linux only");
+#endif
+    return pc->available;
+}
+
+static inline void pc_close(PerfCounters* pc) {
+#ifdef __linux__
+    for(int e = 0; e < PC_NUM_EVENTS; e++)
+        if(pc->fd[e] >= 0) close(pc->fd[e]);
+#endif
+    for(int e = 0; e < PC_NUM_EVENTS; e++) pc->fd[e] = -1;
+    pc->available = 0;
+}
+
+/* Summary line for benchmark preambles */
+static inline void pc_print_status(FILE* out, const PerfCounters* pc) {
+    fprintf(out, "Hardware counters: %d/%d available", pc->available, (int)PC_NUM_EVENTS);
+    if(pc->available < PC_NUM_EVENTS) fprintf(out, " (%s)", pc->reason);
+    fprintf(out, "\n");
+}
+
+#ifdef __linux__
+/* value, time enabled, time running */
+static inline int pc_read(int fd, uint64_t v[3]) {
+    return read(fd, v, 3 * sizeof(uint64_t)) == (ssize_t)(3 * sizeof(uint64_t)) ? 0 : -1;
+}
+#endif
+
+static inline void pc_start(PerfCounters* pc, PcSample* s) {
+    memset(s, 0, sizeof(*s));
+#ifdef __linux__
+    for(int e = 0; e < PC_NUM_EVENTS; e++) {
+        if(pc->fd[e] < 0) continue;
+        if(pc_read(pc->fd[e], pc->base[e]) != 0) memset(pc->base[e], 0, sizeof(pc->base[e]));
+        ioctl(pc->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)pc;
+#endif
+    s->seconds = pc_now();
+}
+
+static inline void pc_stop(PerfCounters* pc, PcSample* s) {
+    s->seconds = pc_now() - s->seconds;
+#ifdef __linux__
+    for(int e = 0; e < PC_NUM_EVENTS; e++)
+        if(pc->fd[e] >= 0) ioctl(pc->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    for(int e = 0; e < PC_NUM_EVENTS; e++) {
+        uint64_t v[3];
+        if(pc->fd[e] < 0 || pc_read(pc->fd[e], v) != 0) continue;
+        for(int k = 0; k < 3; k++) v[k] -= pc->base[e][k];
+        if(v[2] == 0) continue;     /* never scheduled on the PMU */
+        s->count[e] = (double)v[0];
+        if(v[2] < v[1]) {
+            s->count[e] *= (double)v[1] / (double)v[2];
+            s->scaled = 1;
+        }
+        s->valid[e] = 1;
+    }
+#else
+    (void)pc;
+#endif
+}
+
+/* Adds one sample into a running total (start the total zeroed) */
+static inline void pc_add(PcSample* total, const PcSample* s) {
+    total->seconds += s->seconds;
+    for(int e = 0; e < PC_NUM_EVENTS; e++) {
+        if(!s->valid[e]) continue;
+        total->count[e] += s->count[e];
+        total->valid[e] = 1;
+    }
+    total->scaled |= s->scaled;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Per-operation report                                                    */
+/* ---------------------------------------------------------------------- */
+
+static inline void pc_print_header(FILE* out, int label_width) {
+    fprintf(out, " %-*s %10s %10s %10s %6s %10s %10s %10s\n", label_width, "per op", "ns", "cycles", "instr", "IPC",
+            "LLC-miss", "br-miss", "dTLB-miss");
+}
+
+static inline void pc_print_cell(FILE* out, int width, const PcSample* s, PcEvent e, double ops, const char* fmt) {
+    if(!s->valid[e]) {
+        fprintf(out, " %*s", width, "n/a");
+        return;
+    }
+    char cell[32];
+    snprintf(cell, sizeof(cell), fmt, s->count[e] / ops);
+    fprintf(out, " %*s", width, cell);
+}
+
+/* One row of ns, counters and IPC divided by ops; '~' marks scaled rows */
+static inline void pc_print_row(FILE* out, int label_width, const char* label, const PcSample* s, double ops) {
+    if(ops <= 0) ops = 1;
+    fprintf(out, "%c%-*s %10.2f", s->scaled ? '~' : ' ', label_width, label, s->seconds * 1e9 / ops);
+    pc_print_cell(out, 10, s, PC_CYCLES, ops, "%.2f");
+    pc_print_cell(out, 10, s, PC_INSTRUCTIONS, ops, "%.2f");
+    if(s->valid[PC_CYCLES] && s->valid[PC_INSTRUCTIONS] && s->count[PC_CYCLES] > 0)
+        fprintf(out, " %6.2f", s->count[PC_INSTRUCTIONS] / s->count[PC_CYCLES]);
+    else
+        fprintf(out, " %6s", "n/a");
+    pc_print_cell(out, 10, s, PC_CACHE_MISSES, ops, "%.4f");
+    pc_print_cell(out, 10, s, PC_BRANCH_MISSES, ops, "%.4f");
+    pc_print_cell(out, 10, s, PC_DTLB_MISSES, ops, "%.4f");
+    fprintf(out, "\n");
+}
+
+#endif /* PERF_COUNTERS_H */
@@ -0,0 +1,388 @@
+/*
+ pipeline.h
+ Staged batch pipelines over bounded lock-free queues
+
+ Overview:
+  - PlQueue: bounded multi-producer/multi-consumer ring of pointers
+    (per-cell sequence numbers, one CAS per push or pop, head and tail on
+    separate cache lines). Capacity is a power of two.
+  - A pipeline is a list of PlStage entries joined by PlQueues:
+    * stage 0 is the source; its function is called with NULL and returns
+      new items until it returns NULL
+    * middle stages take an item and return the item to pass downstream,
+      or NULL when they consumed it themselves
+    * the last stage is the sink; its return value is ignored
+  - Each stage runs its own number of worker threads. A full downstream
+    queue blocks the producer (backpressure); when the last worker of a
+    stage exits, its output queue is closed and consumers drain it and
+    stop.
+  - If a worker thread cannot be started, pl_run cancels the run: every
+    queue is closed, pushes into a closed queue give up, the workers
+    already running stop and are joined, and pl_run returns -1.
+  - Waiting spins briefly, then yields, then parks on the queue's condition
+    variable, so idle stages do not burn a core the busy ones need. A push
+    or pop only takes the queue lock when someone is parked, so the
+    uncontended path stays lock-free; a parked consumer wakes as soon as an
+    item arrives instead of after a fixed sleep.
+  - Per stage the runner records items, time inside the stage function,
+    time starved on an empty input and time blocked on a full output.
+*/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define PL_CACHE_LINE 64
+#define PL_MAX_STAGES 16
+#define PL_MAX_WORKERS 64
+#define PL_SPIN 64              /* pause iterations before yielding */
+#define PL_YIELD 16             /* yields before parking */
+
+typedef struct {
+    size_t seq;
+    void* item;
+} PlCell;
+
+typedef struct {
+    PlCell* cells;
+    size_t mask;
+    char pad0[PL_CACHE_LINE];
+    size_t enq;
+    char pad1[PL_CACHE_LINE];
+    size_t deq;
+    char pad2[PL_CACHE_LINE];
+    int closed;                 /* set once all producers have finished */
+    int parked;                 /* threads blocked on wake */
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        /* signalled on push, pop or close while parked */
+} PlQueue;
+
+static inline double pl_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline void pl_cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/* Returns 0 once the spin and yield budget is spent and the caller should park */
+static inline int pl_backoff(int* spins) {
+    if(*spins < PL_SPIN) {
+        pl_cpu_relax();
+    } else if(*spins < PL_SPIN + PL_YIELD) {
+        sched_yield();
+    } else {
+        return 0;
+    }
+    (*spins)++;
+    return 1;
+}
+
+/* Capacity is rounded up to a power of two. Returns 0 or -1. */
+static inline int pl_queue_init(PlQueue* q, size_t capacity) {
+    size_t cap = 2;
+    while(cap < capacity) cap <<= 1;
+    memset(q, 0, sizeof(*q));
+    q->cells = (PlCell*)malloc(cap * sizeof(PlCell));
+    if(!q->cells) return -1;
+    for(size_t i = 0; i < cap; i++) q->cells[i].seq = i;
+    q->mask = cap - 1;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->wake, NULL);
+    return 0;
+}
+
+static inline void pl_queue_free(PlQueue* q) {
+    free(q->cells);
+    q->cells = NULL;
+    pthread_cond_destroy(&q->wake);
+    pthread_mutex_destroy(&q->lock);
+}
+
+/*
+ Wakes parked threads after a push, pop or close. The fence pairs with the
+ one in pl_park: either the parker sees the new state or we see its count.
+*/
+static inline void pl_wake(PlQueue* q) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&q->parked, __ATOMIC_RELAXED) == 0) return;
+    pthread_mutex_lock(&q->lock);
+    pthread_cond_broadcast(&q->wake);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static inline int pl_enqueue(PlQueue* q, void* item) {
+    size_t pos = __atomic_load_n(&q->enq, __ATOMIC_RELAXED);
+    PlCell* c;
+    for(;;) {
+        c = &q->cells[pos & q->mask];
+        size_t seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if(dif == 0) {
+            if(__atomic_compare_exchange_n(&q->enq, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if(dif < 0) {
+            return 0;
+        } else {
+            pos = __atomic_load_n(&q->enq, __ATOMIC_RELAXED);
+        }
+    }
+    c->item = item;
+    __atomic_store_n(&c->seq, pos + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static inline int pl_dequeue(PlQueue* q, void** item) {
+    size_t pos = __atomic_load_n(&q->deq, __ATOMIC_RELAXED);
+    PlCell* c;
+    for(;;) {
+        c = &q->cells[pos & q->mask];
+        size_t seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if(dif == 0) {
+            if(__atomic_compare_exchange_n(&q->deq, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if(dif < 0) {
+            return 0;
+        } else {
+            pos = __atomic_load_n(&q->deq, __ATOMIC_RELAXED);
+        }
+    }
+    *item = c->item;
+    __atomic_store_n(&c->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+/* Returns 1 if queued, 0 if the queue is full */
+static inline int pl_try_push(PlQueue* q, void* item) {
+    if(!pl_enqueue(q, item)) return 0;
+    pl_wake(q);
+    return 1;
+}
+
+/* Returns 1 and sets *item, or 0 if the queue is empty */
+static inline int pl_try_pop(PlQueue* q, void** item) {
+    if(!pl_dequeue(q, item)) return 0;
+    pl_wake(q);
+    return 1;
+}
+
+/*
+ Parks until the queue changes. Retries the push (item != NULL) or pop
+ (out != NULL) under the lock after publishing the parked count, so a
+ wake between the caller's last attempt and the wait is not lost.
+ Returns 1 if the retry succeeded.
+*/
+static inline int pl_park(PlQueue* q, void* item, void** out) {
+    pthread_mutex_lock(&q->lock);
+    __atomic_add_fetch(&q->parked, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int done = out ? pl_dequeue(q, out) : pl_enqueue(q, item);
+    if(!done && !__atomic_load_n(&q->closed, __ATOMIC_ACQUIRE))
+        pthread_cond_wait(&q->wake, &q->lock);
+    __atomic_sub_fetch(&q->parked, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&q->lock);
+    if(done) pl_wake(q);
+    return done;
+}
+
+/* Blocking push; adds the time spent waiting to *waited. Returns 1, or 0
+   if the queue was closed while full (a cancelled run) and item was not
+   queued. */
+static inline int pl_push_wait(PlQueue* q, void* item, double* waited) {
+    if(pl_try_push(q, item)) return 1;
+    double t = pl_now();
+    int spins = 0, queued = 1;
+    while(!pl_try_push(q, item)) {
+        if(__atomic_load_n(&q->closed, __ATOMIC_ACQUIRE)) {
+            queued = 0;
+            break;
+        }
+        if(!pl_backoff(&spins) && pl_park(q, item, NULL)) break;
+    }
+    *waited += pl_now() - t;
+    return queued;
+}
+
+/* Blocking pop; returns 0 once the queue is closed and drained */
+static inline int pl_pop_wait(PlQueue* q, void** item, double* waited) {
+    if(pl_try_pop(q, item)) return 1;
+    double t = pl_now();
+    int spins = 0, got = 0;
+    for(;;) {
+        if(pl_try_pop(q, item)) {
+            got = 1;
+            break;
+        }
+        if(__atomic_load_n(&q->closed, __ATOMIC_ACQUIRE)) {
+            got = pl_try_pop(q, item);
+            break;
+        }
+        if(!pl_backoff(&spins) && pl_park(q, NULL, item)) {
+            got = 1;
+            break;
+        }
+    }
+    *waited += pl_now() - t;
+    return got;
+}
+
+static inline void pl_close(PlQueue* q) {
+    __atomic_store_n(&q->closed, 1, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&q->lock);
+    pthread_cond_broadcast(&q->wake);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Stages                                                                  */
+/* ---------------------------------------------------------------------- */
+
+typedef void* (*pl_stage_fn)(void* item, void* ctx, int worker);
+
+typedef struct {
+    const char* name;
+    int threads;
+    pl_stage_fn fn;
+    void* ctx;
+    /* filled in by pl_run() */
+    size_t items_in, items_out;
+    double busy, starved, blocked;
+    int active;
+} PlStage;
+
+typedef struct {
+    PlStage* stages;
+    int nstages;
+    PlQueue queues[PL_MAX_STAGES - 1];
+    pthread_mutex_t lock;
+    int cancel;             /* set when the run is abandoned */
+    double wall;
+} Pipeline;
+
+typedef struct {
+    Pipeline* pl;
+    int stage;
+    int worker;
+} PlWorker;
+
+static void* pl_worker_main(void* arg) {
+    PlWorker* w = (PlWorker*)arg;
+    Pipeline* pl = w->pl;
+    PlStage* st = &pl->stages[w->stage];
+    PlQueue* in = w->stage > 0 ? &pl->queues[w->stage - 1] : NULL;
+    PlQueue* out = w->stage < pl->nstages - 1 ? &pl->queues[w->stage] : NULL;
+    size_t n_in = 0, n_out = 0;
+    double busy = 0, starved = 0, blocked = 0;
+    for(;;) {
+        void* item = NULL;
+        if(__atomic_load_n(&pl->cancel, __ATOMIC_ACQUIRE)) break;
+        if(in) {
+            if(!pl_pop_wait(in, &item, &starved)) break;
+            n_in++;
+        }
+        double t = pl_now();
+        void* res = st->fn(item, st->ctx, w->worker);
+        busy += pl_now() - t;
+        if(!in && !res) break;              /* source exhausted */
+        if(out && res) {
+            if(!pl_push_wait(out, res, &blocked)) break;
+            n_out++;
+        }
+    }
+    pthread_mutex_lock(&pl->lock);
+    st->items_in += n_in;
+    st->items_out += n_out;
+    st->busy += busy;
+    st->starved += starved;
+    st->blocked += blocked;
+    int last = --st->active == 0;
+    pthread_mutex_unlock(&pl->lock);
+    if(last && out) pl_close(out);
+    return NULL;
+}
+
+/* Run stages to completion with queues of queue_cap items between them.
+   Returns the wall time in seconds, or -1 on setup failure. */
+static inline double pl_run(PlStage* stages, int nstages, size_t queue_cap) {
+    if(nstages < 2 || nstages > PL_MAX_STAGES) return -1;
+    Pipeline pl;
+    memset(&pl, 0, sizeof(pl));
+    pl.stages = stages;
+    pl.nstages = nstages;
+    int total = 0;
+    for(int s = 0; s < nstages; s++) {
+        if(stages[s].threads < 1) stages[s].threads = 1;
+        stages[s].items_in = stages[s].items_out = 0;
+        stages[s].busy = stages[s].starved = stages[s].blocked = 0;
+        stages[s].active = stages[s].threads;
+        total += stages[s].threads;
+    }
+    if(total > PL_MAX_WORKERS) return -1;
+    for(int s = 0; s < nstages - 1; s++) {
+        if(pl_queue_init(&pl.queues[s], queue_cap) != 0) {
+            while(--s >= 0) pl_queue_free(&pl.queues[s]);
+            return -1;
+        }
+    }
+    pthread_mutex_init(&pl.lock, NULL);
+    PlWorker workers[PL_MAX_WORKERS];
+    pthread_t tids[PL_MAX_WORKERS];
+    double t0 = pl_now();
+    int k = 0, failed = 0;
+    for(int s = 0; s < nstages && !failed; s++) {
+        for(int i = 0; i < stages[s].threads; i++) {
+            workers[k].pl = &pl;
+            workers[k].stage = s;
+            workers[k].worker = i;
+            if(pthread_create(&tids[k], NULL, pl_worker_main, &workers[k]) != 0) {
+                failed = 1;
+                break;
+            }
+            k++;
+        }
+    }
+    if(failed) {
+        /* Stop the workers already running: nothing downstream of the
+           missing one would ever drain, so close every queue */
+        __atomic_store_n(&pl.cancel, 1, __ATOMIC_RELEASE);
+        for(int s = 0; s < nstages - 1; s++) pl_close(&pl.queues[s]);
+    }
+    for(int i = 0; i < k; i++) pthread_join(tids[i], NULL);
+    double wall = pl_now() - t0;
+    for(int s = 0; s < nstages - 1; s++) pl_queue_free(&pl.queues[s]);
+    pthread_mutex_destroy(&pl.lock);
+    return failed ? -1 : wall;
+}
+
+/* Per-stage throughput and where each stage's threads spent their time */
+static inline void pl_report(const PlStage* stages, int nstages, double wall) {
+    int slowest = 0;
+    double worst = 0;
+    printf("%-10s %7s %10s %12s %8s %9s %9s\n", "stage", "threads", "items", "items/s", "busy%", "starved%",
+           "blocked%");
+    for(int s = 0; s < nstages; s++) {
+        const PlStage* st = &stages[s];
+        double cap = wall * st->threads;
+        size_t items = s == 0 ? st->items_out : st->items_in;
+        printf("%-10s %7d %10zu %12.0f %7.1f%% %8.1f%% %8.1f%%\n", st->name, st->threads, items, items / wall,
+               100.0 * st->busy / cap, 100.0 * st->starved / cap, 100.0 * st->blocked / cap);
+        double load = st->busy / st->threads;
+        if(load > worst) {
+            worst = load;
+            slowest = s;
+        }
+    }
+    printf("Bottleneck: %s (%.2f s busy per thread of %.2f s wall)\n", stages[slowest].name, worst, wall);
+}
+
+#endif /* PIPELINE_H */
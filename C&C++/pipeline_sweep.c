@@ -0,0 +1,297 @@
+/*
+ pipeline_sweep.c
+ Pipelined planner sweep: generate -> evaluate -> filter -> encode -> write
+
+ Overview:
+  - Batches of RC_BLOCK_ROWS rocket/body/payload tuples flow through five
+    pipeline.h stages:
+    * generate  fills a batch from the sweep grid (one thread)
+    * evaluate  runs evaluate_mission() on every row
+    * filter    keeps feasible rows with margin >= min_margin
+    * encode    turns the batch into one RCF block (result_codec.h)
+    * write     appends blocks through async_out.h and recycles the batch
+  - Batches come from a fixed pool held in a PlQueue, so the pool size and
+    the queue capacity bound memory and give backpressure end to end.
+  - The output uses the result_file.c RCF layout; blocks appear in
+    completion order and the row count is patched in after the last block.
+  - The same stage functions are first run back to back in a single loop,
+    so both outputs and timings can be compared.
+  - Hardware counters (perf_counters.h) cover each run from opening the
+    output to closing it, so the async writer thread is included, and
+    are reported per swept row.
+
+ Build: gcc -O3 -march=native pipeline_sweep.c -o pipeline_sweep -lm -pthread
+ Usage: pipeline_sweep [payloads_per_pair] [evaluate_threads] [encode_threads] [min_margin] [output.rcf]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "mission_core.h"
+#include "result_codec.h"
+#include "async_out.h"
+#include "pipeline.h"
+#include "perf_counters.h"
+
+#define NCOLS 7
+#define BATCH RC_BLOCK_ROWS
+#define POOL_BATCHES 32
+#define QUEUE_CAP 8
+#define ENC_CAP (4 + NCOLS * RC_MAX_BLOCK_BYTES(BATCH))
+
+#define NROCKETS ((int)(sizeof(rockets) / sizeof(rockets[0])))
+#define NBODIES ((int)(sizeof(bodies) / sizeof(bodies[0])))
+
+/* Stages that take from or return to the batch pool */
+enum { POOL_GENERATE, POOL_FILTER, POOL_WRITE, POOL_STAGES };
+
+typedef struct {
+    int n;
+    int32_t col[NCOLS - 1][BATCH];      /* rocket, body, payload, strategy, tankers, success */
+    double margin[BATCH];
+    size_t enc_len;
+    uint8_t enc[ENC_CAP];
+} Batch;
+
+typedef struct {
+    uint64_t tmp[BATCH];
+    int32_t scratch[2 * BATCH];
+    uint8_t trial[RC_MAX_BLOCK_BYTES(BATCH)];
+} EncodeScratch;
+
+typedef struct {
+    /* grid */
+    size_t per_pair, next, total;
+    double min_margin;
+    /* batch pool */
+    PlQueue pool;
+    double pool_wait[POOL_STAGES];      /* one slot per stage; each runs on one thread */
+    /* encode */
+    EncodeScratch* scratch;
+    /* write */
+    AsyncOut* out;
+    uint64_t rows_written;
+    size_t blocks;
+} Sweep;
+
+/* ---------------------------------------------------------------------- */
+/* Stage functions                                                         */
+/* ---------------------------------------------------------------------- */
+
+static void* stage_generate(void* item, void* ctx, int worker) {
+    Sweep* sw = (Sweep*)ctx;
+    (void)item;
+    (void)worker;
+    if(sw->next >= sw->total) return NULL;
+    void* p = NULL;
+    pl_pop_wait(&sw->pool, &p, &sw->pool_wait[POOL_GENERATE]);
+    Batch* b = (Batch*)p;
+    b->n = 0;
+    for(; b->n < BATCH && sw->next < sw->total; b->n++, sw->next++) {
+        size_t pair = sw->next / sw->per_pair, i = sw->next % sw->per_pair;
+        int r = (int)(pair / NBODIES);
+        double top = 2.0 * rockets[r].payload_leo_kg;
+        b->col[0][b->n] = r;
+        b->col[1][b->n] = (int32_t)(pair % NBODIES);
+        b->col[2][b->n] = (int32_t)(1.0 + top * (double)i / (double)sw->per_pair);
+    }
+    return b;
+}
+
+static void* stage_evaluate(void* item, void* ctx, int worker) {
+    Batch* b = (Batch*)item;
+    (void)ctx;
+    (void)worker;
+    Mission m;
+    MissionResult res;
+    memset(&m, 0, sizeof(m));
+    for(int i = 0; i < b->n; i++) {
+        m.rocket = rockets[b->col[0][i]];
+        m.body = bodies[b->col[1][i]];
+        m.payload_kg = b->col[2][i];
+        int ok = evaluate_mission(&m, &res);
+        b->col[3][i] = m.strategy;
+        b->col[4][i] = res.tankers;
+        b->col[5][i] = ok;
+        b->margin[i] = res.final_margin;
+    }
+    return b;
+}
+
+static void* stage_filter(void* item, void* ctx, int worker) {
+    Batch* b = (Batch*)item;
+    Sweep* sw = (Sweep*)ctx;
+    (void)worker;
+    int k = 0;
+    for(int i = 0; i < b->n; i++) {
+        int keep = b->col[5][i] && b->margin[i] >= sw->min_margin;
+        for(int c = 0; c < NCOLS - 1; c++) b->col[c][k] = b->col[c][i];
+        b->margin[k] = b->margin[i];
+        k += keep;
+    }
+    b->n = k;
+    if(k == 0) {
+        pl_push_wait(&sw->pool, b, &sw->pool_wait[POOL_FILTER]);
+        return NULL;
+    }
+    return b;
+}
+
+static void* stage_encode(void* item, void* ctx, int worker) {
+    Batch* b = (Batch*)item;
+    Sweep* sw = (Sweep*)ctx;
+    EncodeScratch* s = &sw->scratch[worker];
+    uint32_t rows = (uint32_t)b->n;
+    memcpy(b->enc, &rows, 4);
+    size_t len = 4;
+    for(int c = 0; c < NCOLS - 1; c++) len += rc_encode_ints(b->enc + len, b->col[c], rows, s->tmp, s->scratch, s->trial);
+    len += rc_encode_doubles(b->enc + len, b->margin, rows, s->tmp);
+    b->enc_len = len;
+    return b;
+}
+
+static void* stage_write(void* item, void* ctx, int worker) {
+    Batch* b = (Batch*)item;
+    Sweep* sw = (Sweep*)ctx;
+    (void)worker;
+    ao_write(sw->out, b->enc, b->enc_len);
+    sw->rows_written += (uint64_t)b->n;
+    sw->blocks++;
+    pl_push_wait(&sw->pool, b, &sw->pool_wait[POOL_WRITE]);
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Driver                                                                  */
+/* ---------------------------------------------------------------------- */
+
+static int sweep_open(Sweep* sw, const char* path, size_t per_pair, double min_margin, int encoders,
+                      Batch* batches) {
+    memset(sw, 0, sizeof(*sw));
+    sw->per_pair = per_pair;
+    sw->total = per_pair * (size_t)(NROCKETS * NBODIES);
+    sw->min_margin = min_margin;
+    if(pl_queue_init(&sw->pool, POOL_BATCHES) != 0) return -1;
+    for(int i = 0; i < POOL_BATCHES; i++) pl_try_push(&sw->pool, &batches[i]);
+    sw->scratch = (EncodeScratch*)malloc(sizeof(EncodeScratch) * (size_t)encoders);
+    sw->out = ao_open(path, 0, AO_BLOCK_DEFAULT, 4);
+    if(!sw->scratch || !sw->out) return -1;
+    uint32_t ncols = NCOLS, block_rows = BATCH;
+    uint64_t nrows = 0;
+    ao_write(sw->out, "RCF1", 4);
+    ao_write(sw->out, &ncols, 4);
+    ao_write(sw->out, &nrows, 8);
+    ao_write(sw->out, &block_rows, 4);
+    return 0;
+}
+
+/* Close the output and patch the final row count into the header */
+static int sweep_close(Sweep* sw, const char* path) {
+    int rc = ao_close(sw->out);
+    FILE* f = fopen(path, "r+b");
+    if(!f || fseek(f, 8, SEEK_SET) != 0 || fwrite(&sw->rows_written, 8, 1, f) != 1) rc = -1;
+    if(f && fclose(f) != 0) rc = -1;
+    pl_queue_free(&sw->pool);
+    free(sw->scratch);
+    return rc;
+}
+
+static long file_size(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if(!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fclose(f);
+    return n;
+}
+
+int main(int argc, char* argv[]) {
+    size_t per_pair = argc > 1 ? (size_t)atol(argv[1]) : 500000;
+    int eval_threads = argc > 2 ? atoi(argv[2]) : 2;
+    int enc_threads = argc > 3 ? atoi(argv[3]) : 1;
+    double min_margin = argc > 4 ? atof(argv[4]) : 0.0;
+    const char* path = argc > 5 ? argv[5] : "pipeline_sweep.rcf";
+    if(per_pair < 1) per_pair = 1;
+    if(eval_threads < 1) eval_threads = 1;
+    if(enc_threads < 1) enc_threads = 1;
+
+    Batch* batches = (Batch*)malloc(sizeof(Batch) * POOL_BATCHES);
+    if(!batches) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    Sweep sw;
+    PerfCounters pc;
+    PcSample ps[2];
+    pc_open(&pc);
+    printf("Sweep: %zu rows, keep feasible with margin >= %.3f km/s\n\n", per_pair * NROCKETS * NBODIES, min_margin);
+
+    /* Single loop: every stage back to back on one batch at a time */
+    pc_start(&pc, &ps[0]);
+    if(sweep_open(&sw, path, per_pair, min_margin, 1, batches) != 0) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+    double t0 = pl_now();
+    void* b;
+    while((b = stage_generate(NULL, &sw, 0)) != NULL) {
+        b = stage_filter(stage_evaluate(b, &sw, 0), &sw, 0);
+        if(b) stage_write(stage_encode(b, &sw, 0), &sw, 0);
+    }
+    double t_loop = pl_now() - t0;
+    uint64_t loop_rows = sw.rows_written;
+    if(sweep_close(&sw, path) != 0) {
+        fprintf(stderr, "Error writing %s\n", path);
+        return 1;
+    }
+    pc_stop(&pc, &ps[0]);
+    long loop_size = file_size(path);
+    printf("Single loop: %.3f s, %lu rows kept, %ld bytes\n\n", t_loop, (unsigned long)loop_rows, loop_size);
+
+    /* Pipeline */
+    pc_start(&pc, &ps[1]);
+    if(sweep_open(&sw, path, per_pair, min_margin, enc_threads, batches) != 0) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+    PlStage stages[5] = {
+        {"generate", 1, stage_generate, &sw, 0, 0, 0, 0, 0, 0},
+        {"evaluate", eval_threads, stage_evaluate, &sw, 0, 0, 0, 0, 0, 0},
+        {"filter", 1, stage_filter, &sw, 0, 0, 0, 0, 0, 0},
+        {"encode", enc_threads, stage_encode, &sw, 0, 0, 0, 0, 0, 0},
+        {"write", 1, stage_write, &sw, 0, 0, 0, 0, 0, 0},
+    };
+    double wall = pl_run(stages, 5, QUEUE_CAP);
+    if(wall < 0) {
+        fprintf(stderr, "Pipeline setup failed\n");
+        return 1;
+    }
+    uint64_t pipe_rows = sw.rows_written;
+    size_t blocks = sw.blocks;
+    size_t swept = sw.total;
+    if(sweep_close(&sw, path) != 0) {
+        fprintf(stderr, "Error writing %s\n", path);
+        return 1;
+    }
+    pc_stop(&pc, &ps[1]);
+    pl_report(stages, 5, wall);
+    printf("Batch pool waits: generate %.1f ms, filter %.1f ms, write %.1f ms\n", sw.pool_wait[POOL_GENERATE] * 1e3,
+           sw.pool_wait[POOL_FILTER] * 1e3, sw.pool_wait[POOL_WRITE] * 1e3);
+    printf("\nPipeline: %.3f s, %lu rows kept in %zu blocks, %ld bytes -> %s\n", wall, (unsigned long)pipe_rows, blocks,
+           file_size(path), path);
+    printf("Speedup over single loop: %.2fx\n", t_loop / wall);
+    printf("\n");
+    pc_print_status(stdout, &pc);
+    pc_print_header(stdout, 12);
+    pc_print_row(stdout, 12, "single loop", &ps[0], (double)swept);
+    pc_print_row(stdout, 12, "pipeline", &ps[1], (double)swept);
+    pc_close(&pc);
+    if(pipe_rows != loop_rows) {
+        fprintf(stderr, "Row count mismatch: pipeline %lu, single loop %lu\n", (unsigned long)pipe_rows,
+                (unsigned long)loop_rows);
+        return 1;
+    }
+    free(batches);
+    return 0;
+}
@@ -0,0 +1,519 @@
+/*
+ planner_service.c
+ Resident planner with latency histograms, metrics export and load generator
+
+ Overview:
+  - Worker threads take queries from a pipeline.h PlQueue and answer them:
+    * eval   one evaluate_mission() call
+    * scan   every rocket in the catalog against one body
+    * sweep  SWEEP_POINTS payloads for one rocket/body pair, returning the
+             heaviest feasible payload
+  - Each worker records request latency, queue wait and evaluation time in
+    its own hdr_hist.h histograms (and latency per query kind). A metrics
+    thread merges them every interval without locks and exports the result
+    in Prometheus text format:
+    * --metrics-file: rewritten atomically (temp file + rename)
+    * --metrics-socket: served on a Unix socket to every connection
+      (plain HTTP response when the client sends GET)
+  - The built-in load generator replays a recorded query mix in order,
+    cycling, with Poisson arrivals at the requested rate (open loop).
+    Latency runs from the scheduled arrival, so a backed-up queue shows up
+    in the tail instead of slowing the generator down.
+  - Mix files hold "kind,rocket_index,body_index,payload_kg" lines; --record
+    writes a sample mix to start from.
+
+ Build: gcc -O2 planner_service.c -o planner_service -lm -pthread
+ Usage: planner_service [--rate qps] [--seconds s] [--workers n] [--mix file]
+                        [--record file] [--metrics-file path | --metrics-socket path]
+                        [--interval ms]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "mission_core.h"
+#include "pipeline.h"
+#include "hdr_hist.h"
+
+#define MAX_WORKERS 32
+#define NKINDS 3
+#define KIND_EVAL 0
+#define KIND_SCAN 1
+#define KIND_SWEEP 2
+#define SWEEP_POINTS 256
+#define REQUEST_POOL 4096
+#define METRICS_BUF (64 * 1024)
+
+static const char* kind_names[NKINDS] = {"eval", "scan", "sweep"};
+
+typedef struct {
+    int kind, rocket, body;
+    double payload;
+} Query;
+
+typedef struct {
+    Query q;
+    uint64_t t_sched;       /* intended arrival (ns) */
+    uint64_t t_enq;         /* actually queued (ns) */
+    double answer;
+} Request;
+
+typedef struct {
+    HdrHist latency, wait, eval;
+    HdrHist by_kind[NKINDS];
+} WorkerHists;
+
+typedef struct {
+    PlQueue* requests;
+    PlQueue* free_list;
+    WorkerHists* hist;
+    double checksum;
+} Worker;
+
+typedef struct {
+    WorkerHists* hists;
+    int nworkers;
+    const char* file;
+    const char* socket_path;
+    int interval_ms;
+    int running;            /* accessed with __atomic */
+    WorkerHists* merged;    /* merge target, allocated once for every export */
+    char* text;
+    size_t text_len;
+    size_t exports, scrapes;
+} Metrics;
+
+static inline uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Query execution                                                         */
+/* ---------------------------------------------------------------------- */
+
+static double answer(const Query* q) {
+    Mission m;
+    MissionResult res;
+    memset(&m, 0, sizeof(m));
+    m.body = bodies[q->body];
+    if(q->kind == KIND_EVAL) {
+        m.rocket = rockets[q->rocket];
+        m.payload_kg = q->payload;
+        return evaluate_mission(&m, &res) ? res.final_margin : -1.0;
+    }
+    if(q->kind == KIND_SCAN) {
+        double best = -1.0;
+        m.payload_kg = q->payload;
+        for(int r = 0; r < NUM_ROCKETS; r++) {
+            m.rocket = rockets[r];
+            if(evaluate_mission(&m, &res) && res.final_margin > best) best = res.final_margin;
+        }
+        return best;
+    }
+    double heaviest = 0.0;
+    m.rocket = rockets[q->rocket];
+    for(int i = 1; i <= SWEEP_POINTS; i++) {
+        m.payload_kg = q->payload * i / SWEEP_POINTS;
+        if(evaluate_mission(&m, &res)) heaviest = m.payload_kg;
+    }
+    return heaviest;
+}
+
+static void* worker_main(void* arg) {
+    Worker* w = (Worker*)arg;
+    double unused = 0;
+    void* item;
+    while(pl_pop_wait(w->requests, &item, &unused)) {
+        Request* rq = (Request*)item;
+        uint64_t t_start = now_ns();
+        rq->answer = answer(&rq->q);
+        uint64_t t_done = now_ns();
+        w->checksum += rq->answer;
+        hdr_record(&w->hist->wait, t_start - rq->t_enq);
+        hdr_record(&w->hist->eval, t_done - t_start);
+        hdr_record(&w->hist->latency, t_done - rq->t_sched);
+        hdr_record(&w->hist->by_kind[rq->q.kind], t_done - rq->t_sched);
+        pl_push_wait(w->free_list, rq, &unused);
+    }
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Metrics export                                                          */
+/* ---------------------------------------------------------------------- */
+
+static void merge_all(const Metrics* mt, WorkerHists* out) {
+    memset(out, 0, sizeof(*out));
+    for(int i = 0; i < mt->nworkers; i++) {
+        hdr_merge(&out->latency, &mt->hists[i].latency);
+        hdr_merge(&out->wait, &mt->hists[i].wait);
+        hdr_merge(&out->eval, &mt->hists[i].eval);
+        for(int k = 0; k < NKINDS; k++) hdr_merge(&out->by_kind[k], &mt->hists[i].by_kind[k]);
+    }
+}
+
+static size_t render_metrics(const WorkerHists* all, char* buf, size_t cap) {
+    FILE* f = fmemopen(buf, cap, "w");
+    if(!f) return 0;
+    hdr_write_prometheus(f, "planner_request_latency_seconds", "Scheduled arrival to answer", &all->latency);
+    hdr_write_prometheus(f, "planner_queue_wait_seconds", "Time queued before a worker picked the request up",
+                         &all->wait);
+    hdr_write_prometheus(f, "planner_service_seconds", "Time spent answering", &all->eval);
+    hdr_write_prometheus_header(f, "planner_request_latency_by_kind_seconds", "Request latency per query kind");
+    for(int k = 0; k < NKINDS; k++) {
+        char labels[32];
+        snprintf(labels, sizeof(labels), "kind=\"%s\"", kind_names[k]);
+        hdr_write_prometheus_series(f, "planner_request_latency_by_kind_seconds", labels, &all->by_kind[k]);
+    }
+    fprintf(f, "# HELP planner_requests_total Requests answered\n# TYPE planner_requests_total counter\n");
+    for(int k = 0; k < NKINDS; k++)
+        fprintf(f, "planner_requests_total{kind=\"%s\"} %lu\n", kind_names[k], (unsigned long)all->by_kind[k].total);
+    long n = ftell(f);
+    fclose(f);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static int export_file(const char* path, const char* text, size_t len) {
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* f = fopen(tmp, "w");
+    if(!f) return -1;
+    size_t w = fwrite(text, 1, len, f);
+    if(fclose(f) != 0 || w != len) return -1;
+    return rename(tmp, path);
+}
+
+static int open_socket(const char* path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0) return -1;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void serve_scrape(Metrics* mt, int listen_fd) {
+    int c = accept(listen_fd, NULL, NULL);
+    if(c < 0) return;
+    char req[256];
+    struct pollfd p = {c, POLLIN, 0};
+    ssize_t n = poll(&p, 1, 50) > 0 ? read(c, req, sizeof(req) - 1) : 0;
+    if(n >= 3 && memcmp(req, "GET", 3) == 0) {
+        char hdr[128];
+        int hl = snprintf(hdr, sizeof(hdr), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                            "Content-Length: %zu\r\n\r\n", mt->text_len);
+        if(write(c, hdr, (size_t)hl) < 0) {
+            close(c);
+            return;
+        }
+    }
+    size_t off = 0;
+    while(off < mt->text_len) {
+        ssize_t w = write(c, mt->text + off, mt->text_len - off);
+        if(w <= 0) break;
+        off += (size_t)w;
+    }
+    close(c);
+    mt->scrapes++;
+}
+
+static void metrics_export(Metrics* mt) {
+    merge_all(mt, mt->merged);
+    mt->text_len = render_metrics(mt->merged, mt->text, METRICS_BUF);
+    if(mt->file && export_file(mt->file, mt->text, mt->text_len) != 0)
+        fprintf(stderr, "Cannot write metrics to %s\n", mt->file);
+    mt->exports++;
+}
+
+static void* metrics_main(void* arg) {
+    Metrics* mt = (Metrics*)arg;
+    int lfd = -1;
+    if(mt->socket_path) {
+        lfd = open_socket(mt->socket_path);
+        if(lfd < 0) fprintf(stderr, "Cannot listen on %s: %s\n", mt->socket_path, strerror(errno));
+    }
+    while(__atomic_load_n(&mt->running, __ATOMIC_ACQUIRE)) {
+        uint64_t next = now_ns() + (uint64_t)mt->interval_ms * 1000000ull;
+        metrics_export(mt);
+        for(;;) {
+            uint64_t t = now_ns();
+            if(t >= next || !__atomic_load_n(&mt->running, __ATOMIC_ACQUIRE)) break;
+            int ms = (int)((next - t) / 1000000ull) + 1;
+            if(lfd >= 0) {
+                struct pollfd p = {lfd, POLLIN, 0};
+                if(poll(&p, 1, ms) > 0) serve_scrape(mt, lfd);
+            } else {
+                struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+                nanosleep(&ts, NULL);
+            }
+        }
+    }
+    if(lfd >= 0) {
+        close(lfd);
+        unlink(mt->socket_path);
+    }
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Query mixes                                                             */
+/* ---------------------------------------------------------------------- */
+
+/* Mostly single evaluations, some catalog scans, a few heavy sweeps; NULL when
+   out of memory */
+static Query* builtin_mix(size_t n) {
+    Query* q = (Query*)malloc(n * sizeof(Query));
+    if(!q) return NULL;
+    srand(7);
+    for(size_t i = 0; i < n; i++) {
+        int x = rand() % 100;
+        q[i].kind = x < 80 ? KIND_EVAL : x < 97 ? KIND_SCAN : KIND_SWEEP;
+        q[i].rocket = rand() % NUM_ROCKETS;
+        q[i].body = rand() % NUM_BODIES;
+        q[i].payload = 100.0 + rand() % (int)rockets[q[i].rocket].payload_leo_kg;
+    }
+    return q;
+}
+
+static int save_mix(const char* path, const Query* q, size_t n) {
+    FILE* f = fopen(path, "w");
+    if(!f) return -1;
+    fprintf(f, "# kind,rocket_index,body_index,payload_kg\n");
+    for(size_t i = 0; i < n; i++)
+        fprintf(f, "%s,%d,%d,%.0f\n", kind_names[q[i].kind], q[i].rocket, q[i].body, q[i].payload);
+    return fclose(f);
+}
+
+static Query* load_mix(const char* path, size_t* n) {
+    FILE* f = fopen(path, "r");
+    if(!f) return NULL;
+    size_t cap = 1024, cnt = 0;
+    Query* q = (Query*)malloc(cap * sizeof(Query));
+    char line[256], kind[16];
+    int lineno = 0;
+    while(q && fgets(line, sizeof(line), f)) {
+        lineno++;
+        if(line[0] == '#' || line[0] == '\n') continue;
+        Query x;
+        if(sscanf(line, "%15[^,],%d,%d,%lf", kind, &x.rocket, &x.body, &x.payload) != 4) {
+            fprintf(stderr, "%s:%d: bad query line\n", path, lineno);
+            continue;
+        }
+        x.kind = -1;
+        for(int k = 0; k < NKINDS; k++)
+            if(strcmp(kind, kind_names[k]) == 0) x.kind = k;
+        if(x.kind < 0 || x.rocket < 0 || x.rocket >= NUM_ROCKETS || x.body < 0 || x.body >= NUM_BODIES) {
+            fprintf(stderr, "%s:%d: unknown kind or catalog index\n", path, lineno);
+            continue;
+        }
+        if(cnt == cap) {
+            Query* grown = (Query*)realloc(q, cap * 2 * sizeof(Query));
+            if(!grown) {
+                free(q);
+                q = NULL;
+                break;
+            }
+            q = grown;
+            cap *= 2;
+        }
+        q[cnt++] = x;
+    }
+    fclose(f);
+    if(!q) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        return NULL;
+    }
+    *n = cnt;
+    if(cnt == 0) {
+        free(q);
+        return NULL;
+    }
+    return q;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Load generator                                                          */
+/* ---------------------------------------------------------------------- */
+
+/* After a failed thread start: let the n started workers drain and exit */
+static void stop_workers(PlQueue* requests, pthread_t* tids, int n) {
+    pl_close(requests);
+    for(int i = 0; i < n; i++) pthread_join(tids[i], NULL);
+    fprintf(stderr, "cannot start thread\n");
+}
+
+static void sleep_until(uint64_t t) {
+    for(;;) {
+        uint64_t now = now_ns();
+        if(now >= t) return;
+        uint64_t d = t - now;
+        if(d > 100000) {
+            struct timespec ts = {0, (long)(d - 50000)};
+            nanosleep(&ts, NULL);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+static void print_row(const char* name, const HdrHist* h) {
+    printf("%-11s %10lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, (unsigned long)h->total, hdr_mean(h) / 1e3,
+           hdr_value_at(h, 50) / 1e3, hdr_value_at(h, 90) / 1e3, hdr_value_at(h, 99) / 1e3,
+           hdr_value_at(h, 99.9) / 1e3, h->max / 1e3);
+}
+
+int main(int argc, char* argv[]) {
+    double rate = 20000, seconds = 3;
+    int nworkers = 2;
+    const char* mix_path = NULL;
+    const char* record_path = NULL;
+    Metrics mt;
+    memset(&mt, 0, sizeof(mt));
+    mt.interval_ms = 1000;
+    for(int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if(!v) {
+            fprintf(stderr, "Missing value for %s\n", a);
+            return 1;
+        }
+        if(strcmp(a, "--rate") == 0) rate = atof(v);
+        else if(strcmp(a, "--seconds") == 0) seconds = atof(v);
+        else if(strcmp(a, "--workers") == 0) nworkers = atoi(v);
+        else if(strcmp(a, "--mix") == 0) mix_path = v;
+        else if(strcmp(a, "--record") == 0) record_path = v;
+        else if(strcmp(a, "--metrics-file") == 0) mt.file = v;
+        else if(strcmp(a, "--metrics-socket") == 0) mt.socket_path = v;
+        else if(strcmp(a, "--interval") == 0) mt.interval_ms = atoi(v);
+        else {
+            fprintf(stderr, "Unknown option %s\n", a);
+            return 1;
+        }
+        i++;
+    }
+    if(nworkers < 1) nworkers = 1;
+    if(nworkers > MAX_WORKERS) nworkers = MAX_WORKERS;
+    if(rate <= 0) rate = 1;
+    if(mt.interval_ms < 10) mt.interval_ms = 10;
+
+    size_t nmix = 10000;
+    Query* mix = mix_path ? load_mix(mix_path, &nmix) : builtin_mix(nmix);
+    if(!mix) {
+        if(mix_path) fprintf(stderr, "Cannot load query mix %s\n", mix_path);
+        else printf("out of memory\n");
+        return 1;
+    }
+    if(record_path) {
+        if(save_mix(record_path, mix, nmix) != 0) {
+            fprintf(stderr, "Cannot write %s\n", record_path);
+            return 1;
+        }
+        printf("Recorded %zu queries to %s\n", nmix, record_path);
+        return 0;
+    }
+
+    PlQueue requests, free_list;
+    int queues_failed = pl_queue_init(&requests, REQUEST_POOL) != 0;
+    queues_failed |= pl_queue_init(&free_list, REQUEST_POOL) != 0;
+    Request* pool = (Request*)calloc(REQUEST_POOL, sizeof(Request));
+    WorkerHists* hists = (WorkerHists*)calloc((size_t)nworkers, sizeof(WorkerHists));
+    mt.text = (char*)malloc(METRICS_BUF);
+    mt.merged = (WorkerHists*)malloc(sizeof(WorkerHists));
+    if(queues_failed || !pool || !hists || !mt.text || !mt.merged) {
+        printf("out of memory\n");
+        return 1;
+    }
+    for(int i = 0; i < REQUEST_POOL; i++) pl_try_push(&free_list, &pool[i]);
+
+    Worker workers[MAX_WORKERS];
+    pthread_t tids[MAX_WORKERS], mtid;
+    for(int i = 0; i < nworkers; i++) {
+        workers[i].requests = &requests;
+        workers[i].free_list = &free_list;
+        workers[i].hist = &hists[i];
+        workers[i].checksum = 0;
+        if(pthread_create(&tids[i], NULL, worker_main, &workers[i]) != 0) {
+            stop_workers(&requests, tids, i);
+            return 1;
+        }
+    }
+    mt.hists = hists;
+    mt.nworkers = nworkers;
+    mt.running = 1;
+    if(pthread_create(&mtid, NULL, metrics_main, &mt) != 0) {
+        stop_workers(&requests, tids, nworkers);
+        return 1;
+    }
+
+    /* Open-loop replay: exponential gaps at the target rate */
+    uint64_t start = now_ns(), end = start + (uint64_t)(seconds * 1e9), t = start;
+    size_t sent = 0;
+    double unused = 0, mean_gap = 1e9 / rate;
+    uint64_t rng = 0x2545F4914F6CDD1Dull;
+    while(t < end) {
+        sleep_until(t);
+        void* item = NULL;
+        pl_pop_wait(&free_list, &item, &unused);
+        Request* rq = (Request*)item;
+        rq->q = mix[sent % nmix];
+        rq->t_sched = t;
+        rq->t_enq = now_ns();
+        pl_push_wait(&requests, rq, &unused);
+        sent++;
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        double u = ((rng >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+        t += (uint64_t)(-log(u) * mean_gap);
+    }
+    pl_close(&requests);
+    for(int i = 0; i < nworkers; i++) pthread_join(tids[i], NULL);
+    double elapsed = (now_ns() - start) * 1e-9;
+    __atomic_store_n(&mt.running, 0, __ATOMIC_RELEASE);
+    pthread_join(mtid, NULL);
+    metrics_export(&mt);
+
+    const WorkerHists* all = mt.merged;     /* merged by the final export */
+    printf("Replayed %zu queries (%zu-entry mix%s%s) at %.0f/s target, %.0f/s achieved, %d workers\n", sent, nmix,
+           mix_path ? " from " : ", built-in", mix_path ? mix_path : "", rate, all->latency.total / elapsed, nworkers);
+    printf("\n%-11s %10s %10s %10s %10s %10s %10s %10s\n", "(us)", "count", "mean", "p50", "p90", "p99", "p99.9",
+           "max");
+    print_row("latency", &all->latency);
+    print_row("wait", &all->wait);
+    print_row("service", &all->eval);
+    for(int k = 0; k < NKINDS; k++) {
+        char label[32];
+        snprintf(label, sizeof(label), "%s lat", kind_names[k]);
+        print_row(label, &all->by_kind[k]);
+    }
+    printf("\nMetrics exports: %zu", mt.exports);
+    if(mt.file) printf(" -> %s", mt.file);
+    if(mt.socket_path) printf(", scrapes served: %zu", mt.scrapes);
+    printf("\n");
+
+    free(mt.merged);
+    free(mt.text);
+    free(hists);
+    free(pool);
+    free(mix);
+    pl_queue_free(&requests);
+    pl_queue_free(&free_list);
+    return 0;
+}
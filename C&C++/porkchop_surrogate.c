@@ -0,0 +1,247 @@
+/*
+ porkchop_surrogate.c
+ Lambert-based departure/arrival delta-v with fast surrogate lookups
+
+ Overview:
+  - Exact model: planets on circular, inclined orbits (orbit_bodies[] in
+    transfer_costs.h, mean longitudes at J2000), a single-revolution
+    universal-variable Lambert arc from Earth to the target (or to the
+    parent planet for moons), then the same departure and capture burns as
+    the closed-form transfer table.
+  - One surrogate (surrogate.h) per destination over departure day in one
+    synodic period x time of flight in [0.5, 1.5] x Hohmann transit.
+  - The benchmark compares surrogate against exact values at random
+    points, checks the error estimates hold, times both, and runs a
+    feasibility sweep that only calls the exact model near the boundary.
+    The fit is not free (a few hundred thousand exact calls per
+    destination), so it also reports the sweep speedup and the number of
+    queries after which fitting has paid for itself.
+
+ Usage: porkchop_surrogate [tolerance_km_s] [samples]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "mission_core.h"
+#include "transfer_costs.h"
+#include "kepler_batch.h"
+#include "surrogate.h"
+
+#define PARK_ALT_KM 200.0
+#define CAPTURE_ALT_KM 500.0
+#define MAX_DEPTH 4
+#define DV_CAP_KM_S 40.0        /* costlier arcs are clamped; far above any feasibility limit */
+
+/* Mean longitude at J2000 (deg) for heliocentric orbit_bodies[] entries;
+   bodies not listed start at 0 */
+static const struct { const char* name; double l0; } mean_longitudes[] = {
+    {"Earth", 100.464}, {"Mercury", 252.251}, {"Venus", 181.980}, {"Mars", 355.453},
+    {"Jupiter", 34.396}, {"Saturn", 49.954}, {"Uranus", 313.238}, {"Neptune", 304.880}
+};
+
+typedef struct {
+    int target;             /* orbit_bodies[] index of the destination */
+    int planet;             /* heliocentric body the Lambert arc goes to */
+    double start_day;       /* days since J2000 of the domain start */
+    long calls;
+} PorkchopCtx;
+
+static double mean_longitude0(int idx) {
+    for(size_t i = 0; i < sizeof(mean_longitudes) / sizeof(mean_longitudes[0]); i++)
+        if(strcmp(orbit_bodies[idx].name, mean_longitudes[i].name) == 0) return mean_longitudes[i].l0 * TC_DEG;
+    return 0.0;
+}
+
+/* Heliocentric position and velocity of a circular-orbit body at day t */
+static void body_state(int idx, double t, double* r, double* v) {
+    const OrbitBody* b = &orbit_bodies[idx];
+    double n = sqrt(MU_SUN / (b->a_km * b->a_km * b->a_km));
+    double L = mean_longitude0(idx) + n * t * 86400.0;
+    double ci = cos(b->inc_deg * TC_DEG), si = sin(b->inc_deg * TC_DEG);
+    double vc = sqrt(MU_SUN / b->a_km);
+    r[0] = b->a_km * cos(L);
+    r[1] = b->a_km * sin(L) * ci;
+    r[2] = b->a_km * sin(L) * si;
+    v[0] = -vc * sin(L);
+    v[1] = vc * cos(L) * ci;
+    v[2] = vc * cos(L) * si;
+}
+
+/* Prograde single-revolution Lambert problem (universal variables,
+   safeguarded bisection). Returns 0 and fills v1, v2, or -1. */
+int lambert(double mu, const double* r1, const double* r2, double dt, double* v1, double* v2) {
+    double n1 = sqrt(r1[0] * r1[0] + r1[1] * r1[1] + r1[2] * r1[2]);
+    double n2 = sqrt(r2[0] * r2[0] + r2[1] * r2[1] + r2[2] * r2[2]);
+    double cz = r1[0] * r2[1] - r1[1] * r2[0];
+    double cth = (r1[0] * r2[0] + r1[1] * r2[1] + r1[2] * r2[2]) / (n1 * n2);
+    if(cth > 1.0) cth = 1.0;
+    if(cth < -1.0) cth = -1.0;
+    double th = acos(cth);
+    if(cz < 0.0) th = 2.0 * KB_PI - th;
+    double A = sin(th) * sqrt(n1 * n2 / (1.0 - cth));
+    if(fabs(A) < 1e-8 * sqrt(n1 * n2)) return -1;
+
+    double lo = -4.0 * KB_PI * KB_PI, hi = 4.0 * KB_PI * KB_PI * (1.0 - 1e-12);
+    double z = 0.0, y = 0.0, c, s;
+    for(int it = 0; it < 200; it++) {
+        z = 0.5 * (lo + hi);
+        kb_stumpff(z, &c, &s);
+        y = n1 + n2 + A * (z * s - 1.0) / sqrt(c);
+        if(y < 0.0) { lo = z; continue; }
+        double x = sqrt(y / c);
+        double t = (x * x * x * s + A * sqrt(y)) / sqrt(mu);
+        if(t < dt) lo = z; else hi = z;
+        if(hi - lo < 1e-14 * (1.0 + fabs(z))) break;
+    }
+    if(y <= 0.0) return -1;
+    double f = 1.0 - y / n1, g = A * sqrt(y / mu), gd = 1.0 - y / n2;
+    for(int k = 0; k < 3; k++) {
+        v1[k] = (r2[k] - f * r1[k]) / g;
+        v2[k] = (gd * r2[k] - r1[k]) / g;
+    }
+    return 0;
+}
+
+/* Exact total delta-v (departure + capture, km/s) for departure `dep`
+   days after the domain start and a flight of `tof` days */
+double exact_dv(double dep, double tof, void* arg) {
+    PorkchopCtx* pc = (PorkchopCtx*)arg;
+    pc->calls++;
+    double t0 = pc->start_day + dep;
+    double re[3], ve[3], rp[3], vp[3], v1[3], v2[3];
+    body_state(TC_EARTH, t0, re, ve);
+    body_state(pc->planet, t0 + tof, rp, vp);
+    if(lambert(MU_SUN, re, rp, tof * 86400.0, v1, v2) != 0) return NAN;
+    double vid = 0.0, via = 0.0;
+    for(int k = 0; k < 3; k++) {
+        vid += (v1[k] - ve[k]) * (v1[k] - ve[k]);
+        via += (v2[k] - vp[k]) * (v2[k] - vp[k]);
+    }
+    vid = sqrt(vid);
+    via = sqrt(via);
+    const OrbitBody* earth = &orbit_bodies[TC_EARTH];
+    const OrbitBody* b = &orbit_bodies[pc->target];
+    const OrbitBody* p = &orbit_bodies[pc->planet];
+    double dv = hyperbolic_burn_dv(earth->mu, earth->radius_km + PARK_ALT_KM, vid);
+    if(pc->planet == pc->target) {
+        dv += hyperbolic_burn_dv(b->mu, b->radius_km + CAPTURE_ALT_KM, via);
+    } else {
+        /* Moon: brake at its orbital radius, plane change, then capture */
+        double v_moon = sqrt(p->mu / b->a_km);
+        dv += hyperbolic_burn_dv(p->mu, b->a_km, via) + 2.0 * v_moon * sin(0.5 * b->inc_deg * TC_DEG) +
+              hyperbolic_burn_dv(b->mu, b->radius_km + CAPTURE_ALT_KM, 0.0);
+    }
+    return dv > DV_CAP_KM_S ? DV_CAP_KM_S : dv;
+}
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned long long rng_state = 0x2545F4914F6CDD1Dull;
+static double urand() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (rng_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int main(int argc, char** argv) {
+    double tol = argc > 1 ? atof(argv[1]) : 0.02;
+    int samples = argc > 2 ? atoi(argv[2]) : 20000;
+    if(tol <= 0.0) tol = 0.02;
+    if(samples < 100) samples = 100;
+    /* Domain starts on 2026-01-01 */
+    double start_day = 9497.5;
+    volatile double sink = 0.0;
+
+    printf("\n--- PORKCHOP SURROGATES (tol %.4f km/s) ---\n", tol);
+    printf(" %-20s %6s %7s %6s %6s %9s %9s %11s %6s %7s %7s %7s %6s %8s\n", "Destination", "cells", "evals", "fit s",
+           "exact", "est err", "max err", "miss>est", "us/ex", "us/sur", "min dv", "fallbk", "sweep", "payoff");
+    for(int idx = 0; idx < NUM_ORBIT_BODIES; idx++) {
+        const OrbitBody* b = &orbit_bodies[idx];
+        if(idx == TC_EARTH || b->central == TC_EARTH) continue;
+        PorkchopCtx pc;
+        pc.target = idx;
+        pc.planet = b->central == TC_SUN ? idx : b->central;
+        pc.start_day = start_day;
+        pc.calls = 0;
+        const TransferCost* tc = transfer_cost(idx, 0, 1);
+        double syn = tc->synodic_days, hoh = tc->transit_days;
+        double y0 = 0.5 * hoh, y1 = 1.5 * hoh;
+
+        Surrogate sg;
+        double tb = now_sec();
+        if(sg_build(&sg, exact_dv, &pc, 0.0, syn, y0, y1, tol, MAX_DEPTH) != 0) {
+            printf("out of memory\n");
+            return 1;
+        }
+        tb = now_sec() - tb;
+
+        /* Accuracy and speed on random points */
+        double* xs = malloc(sizeof(double) * (size_t)samples * 2);
+        if(!xs) { printf("out of memory\n"); return 1; }
+        for(int i = 0; i < samples; i++) {
+            xs[2 * i] = urand() * syn;
+            xs[2 * i + 1] = y0 + urand() * (y1 - y0);
+        }
+        double max_err = 0.0, max_est = 0.0, min_dv = INFINITY;
+        int misses = 0, compared = 0;
+        double te = now_sec();
+        double* exact = malloc(sizeof(double) * (size_t)samples);
+        if(!exact) { printf("out of memory\n"); return 1; }
+        for(int i = 0; i < samples; i++) exact[i] = exact_dv(xs[2 * i], xs[2 * i + 1], &pc);
+        te = now_sec() - te;
+        double ts = now_sec();
+        for(int i = 0; i < samples; i++) sink += sg_eval(&sg, xs[2 * i], xs[2 * i + 1], NULL);
+        ts = now_sec() - ts;
+        for(int i = 0; i < samples; i++) {
+            double err;
+            double v = sg_eval(&sg, xs[2 * i], xs[2 * i + 1], &err);
+            if(!isfinite(exact[i]) || !isfinite(err)) continue;
+            double d = fabs(v - exact[i]);
+            compared++;
+            if(d > max_err) max_err = d;
+            if(err > max_est) max_est = err;
+            if(d > err) misses++;
+            if(exact[i] < min_dv) min_dv = exact[i];
+        }
+
+        /* Feasibility sweep: is total dv within 1 km/s of the best arc? */
+        double threshold = min_dv + 1.0;
+        int fallbacks = 0, wrong = 0;
+        double tw = now_sec();
+        for(int i = 0; i < samples; i++) {
+            double v;
+            int used_exact;
+            int ok = sg_decide(&sg, xs[2 * i], xs[2 * i + 1], threshold, &v, &used_exact);
+            fallbacks += used_exact;
+            if(isfinite(exact[i]) && ok != (exact[i] <= threshold)) wrong++;
+        }
+        tw = now_sec() - tw;
+        /* Queries after which fit time plus surrogate sweeps beat exact calls */
+        double saved = (te - tw) / samples;
+        double payoff = saved > 0.0 ? tb / saved : INFINITY;
+
+        printf(" %-20s %6d %7ld %6.2f %6d %9.2e %9.2e %5d/%-5d %6.2f %7.3f %7.3f %6.2f%% %5.1fx %8.2e%s\n",
+               b->name, sg.num_cells, sg.fit_evals, tb, sg.exact_only, max_est, max_err, misses, compared,
+               te / samples * 1e6, ts / samples * 1e6, min_dv, 100.0 * fallbacks / samples, te / tw, payoff,
+               wrong ? " (MISCLASSIFIED)" : "");
+        free(exact);
+        free(xs);
+        sg_free(&sg);
+    }
+    printf("\n cells/evals/fit s: quadtree size, exact calls and time spent fitting\n");
+    printf(" exact: exact-only leaves; us/ex, us/sur: microseconds per exact / surrogate call\n");
+    printf(" est err / max err: largest error estimate vs largest observed error (km/s)\n");
+    printf(" miss>est: samples whose observed error exceeded the cell's estimate\n");
+    printf(" fallbk: share of feasibility decisions that needed the exact model\n");
+    printf(" sweep: exact-only sweep time / surrogate sweep time (fit excluded)\n");
+    printf(" payoff: queries needed before the fit time is recovered\n");
+    return sink == 12345.0;
+}
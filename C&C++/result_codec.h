@@ -0,0 +1,336 @@
+/*
+ result_codec.h
+ Per-column block encodings for planner result files
+
+ Overview:
+  - Result columns are cut into blocks of up to RC_BLOCK_ROWS values and
+    each block is stored with whichever encoding is smallest:
+    * RC_FOR     frame of reference: minimum + fixed-width bit-packing
+    * RC_DELTA   first value + FOR over successive differences (grids)
+    * RC_RLE     (value, run length) pairs, both FOR bit-packed
+    * RC_DICT    small dictionary + bit-packed codes (strategy codes)
+    * RC_XOR     doubles: each value XOR a linear prediction from the two
+                 previous bit patterns, bit-packed per group of 128 at
+                 the group's widest residual. Smoothly varying margins
+                 leave only the low mantissa bits in the residual.
+  - Bit-packed values are read with one unaligned 64-bit load, a shift and
+    a mask each, so the unpack loop is branch-free and fixed-width and
+    compiles to gathers and variable shifts with -O3 -march=native.
+  - Encoded block: u8 encoding, u32 payload bytes, payload. Buffers passed
+    to the decoders must have RC_PAD readable bytes past the payload.
+  - Decoders take the bytes available at the block and trust nothing read
+    from it: the block length, bit widths, RLE run count and lengths, and
+    dictionary size and codes are all checked, and a malformed block
+    decodes to 0 bytes consumed instead of reading or writing out of bounds.
+*/
+
+#ifndef RESULT_CODEC_H
+#define RESULT_CODEC_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define RC_BLOCK_ROWS 4096
+#define RC_PAD 16
+#define RC_MAX_DICT 16
+#define RC_XOR_GROUP 128
+
+#define RC_FOR 0
+#define RC_DELTA 1
+#define RC_RLE 2
+#define RC_DICT 3
+#define RC_XOR 4
+
+/* Worst case block size for n values */
+#define RC_MAX_BLOCK_BYTES(n) (16 + (size_t)(n) * 17 + RC_PAD)
+
+static inline int rc_bits(uint64_t v) {
+    return v ? 64 - __builtin_clzll(v) : 0;
+}
+
+static inline uint64_t rc_load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+/* Append n values of width bits at out; returns bytes written */
+static inline size_t rc_pack(uint8_t* out, const uint64_t* v, size_t n, int width) {
+    size_t bytes = (n * (size_t)width + 7) / 8;
+    memset(out, 0, bytes + 8);
+    if(width == 0) return 0;
+    size_t bit = 0;
+    for(size_t i = 0; i < n; i++, bit += (size_t)width) {
+        uint8_t* p = out + bit / 8;
+        int sh = (int)(bit & 7);
+        uint64_t lo = rc_load64(p) | (v[i] << sh);
+        memcpy(p, &lo, 8);
+        if(sh + width > 64) p[8] |= (uint8_t)(v[i] >> (64 - sh));
+    }
+    return bytes;
+}
+
+/* Unpack n values of width bits (branch-free per value for width <= 56) */
+static inline void rc_unpack(const uint8_t* in, uint64_t* v, size_t n, int width) {
+    if(width == 0) {
+        for(size_t i = 0; i < n; i++) v[i] = 0;
+        return;
+    }
+    if(width <= 56) {
+        uint64_t mask = (1ull << width) - 1;
+        for(size_t i = 0; i < n; i++) {
+            size_t bit = i * (size_t)width;
+            v[i] = (rc_load64(in + bit / 8) >> (bit & 7)) & mask;
+        }
+        return;
+    }
+    uint64_t mask = width == 64 ? ~0ull : (1ull << width) - 1;
+    for(size_t i = 0; i < n; i++) {
+        size_t bit = i * (size_t)width;
+        int sh = (int)(bit & 7);
+        uint64_t lo = rc_load64(in + bit / 8) >> sh;
+        uint64_t hi = sh ? (uint64_t)in[bit / 8 + 8] << (64 - sh) : 0;
+        v[i] = (lo | hi) & mask;
+    }
+}
+
+static inline void rc_put32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+static inline uint32_t rc_get32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+/* FOR payload: i32 min, u8 width, packed (v - min) */
+static inline size_t rc_enc_for(uint8_t* out, const int32_t* v, size_t n, uint64_t* tmp) {
+    int32_t mn = v[0], mx = v[0];
+    for(size_t i = 1; i < n; i++) {
+        mn = v[i] < mn ? v[i] : mn;
+        mx = v[i] > mx ? v[i] : mx;
+    }
+    int width = rc_bits((uint64_t)((int64_t)mx - mn));
+    for(size_t i = 0; i < n; i++) tmp[i] = (uint64_t)((int64_t)v[i] - mn);
+    rc_put32(out, (uint32_t)mn);
+    out[4] = (uint8_t)width;
+    return 5 + rc_pack(out + 5, tmp, n, width);
+}
+
+/* Whether n packed values of width bits are valid and fit in avail bytes;
+   sets *bytes to their size */
+static inline int rc_packed_fits(size_t n, int width, size_t avail, size_t* bytes) {
+    if(width > 64) return 0;
+    *bytes = (n * (size_t)width + 7) / 8;
+    return *bytes <= avail;
+}
+
+/* Decodes a FOR payload from at most avail bytes; returns bytes read, 0 if malformed */
+static inline size_t rc_dec_for(const uint8_t* in, size_t avail, int32_t* v, size_t n, uint64_t* tmp) {
+    size_t bytes;
+    if(avail < 5 || !rc_packed_fits(n, in[4], avail - 5, &bytes)) return 0;
+    int32_t mn = (int32_t)rc_get32(in);
+    rc_unpack(in + 5, tmp, n, in[4]);
+    for(size_t i = 0; i < n; i++) v[i] = (int32_t)((int64_t)mn + (int64_t)tmp[i]);
+    return 5 + bytes;
+}
+
+/* Encode one int column block with the smallest applicable encoding.
+   Returns total bytes including the 5-byte block header. */
+static inline size_t rc_encode_ints(uint8_t* out, const int32_t* v, size_t n, uint64_t* tmp, int32_t* scratch,
+                                    uint8_t* trial) {
+    uint8_t* best = out;
+    size_t best_len;
+
+    /* FOR */
+    out[0] = RC_FOR;
+    best_len = 5 + rc_enc_for(out + 5, v, n, tmp);
+    rc_put32(out + 1, (uint32_t)(best_len - 5));
+
+    /* DELTA: first value, FOR over differences */
+    if(n > 1) {
+        for(size_t i = 1; i < n; i++) scratch[i - 1] = (int32_t)((int64_t)v[i] - v[i - 1]);
+        trial[0] = RC_DELTA;
+        rc_put32(trial + 5, (uint32_t)v[0]);
+        size_t len = 9 + rc_enc_for(trial + 9, scratch, n - 1, tmp);
+        rc_put32(trial + 1, (uint32_t)(len - 5));
+        if(len < best_len) { memcpy(best, trial, len + RC_PAD); best_len = len; }
+    }
+
+    /* RLE: u32 runs, FOR(values), FOR(lengths) */
+    size_t runs = 0;
+    for(size_t i = 0; i < n; ) {
+        size_t j = i + 1;
+        while(j < n && v[j] == v[i]) j++;
+        scratch[runs] = v[i];
+        scratch[n + runs] = (int32_t)(j - i);
+        runs++;
+        i = j;
+    }
+    if(runs * 4 < n) {
+        trial[0] = RC_RLE;
+        rc_put32(trial + 5, (uint32_t)runs);
+        size_t len = 9;
+        len += rc_enc_for(trial + len, scratch, runs, tmp);
+        len += rc_enc_for(trial + len, scratch + n, runs, tmp);
+        rc_put32(trial + 1, (uint32_t)(len - 5));
+        if(len < best_len) { memcpy(best, trial, len + RC_PAD); best_len = len; }
+    }
+
+    /* DICT: u8 count, i32 entries, packed codes */
+    int32_t dict[RC_MAX_DICT];
+    int nd = 0, ok = 1;
+    for(size_t i = 0; i < n && ok; i++) {
+        int k = 0;
+        while(k < nd && dict[k] != v[i]) k++;
+        if(k == nd) {
+            if(nd == RC_MAX_DICT) { ok = 0; break; }
+            dict[nd++] = v[i];
+        }
+        tmp[i] = (uint64_t)k;
+    }
+    if(ok) {
+        int width = rc_bits((uint64_t)(nd - 1));
+        trial[0] = RC_DICT;
+        trial[5] = (uint8_t)nd;
+        for(int k = 0; k < nd; k++) rc_put32(trial + 6 + 4 * k, (uint32_t)dict[k]);
+        size_t off = 6 + 4 * (size_t)nd;
+        trial[off] = (uint8_t)width;
+        size_t len = off + 1 + rc_pack(trial + off + 1, tmp, n, width);
+        rc_put32(trial + 1, (uint32_t)(len - 5));
+        if(len < best_len) { memcpy(best, trial, len + RC_PAD); best_len = len; }
+    }
+    return best_len;
+}
+
+/* Block length from the header, or 0 if the block does not fit in avail bytes */
+static inline size_t rc_block_len(const uint8_t* in, size_t avail) {
+    if(avail < 5) return 0;
+    size_t body = rc_get32(in + 1);
+    return body <= avail - 5 ? 5 + body : 0;
+}
+
+/* Decode an int block of n values (tmp holds n, scratch 2n) from at most avail
+   bytes at in into v[n]; returns bytes consumed, 0 if the block is malformed */
+static inline size_t rc_decode_ints(const uint8_t* in, size_t avail, int32_t* v, size_t n, uint64_t* tmp,
+                                    int32_t* scratch) {
+    size_t len = rc_block_len(in, avail);
+    if(len == 0 || n == 0) return 0;
+    const uint8_t* p = in + 5;
+    size_t left = len - 5;
+    switch(in[0]) {
+    case RC_FOR:
+        return rc_dec_for(p, left, v, n, tmp) ? len : 0;
+    case RC_DELTA: {
+        if(left < 4) return 0;
+        int32_t acc = (int32_t)rc_get32(p);
+        v[0] = acc;
+        if(n > 1 && !rc_dec_for(p + 4, left - 4, scratch, n - 1, tmp)) return 0;
+        for(size_t i = 1; i < n; i++) {
+            acc = (int32_t)((int64_t)acc + scratch[i - 1]);
+            v[i] = acc;
+        }
+        return len;
+    }
+    case RC_RLE: {
+        if(left < 4) return 0;
+        size_t runs = rc_get32(p);
+        if(runs == 0 || runs > n) return 0;
+        size_t used = 4, got = rc_dec_for(p + used, left - used, scratch, runs, tmp);
+        if(!got) return 0;
+        used += got;
+        if(!rc_dec_for(p + used, left - used, scratch + n, runs, tmp)) return 0;
+        /* Run lengths must be positive and sum to exactly n */
+        size_t at = 0;
+        for(size_t r = 0; r < runs; r++) {
+            int32_t cnt = scratch[n + r];
+            if(cnt <= 0 || (size_t)cnt > n - at) return 0;
+            at += (size_t)cnt;
+        }
+        if(at != n) return 0;
+        at = 0;
+        for(size_t r = 0; r < runs; r++) {
+            int32_t val = scratch[r];
+            size_t cnt = (size_t)scratch[n + r];
+            for(size_t k = 0; k < cnt; k++) v[at + k] = val;
+            at += cnt;
+        }
+        return len;
+    }
+    case RC_DICT: {
+        if(left < 1) return 0;
+        int nd = p[0];
+        if(nd < 1 || nd > RC_MAX_DICT || left < 2 + 4 * (size_t)nd) return 0;
+        int32_t dict[RC_MAX_DICT];
+        for(int k = 0; k < nd; k++) dict[k] = (int32_t)rc_get32(p + 1 + 4 * k);
+        const uint8_t* q = p + 1 + 4 * (size_t)nd;
+        size_t bytes;
+        if(!rc_packed_fits(n, q[0], left - 2 - 4 * (size_t)nd, &bytes)) return 0;
+        rc_unpack(q + 1, tmp, n, q[0]);
+        uint64_t out_of_range = 0;
+        for(size_t i = 0; i < n; i++) out_of_range |= tmp[i] >= (uint64_t)nd;
+        if(out_of_range) return 0;
+        for(size_t i = 0; i < n; i++) v[i] = dict[tmp[i]];
+        return len;
+    }
+    }
+    return 0;
+}
+
+static inline uint64_t rc_f2u(double d) { uint64_t u; memcpy(&u, &d, 8); return u; }
+static inline double rc_u2f(uint64_t u) { double d; memcpy(&d, &u, 8); return d; }
+
+/* Encode doubles: u8 RC_XOR, u32 len, two raw u64 seeds, then per group of
+   RC_XOR_GROUP residuals a u8 width and the packed residuals */
+static inline size_t rc_encode_doubles(uint8_t* out, const double* v, size_t n, uint64_t* tmp) {
+    uint64_t p1 = n > 0 ? rc_f2u(v[0]) : 0;
+    uint64_t p2 = n > 1 ? rc_f2u(v[1]) : 0;
+    memcpy(out + 5, &p1, 8);
+    memcpy(out + 13, &p2, 8);
+    uint64_t a = p1, b = p2;
+    for(size_t i = 2; i < n; i++) {
+        uint64_t x = rc_f2u(v[i]);
+        tmp[i - 2] = x ^ (b + (b - a));    /* linear extrapolation of the bit pattern */
+        a = b;
+        b = x;
+    }
+    size_t len = 21;
+    size_t m = n > 2 ? n - 2 : 0;
+    for(size_t g = 0; g < m; g += RC_XOR_GROUP) {
+        size_t cnt = m - g < RC_XOR_GROUP ? m - g : RC_XOR_GROUP;
+        uint64_t widest = 0;
+        for(size_t i = 0; i < cnt; i++) widest |= tmp[g + i];
+        int width = rc_bits(widest);
+        out[len] = (uint8_t)width;
+        len += 1 + rc_pack(out + len + 1, tmp + g, cnt, width);
+    }
+    out[0] = RC_XOR;
+    rc_put32(out + 1, (uint32_t)(len - 5));
+    return len;
+}
+
+/* Decode n doubles (tmp holds n) from at most avail bytes at in; returns bytes
+   consumed, 0 if the block is malformed */
+static inline size_t rc_decode_doubles(const uint8_t* in, size_t avail, double* v, size_t n, uint64_t* tmp) {
+    size_t len = rc_block_len(in, avail);
+    if(len < 21 || in[0] != RC_XOR) return 0;
+    uint64_t a, b;
+    memcpy(&a, in + 5, 8);
+    memcpy(&b, in + 13, 8);
+    if(n > 0) v[0] = rc_u2f(a);
+    if(n > 1) v[1] = rc_u2f(b);
+    size_t m = n > 2 ? n - 2 : 0;
+    const uint8_t* p = in + 21;
+    const uint8_t* end = in + len;
+    for(size_t g = 0; g < m; g += RC_XOR_GROUP) {
+        size_t cnt = m - g < RC_XOR_GROUP ? m - g : RC_XOR_GROUP;
+        size_t bytes;
+        if(p >= end || !rc_packed_fits(cnt, p[0], (size_t)(end - p) - 1, &bytes)) return 0;
+        rc_unpack(p + 1, tmp + g, cnt, p[0]);
+        p += 1 + bytes;
+    }
+    for(size_t i = 0; i < m; i++) {
+        uint64_t x = tmp[i] ^ (b + (b - a));
+        v[i + 2] = rc_u2f(x);
+        a = b;
+        b = x;
+    }
+    return len;
+}
+
+#endif /* RESULT_CODEC_H */
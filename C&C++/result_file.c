@@ -0,0 +1,449 @@
+/*
+ result_file.c
+ Compressed columnar result files for planner sweeps
+
+ Overview:
+  - Runs a rocket x body x payload sweep through evaluate_mission() and
+    stores the rows (rocket, body, payload, strategy, tankers, success,
+    margin) three ways:
+    * CSV text, one row per line
+    * raw binary columns
+    * RCF blocks: columns cut into RC_BLOCK_ROWS rows, each column block
+      encoded with the smallest of the result_codec.h encodings and
+      written through async_out.h
+  - RCF layout: "RCF1", u32 columns, u64 rows, u32 block rows, then per
+    block a u32 row count followed by one encoded block per column. Every
+    column block carries its byte length, so a scan skips the columns its
+    query does not touch without decoding them.
+  - Scans each file for feasible count, mean margin and peak tanker count
+    per rocket/body pair, checks the decoded columns bit for bit against
+    the sweep and reports sizes and scan times.
+  - Hardware counters (perf_counters.h) are taken from the fastest scan of
+    each format and reported per row, next to the same ns/row.
+  - Scans validate what they read (row counts, block lengths, encodings,
+    rocket/body indices) and report a malformed file instead of trusting it.
+  - Without output_prefix the files go to $TMPDIR (default /tmp) and are
+    removed before exit; with it they are kept.
+
+ Build: gcc -O3 -march=native result_file.c -o result_file -lm -pthread
+ Usage: result_file [payloads_per_pair] [repeats] [output_prefix]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "mission_core.h"
+#include "result_codec.h"
+#include "async_out.h"
+#include "perf_counters.h"
+
+#define NCOLS 7
+#define COL_ROCKET 0
+#define COL_BODY 1
+#define COL_PAYLOAD 2
+#define COL_STRATEGY 3
+#define COL_TANKERS 4
+#define COL_SUCCESS 5
+#define COL_MARGIN 6
+
+#define NROCKETS (sizeof(rockets) / sizeof(rockets[0]))
+#define NBODIES (sizeof(bodies) / sizeof(bodies[0]))
+#define NPAIRS (NROCKETS * NBODIES)
+
+static const char* col_names[NCOLS] = {"rocket", "body", "payload", "strategy", "tankers", "success", "margin"};
+static const char* enc_names[] = {"FOR", "DELTA", "RLE", "DICT", "XOR"};
+
+typedef struct {
+    size_t n;
+    int32_t* col[NCOLS - 1];
+    double* margin;
+} Sweep;
+
+typedef struct {
+    long feasible[NPAIRS];
+    double margin_sum[NPAIRS];
+    int max_tankers[NPAIRS];
+} Summary;
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void free_sweep(Sweep* sw) {
+    for(int c = 0; c < NCOLS - 1; c++) free(sw->col[c]);
+    free(sw->margin);
+}
+
+/* Payload grid from 1 kg to twice the rocket's LEO payload; -1 when out of memory */
+static int run_sweep(Sweep* sw, size_t per_pair) {
+    sw->n = NPAIRS * per_pair;
+    int ok = 1;
+    for(int c = 0; c < NCOLS - 1; c++) ok &= (sw->col[c] = (int32_t*)malloc(sw->n * sizeof(int32_t))) != NULL;
+    sw->margin = (double*)malloc(sw->n * sizeof(double));
+    if(!ok || !sw->margin) {
+        free_sweep(sw);
+        return -1;
+    }
+    size_t at = 0;
+    for(size_t r = 0; r < NROCKETS; r++) {
+        for(size_t b = 0; b < NBODIES; b++) {
+            double top = 2.0 * rockets[r].payload_leo_kg;
+            for(size_t i = 0; i < per_pair; i++, at++) {
+                Mission m;
+                MissionResult res;
+                memset(&m, 0, sizeof(m));
+                m.rocket = rockets[r];
+                m.body = bodies[b];
+                m.payload_kg = (double)(int)(1.0 + top * (double)i / (double)per_pair);
+                int ok = evaluate_mission(&m, &res);
+                sw->col[COL_ROCKET][at] = (int32_t)r;
+                sw->col[COL_BODY][at] = (int32_t)b;
+                sw->col[COL_PAYLOAD][at] = (int32_t)m.payload_kg;
+                sw->col[COL_STRATEGY][at] = m.strategy;
+                sw->col[COL_TANKERS][at] = res.tankers;
+                sw->col[COL_SUCCESS][at] = ok;
+                sw->margin[at] = res.final_margin;
+            }
+        }
+    }
+    return 0;
+}
+
+/* -1 when the row names a rocket or body outside the catalog */
+static int summary_add(Summary* s, int32_t rocket, int32_t body, int32_t success, int32_t tankers, double margin) {
+    if(rocket < 0 || (size_t)rocket >= NROCKETS || body < 0 || (size_t)body >= NBODIES) return -1;
+    int pair = rocket * (int)NBODIES + body;
+    s->feasible[pair] += success;
+    s->margin_sum[pair] += success ? margin : 0.0;
+    s->max_tankers[pair] = tankers > s->max_tankers[pair] ? tankers : s->max_tankers[pair];
+    return 0;
+}
+
+static long file_size(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if(!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fclose(f);
+    return n;
+}
+
+/* Whole file plus RC_PAD readable bytes */
+static uint8_t* load_file(const char* path, size_t* len) {
+    long n = file_size(path);
+    if(n < 0) return NULL;
+    FILE* f = fopen(path, "rb");
+    uint8_t* buf = (uint8_t*)malloc((size_t)n + RC_PAD);
+    if(!f || !buf || fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        if(f) fclose(f);
+        free(buf);
+        return NULL;
+    }
+    fclose(f);
+    memset(buf + n, 0, RC_PAD);
+    *len = (size_t)n;
+    return buf;
+}
+
+/* ---------------------------------------------------------------------- */
+/* CSV and raw baselines                                                   */
+/* ---------------------------------------------------------------------- */
+
+static int write_csv(const Sweep* sw, const char* path) {
+    FILE* f = fopen(path, "w");
+    if(!f) return -1;
+    fprintf(f, "rocket,body,payload_kg,strategy,tankers,success,margin\n");
+    for(size_t i = 0; i < sw->n; i++) {
+        fprintf(f, "%d,%d,%d,%d,%d,%d,%.17g\n", sw->col[COL_ROCKET][i], sw->col[COL_BODY][i],
+                sw->col[COL_PAYLOAD][i], sw->col[COL_STRATEGY][i], sw->col[COL_TANKERS][i],
+                sw->col[COL_SUCCESS][i], sw->margin[i]);
+    }
+    return fclose(f);
+}
+
+static int scan_csv(const char* path, Summary* s) {
+    size_t len;
+    uint8_t* buf = load_file(path, &len);
+    if(!buf) return -1;
+    char* p = strchr((char*)buf, '\n');
+    char* end = (char*)buf + len;
+    int err = 0;
+    while(p && ++p < end && !err) {
+        int32_t v[NCOLS - 1];
+        for(int c = 0; c < NCOLS - 1; c++) {
+            v[c] = (int32_t)strtol(p, &p, 10);
+            p++;
+        }
+        double margin = strtod(p, &p);
+        err = summary_add(s, v[COL_ROCKET], v[COL_BODY], v[COL_SUCCESS], v[COL_TANKERS], margin);
+    }
+    free(buf);
+    return err;
+}
+
+/* u64 rows, then each column contiguous */
+static int write_raw(const Sweep* sw, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if(!f) return -1;
+    uint64_t n = sw->n;
+    fwrite(&n, sizeof(n), 1, f);
+    for(int c = 0; c < NCOLS - 1; c++) fwrite(sw->col[c], sizeof(int32_t), sw->n, f);
+    fwrite(sw->margin, sizeof(double), sw->n, f);
+    return fclose(f);
+}
+
+static int scan_raw(const char* path, Summary* s) {
+    size_t len;
+    uint8_t* buf = load_file(path, &len);
+    if(!buf) return -1;
+    uint64_t n = 0;
+    const size_t row_bytes = (NCOLS - 1) * sizeof(int32_t) + sizeof(double);
+    if(len >= 8) memcpy(&n, buf, 8);
+    if(len < 8 || n != (len - 8) / row_bytes || (len - 8) % row_bytes != 0) {
+        free(buf);
+        return -1;
+    }
+    const int32_t* col = (const int32_t*)(buf + 8);
+    const double* margin = (const double*)(buf + 8 + (NCOLS - 1) * n * sizeof(int32_t));
+    int err = 0;
+    for(size_t i = 0; i < n && !err; i++) {
+        err = summary_add(s, col[COL_ROCKET * n + i], col[COL_BODY * n + i], col[COL_SUCCESS * n + i],
+                          col[COL_TANKERS * n + i], margin[i]);
+    }
+    free(buf);
+    return err;
+}
+
+/* ---------------------------------------------------------------------- */
+/* RCF blocks                                                              */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    uint64_t tmp[RC_BLOCK_ROWS];
+    int32_t scratch[2 * RC_BLOCK_ROWS];
+    uint8_t trial[RC_MAX_BLOCK_BYTES(RC_BLOCK_ROWS)];
+    uint8_t out[RC_MAX_BLOCK_BYTES(RC_BLOCK_ROWS)];
+    int32_t ints[NCOLS - 1][RC_BLOCK_ROWS];
+    double margin[RC_BLOCK_ROWS];
+} RcfWork;
+
+static int write_rcf(const Sweep* sw, const char* path, size_t col_bytes[NCOLS], long enc_count[NCOLS][5]) {
+    AsyncOut* ao = ao_open(path, 0, AO_BLOCK_DEFAULT, 4);
+    if(!ao) return -1;
+    RcfWork* w = (RcfWork*)malloc(sizeof(RcfWork));
+    if(!w) {
+        ao_close(ao);
+        return -1;
+    }
+    uint32_t ncols = NCOLS, block_rows = RC_BLOCK_ROWS;
+    uint64_t nrows = sw->n;
+    ao_write(ao, "RCF1", 4);
+    ao_write(ao, &ncols, 4);
+    ao_write(ao, &nrows, 8);
+    ao_write(ao, &block_rows, 4);
+    for(size_t at = 0; at < sw->n; at += RC_BLOCK_ROWS) {
+        uint32_t rows = (uint32_t)(sw->n - at < RC_BLOCK_ROWS ? sw->n - at : RC_BLOCK_ROWS);
+        ao_write(ao, &rows, 4);
+        for(int c = 0; c < NCOLS; c++) {
+            size_t len = c == COL_MARGIN ? rc_encode_doubles(w->out, sw->margin + at, rows, w->tmp)
+                                         : rc_encode_ints(w->out, sw->col[c] + at, rows, w->tmp, w->scratch, w->trial);
+            ao_write(ao, w->out, len);
+            col_bytes[c] += len;
+            enc_count[c][w->out[0]]++;
+        }
+    }
+    free(w);
+    return ao_close(ao);
+}
+
+/* Summary query: decodes rocket, body, tankers, success and margin only.
+   With check set, also decodes payload/strategy and compares every column
+   with the sweep; returns the number of mismatching values, or -1 when the
+   file is unreadable or malformed (bad header, row counts, block lengths or
+   encodings, or rocket/body indices outside the catalog). */
+static long scan_rcf(const char* path, Summary* s, const Sweep* check) {
+    size_t len;
+    uint8_t* buf = load_file(path, &len);
+    if(!buf || len < 20 || memcmp(buf, "RCF1", 4) != 0 || rc_get32(buf + 4) != NCOLS) {
+        free(buf);
+        return -1;
+    }
+    RcfWork* w = (RcfWork*)malloc(sizeof(RcfWork));
+    if(!w) {
+        free(buf);
+        return -1;
+    }
+    uint64_t nrows;
+    memcpy(&nrows, buf + 8, 8);
+    const uint8_t* p = buf + 20;
+    const uint8_t* end = buf + len;
+    long bad = check && nrows != check->n ? -1 : 0;
+    for(size_t at = 0; at < nrows && bad >= 0; ) {
+        size_t rows = (size_t)(end - p) >= 4 ? rc_get32(p) : 0;
+        if(rows == 0 || rows > RC_BLOCK_ROWS || rows > nrows - at) {
+            bad = -1;
+            break;
+        }
+        p += 4;
+        for(int c = 0; c < NCOLS; c++) {
+            size_t avail = (size_t)(end - p), used;
+            if(c == COL_MARGIN) used = rc_decode_doubles(p, avail, w->margin, rows, w->tmp);
+            else if(!check && (c == COL_PAYLOAD || c == COL_STRATEGY)) used = rc_block_len(p, avail);
+            else used = rc_decode_ints(p, avail, w->ints[c], rows, w->tmp, w->scratch);
+            if(!used) {
+                bad = -1;
+                break;
+            }
+            p += used;
+        }
+        for(size_t i = 0; i < rows && bad >= 0; i++) {
+            if(summary_add(s, w->ints[COL_ROCKET][i], w->ints[COL_BODY][i], w->ints[COL_SUCCESS][i],
+                           w->ints[COL_TANKERS][i], w->margin[i]) != 0)
+                bad = -1;
+        }
+        if(bad < 0) break;
+        if(check) {
+            for(int c = 0; c < NCOLS - 1; c++)
+                for(size_t i = 0; i < rows; i++) bad += w->ints[c][i] != check->col[c][at + i];
+            for(size_t i = 0; i < rows; i++) bad += rc_f2u(w->margin[i]) != rc_f2u(check->margin[at + i]);
+        }
+        at += rows;
+    }
+    free(w);
+    free(buf);
+    return bad;
+}
+
+static int summary_equal(const Summary* a, const Summary* b) {
+    for(size_t k = 0; k < NPAIRS; k++) {
+        if(a->feasible[k] != b->feasible[k] || a->max_tankers[k] != b->max_tankers[k]) return 0;
+        if(a->margin_sum[k] != b->margin_sum[k]) return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    size_t per_pair = argc > 1 ? (size_t)atol(argv[1]) : 200000;
+    int repeats = argc > 2 ? atoi(argv[2]) : 5;
+    int keep = argc > 3;
+    if(per_pair < 1) per_pair = 1;
+    if(repeats < 1) repeats = 1;
+
+    char prefix[400];
+    if(keep) {
+        snprintf(prefix, sizeof(prefix), "%s", argv[3]);
+    } else {
+        const char* tmp = getenv("TMPDIR");
+        snprintf(prefix, sizeof(prefix), "%s/result_file.%d", tmp && *tmp ? tmp : "/tmp", (int)getpid());
+    }
+    char csv_path[512], raw_path[512], rcf_path[512];
+    snprintf(csv_path, sizeof(csv_path), "%s.csv", prefix);
+    snprintf(raw_path, sizeof(raw_path), "%s.bin", prefix);
+    snprintf(rcf_path, sizeof(rcf_path), "%s.rcf", prefix);
+
+    Sweep sw;
+    int status = 1;
+    double t0 = now_sec();
+    if(run_sweep(&sw, per_pair) != 0) {
+        printf("out of memory\n");
+        return 1;
+    }
+    printf("Sweep: %zu rows (%zu pairs x %zu payloads) in %.2f s\n", sw.n, (size_t)NPAIRS, per_pair, now_sec() - t0);
+
+    size_t col_bytes[NCOLS] = {0};
+    long enc_count[NCOLS][5];
+    memset(enc_count, 0, sizeof(enc_count));
+    if(write_csv(&sw, csv_path) != 0 || write_raw(&sw, raw_path) != 0 ||
+       write_rcf(&sw, rcf_path, col_bytes, enc_count) != 0) {
+        fprintf(stderr, "Error writing result files\n");
+        goto done;
+    }
+
+    long bad = 0;
+    Summary ref, got;
+    memset(&ref, 0, sizeof(ref));
+    memset(&got, 0, sizeof(got));
+    bad = scan_rcf(rcf_path, &got, &sw);
+    if(bad < 0 || scan_raw(raw_path, &ref) != 0) {
+        fprintf(stderr, "RCF round trip failed: cannot read %s\n", bad < 0 ? rcf_path : raw_path);
+        goto done;
+    }
+    if(bad != 0 || !summary_equal(&ref, &got)) {
+        fprintf(stderr, "RCF round trip failed: %ld mismatching values\n", bad);
+        goto done;
+    }
+    printf("RCF round trip: all %zu x %d values identical\n\n", sw.n, NCOLS);
+
+    printf("%-10s %12s %10s   encodings used (blocks)\n", "column", "bytes", "bits/row");
+    for(int c = 0; c < NCOLS; c++) {
+        printf("%-10s %12zu %10.3f  ", col_names[c], col_bytes[c], 8.0 * col_bytes[c] / sw.n);
+        for(int e = 0; e < 5; e++)
+            if(enc_count[c][e]) printf(" %s:%ld", enc_names[e], enc_count[c][e]);
+        printf("\n");
+    }
+
+    long csv_size = file_size(csv_path), raw_size = file_size(raw_path), rcf_size = file_size(rcf_path);
+    printf("\n%-8s %14s %10s %12s %12s\n", "format", "bytes", "vs rcf", "scan ms", "ns/row");
+    const char* names[3] = {"csv", "raw", "rcf"};
+    long sizes[3] = {csv_size, raw_size, rcf_size};
+    PerfCounters pc;
+    PcSample best_ps[3];
+    pc_open(&pc);
+    for(int k = 0; k < 3; k++) {
+        double best = 1e30;
+        int reps = k == 0 ? 1 : repeats;    /* text parsing is slow; once is enough */
+        for(int r = 0; r < reps; r++) {
+            Summary s;
+            PcSample ps;
+            memset(&s, 0, sizeof(s));
+            pc_start(&pc, &ps);
+            double t = now_sec();
+            long err;
+            if(k == 0) err = scan_csv(csv_path, &s);
+            else if(k == 1) err = scan_raw(raw_path, &s);
+            else err = scan_rcf(rcf_path, &s, NULL);
+            t = now_sec() - t;
+            pc_stop(&pc, &ps);
+            if(t < best) {
+                best = t;
+                best_ps[k] = ps;
+            }
+            if(err != 0) printf("  (%s scan failed)\n", names[k]);
+            else if(!summary_equal(&ref, &s)) printf("  (%s summary differs)\n", names[k]);
+        }
+        printf("%-8s %14ld %9.1fx %12.2f %12.2f\n", names[k], sizes[k], (double)sizes[k] / rcf_size, best * 1e3,
+               best * 1e9 / sw.n);
+    }
+    printf("\n");
+    pc_print_status(stdout, &pc);
+    pc_print_header(stdout, 8);
+    for(int k = 0; k < 3; k++) pc_print_row(stdout, 8, names[k], &best_ps[k], (double)sw.n);
+    pc_close(&pc);
+
+    printf("\n%-28s %8s %10s %12s\n", "rocket -> body", "feasible", "mean dv", "max tankers");
+    for(size_t r = 0; r < NROCKETS; r++) {
+        for(size_t b = 0; b < NBODIES; b++) {
+            size_t k = r * NBODIES + b;
+            char label[64];
+            snprintf(label, sizeof(label), "%.14s -> %.10s", rockets[r].name, bodies[b].name);
+            printf("%-28s %7.1f%% %10.3f %12d\n", label, 100.0 * ref.feasible[k] / per_pair,
+                   ref.feasible[k] ? ref.margin_sum[k] / ref.feasible[k] : 0.0, ref.max_tankers[k]);
+        }
+    }
+
+    status = 0;
+
+done:
+    if(!keep) {
+        remove(csv_path);
+        remove(raw_path);
+        remove(rcf_path);
+    }
+    free_sweep(&sw);
+    return status;
+}
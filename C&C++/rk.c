@@ -1,15 +1,25 @@
 // Print numbers from 1 to 10
 #include <stdio.h>
+#include "fastout.h"
 
 int main() {
 int i, a[]={23,45,34,43,34};
-printf("Array= %d ,%d, %d, %d, %d \n",a[0], a[1], a[2], a[3], a[4]);
+FastOut out;
+if (fo_open(&out, 1) != 0) return 1;
+fo_puts(&out, "Array= ");
+for (i = 0; i < 5; ++i)
+  {
+    if (i == 1) fo_puts(&out, " ,");
+    else if (i > 1) fo_puts(&out, ", ");
+    fo_int(&out, a[i]);
+  }
+fo_puts(&out, " \n");
 
   for (i = 1; i < 11; ++i)
   {
-    printf("%d ", i);
+    fo_int(&out, i);
+    fo_putc(&out, ' ');
   }
-  return 0;
+  return fo_close(&out) == 0 ? 0 : 1;
 }
 
-
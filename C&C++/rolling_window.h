@@ -0,0 +1,128 @@
+/*
+ rolling_window.h
+ Incremental rolling-window statistics for streaming station temperatures
+
+ Overview:
+  - Each station keeps 7, 30 and 365 reading windows that are updated on
+    every append instead of rescanning the temperature arrays:
+    * mean from a Kahan-compensated running sum (add new, subtract expired)
+    * min/max from monotonic deques of reading sequence numbers
+  - Append is O(1) amortized per window; rw_query() is a plain lookup.
+  - Readings are kept in a ring of the last RW_HISTORY values, which is all
+    the windows ever need to look back.
+*/
+
+#ifndef ROLLING_WINDOW_H
+#define ROLLING_WINDOW_H
+
+#include <string.h>
+
+#define RW_NUM_WINDOWS 3
+#define RW_HISTORY 365          /* must be >= the widest window */
+
+static const int rw_widths[RW_NUM_WINDOWS] = {7, 30, 365};
+
+/* Running sum with Kahan compensation so long streams do not drift */
+typedef struct {
+    double sum;
+    double comp;
+} KahanSum;
+
+static inline void kahan_add(KahanSum* k, double x) {
+    double y = x - k->comp;
+    double t = k->sum + y;
+    k->comp = (t - k->sum) - y;
+    k->sum = t;
+}
+
+/* Monotonic deque of sequence numbers, stored as a ring of RW_HISTORY */
+typedef struct {
+    long seq[RW_HISTORY];
+    int head;
+    int len;
+} MonoDeque;
+
+typedef struct {
+    int width;
+    KahanSum sum;
+    MonoDeque min_q;    /* values increasing from front to back */
+    MonoDeque max_q;    /* values decreasing from front to back */
+} RollingWindow;
+
+typedef struct {
+    long count;                 /* readings appended so far */
+    double hist[RW_HISTORY];    /* hist[seq % RW_HISTORY] */
+    RollingWindow win[RW_NUM_WINDOWS];
+} RollingStats;
+
+/* Current values of one window */
+typedef struct {
+    int width;
+    int samples;        /* min(count, width) */
+    double mean;
+    double min;
+    double max;
+} WindowResult;
+
+static inline void rw_init(RollingStats* rs) {
+    memset(rs, 0, sizeof(*rs));
+    for(int w = 0; w < RW_NUM_WINDOWS; w++) rs->win[w].width = rw_widths[w];
+}
+
+static inline long dq_front(const MonoDeque* d) { return d->seq[d->head]; }
+static inline long dq_back(const MonoDeque* d) { return d->seq[(d->head + d->len - 1) % RW_HISTORY]; }
+static inline void dq_pop_front(MonoDeque* d) { d->head = (d->head + 1) % RW_HISTORY; d->len--; }
+static inline void dq_pop_back(MonoDeque* d) { d->len--; }
+static inline void dq_push_back(MonoDeque* d, long s) {
+    d->seq[(d->head + d->len) % RW_HISTORY] = s;
+    d->len++;
+}
+
+static inline double rw_value(const RollingStats* rs, long seq) {
+    return rs->hist[seq % RW_HISTORY];
+}
+
+/* Append one reading and update every window */
+static inline void rw_append(RollingStats* rs, double x) {
+    long seq = rs->count;
+    double expired[RW_NUM_WINDOWS];
+
+    /* Read the values leaving each window before the ring slot is reused */
+    for(int w = 0; w < RW_NUM_WINDOWS; w++) {
+        int width = rs->win[w].width;
+        expired[w] = (seq >= width) ? rw_value(rs, seq - width) : 0.0;
+    }
+    rs->hist[seq % RW_HISTORY] = x;
+    rs->count++;
+
+    for(int w = 0; w < RW_NUM_WINDOWS; w++) {
+        RollingWindow* win = &rs->win[w];
+        long oldest = seq - win->width + 1;
+
+        kahan_add(&win->sum, x);
+        if(seq >= win->width) kahan_add(&win->sum, -expired[w]);
+
+        while(win->min_q.len > 0 && dq_front(&win->min_q) < oldest) dq_pop_front(&win->min_q);
+        while(win->min_q.len > 0 && rw_value(rs, dq_back(&win->min_q)) >= x) dq_pop_back(&win->min_q);
+        dq_push_back(&win->min_q, seq);
+
+        while(win->max_q.len > 0 && dq_front(&win->max_q) < oldest) dq_pop_front(&win->max_q);
+        while(win->max_q.len > 0 && rw_value(rs, dq_back(&win->max_q)) <= x) dq_pop_back(&win->max_q);
+        dq_push_back(&win->max_q, seq);
+    }
+}
+
+/* Look up the current rolling values of window w (index into rw_widths).
+   Returns 0 on success, -1 if the station has no readings yet. */
+static inline int rw_query(const RollingStats* rs, int w, WindowResult* out) {
+    const RollingWindow* win = &rs->win[w];
+    out->width = win->width;
+    out->samples = (rs->count < win->width) ? (int)rs->count : win->width;
+    if(out->samples == 0) return -1;
+    out->mean = win->sum.sum / out->samples;
+    out->min = rw_value(rs, dq_front(&win->min_q));
+    out->max = rw_value(rs, dq_front(&win->max_q));
+    return 0;
+}
+
+#endif /* ROLLING_WINDOW_H */
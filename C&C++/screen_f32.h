@@ -0,0 +1,151 @@
+/*
+ screen_f32.h
+ Float32 feasibility screening with per-lane error bounds
+
+ Overview:
+  - Evaluates the evaluate_mission() decision (capability, margin, strategy
+    thresholds, tanker count, feasibility) for a payload array against one
+    rocket/body pair, in float, so twice as many lanes fit a SIMD register.
+  - Every lane carries a bound on its float rounding error:
+      m0, mf exact or rounded once            -> ratio off by <= 3u
+      sf_logf within SF_LOGF_ULPS ulp         -> |dL| <= 3u + 2 SF_LOGF_ULPS u L
+      coefficient (Isp g0 staging) rounded    -> |dcap| <= u coef (4 + (2 SF_LOGF_ULPS + 2) L)
+      required dv rounded once, subtraction   -> + u (req + |margin|)
+    with u = 2^-24, doubled for safety.
+  - A lane is borderline when a decision threshold (margin 0, kick-stage
+    -1.5 km/s, gravity-assist -4.5 km/s, or a whole number of tankers) lies
+    within its bound. sf_recheck() re-runs borderline lanes through
+    evaluate_mission() in double, so the float path never misclassifies
+    feasibility.
+  - The bound assumes IEEE single precision, so the header refuses to
+    compile under -ffast-math. logf is replaced by sf_logf (exponent split
+    plus an atanh series, at most 1.97 ulp over [1, 32], the whole wet/dry
+    ratio range), which the vectoriser inlines without libmvec.
+  - Build with -fno-trapping-math: it leaves every result bit-identical
+    (only FP exception flags go unmodelled) and lets GCC if-convert the
+    selects in sf_screen(), which otherwise stays scalar.
+*/
+
+#ifndef SCREEN_F32_H
+#define SCREEN_F32_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "mission_core.h"
+
+#ifdef __FAST_MATH__
+#error "screen_f32.h: the error bounds need IEEE arithmetic, build without -ffast-math"
+#endif
+
+#define SF_LOGF_ULPS 4.0f       /* sf_logf accuracy, twice the measured 1.97 ulp */
+#define SF_KICK_LIMIT 1.5       /* kick stage covers margins above -1.5 km/s */
+#define SF_ASSIST_BONUS 4.5
+
+#define SF_INFEASIBLE 0
+#define SF_FEASIBLE 1
+#define SF_RECHECK 2
+
+/* Per rocket/body constants, derived with the same rules as evaluate_mission() */
+typedef struct {
+    double coef;            /* Isp * g0 * staging / 1000 */
+    double wet, dry, leo;
+    double req;             /* ascent + transfer + capture */
+    double per_tanker;
+    int titan, refuel;
+} SfPair;
+
+static inline SfPair sf_pair(const Rocket* r, const Body* b) {
+    SfPair c;
+    c.coef = r->isp_avg * G0 / 1000.0 * r->staging_factor;
+    c.wet = r->wet_mass_kg;
+    c.dry = r->dry_mass_kg;
+    c.leo = r->payload_leo_kg;
+    c.req = EARTH_ASCENT_COST + b->dv_transfer + b->dv_capture;
+    c.per_tanker = r->refuel_dv_per_tanker;
+    c.titan = strstr(b->name, "Titan") != NULL;
+    c.refuel = strstr(r->name, "Starship") != NULL;
+    return c;
+}
+
+/* Natural log of a positive normal float: x = 2^e m with m in [sqrt(1/2), sqrt(2)),
+   log(m) = 2 atanh(s), s = (m - 1) / (m + 1), |s| <= 0.1716. m - 1 is exact
+   (Sterbenz) and ln 2 is split so e ln 2 adds no rounding of its own. */
+static inline float sf_logf(float x) {
+    uint32_t bits, mbits;
+    float m;
+    memcpy(&bits, &x, sizeof(bits));
+    int e = (int)(bits >> 23) - 127;
+    mbits = (bits & 0x007fffffu) | 0x3f800000u;
+    uint32_t big = mbits > 0x3fb504f3u;  /* m > sqrt(2): halve m, bump e */
+    mbits -= big << 23;
+    e += (int)big;
+    memcpy(&m, &mbits, sizeof(m));
+    float f = m - 1.0f;
+    float s = f / (2.0f + f);
+    float z = s * s;
+    float poly = 0.666666667f + z * (0.4f + z * (0.285714286f + z * 0.222222222f));
+    float fe = (float)e;
+    return fe * 0.693145752f + ((2.0f * s + s * z * poly) + fe * 1.42860677e-06f);
+}
+
+/* Float kernel: margin before strategy, tanker count and status per payload.
+   Straight-line with bitwise masks so the loop vectorises. */
+static inline void sf_screen(const SfPair* pc, const float* payload, float* margin, int* tankers,
+                             unsigned char* status, size_t n) {
+    const float u = 2.0f * (FLT_EPSILON * 0.5f);
+    float coef = (float)pc->coef, wet = (float)pc->wet, dry = (float)pc->dry, leo = (float)pc->leo;
+    float req = (float)pc->req, per = (float)pc->per_tanker;
+    float inv_per = per > 0.0f ? 1.0f / per : 0.0f;
+    float slope = 2.0f * SF_LOGF_ULPS + 2.0f;
+    int titan = pc->titan, refuel = pc->refuel & !pc->titan & (per > 0.0f);
+    int kick = !pc->titan & !pc->refuel;
+    for(size_t i = 0; i < n; i++) {
+        float p = payload[i];
+        float L = sf_logf((wet + p) / (dry + p));
+        int fits = p <= leo;
+        float cap = fits ? coef * L : 0.0f;
+        float m = cap - req;
+        float err = u * ((fits ? coef * (4.0f + slope * L) : 0.0f) + req + fabsf(m));
+
+        /* Tankers: ceil(shortage / per) with shortage = -m when refuelling */
+        float t = -m * inv_per;
+        float tc = ceilf(t);
+        float tol = err * inv_per + u * fabsf(t);
+        int short_m = m < 0.0f;
+        int near_int = refuel & short_m & ((t - floorf(t) <= tol) | (tc - t <= tol));
+        /* Decision thresholds on the base margin */
+        int border = (fabsf(m) <= err) | (kick & (fabsf(m + (float)SF_KICK_LIMIT) <= err)) |
+                     (titan & (fabsf(m + (float)SF_ASSIST_BONUS) <= err)) | near_int;
+        int ok = (!short_m) | refuel | (titan & (m + (float)SF_ASSIST_BONUS >= 0.0f)) |
+                 (kick & (m > -(float)SF_KICK_LIMIT));
+        margin[i] = m;
+        tankers[i] = (refuel & short_m) ? (int)tc : 0;
+        status[i] = (unsigned char)(border ? SF_RECHECK : ok);
+    }
+}
+
+/* Resolve borderline lanes with the full double-precision planner; returns the count.
+   Borderline lanes are rare, so memchr skips to each one. */
+static inline size_t sf_recheck(const Rocket* r, const Body* b, const float* payload, float* margin,
+                                int* tankers, unsigned char* status, size_t n) {
+    size_t count = 0;
+    unsigned char* hit;
+    for(size_t i = 0; i < n && (hit = memchr(status + i, SF_RECHECK, n - i)) != NULL; i++) {
+        i = (size_t)(hit - status);
+        Mission m;
+        MissionResult res;
+        memset(&m, 0, sizeof(m));
+        m.rocket = *r;
+        m.body = *b;
+        m.payload_kg = payload[i];
+        status[i] = evaluate_mission(&m, &res) ? SF_FEASIBLE : SF_INFEASIBLE;
+        margin[i] = (float)(res.capability - res.total_required);
+        tankers[i] = res.tankers;
+        count++;
+    }
+    return count;
+}
+
+#endif /* SCREEN_F32_H */
@@ -0,0 +1,204 @@
+/*
+ simd_dispatch_bench.c
+ Benchmark matrix for the runtime-dispatched SIMD kernels
+
+ Overview:
+  - Prints the detected CPU features and the ISA level sk_kernels() binds
+    to (honouring SIMD_FORCE_ISA), then runs every simd_kernels.h kernel
+    with every ISA variant this CPU supports.
+  - Each variant is checked against the scalar one: capability within a
+    relative 1e-14 (and against libm log() via calc_capability()),
+    temp_stats and csv_separators exactly.
+  - Reports ns per element and speedup over scalar for each cell; levels
+    the CPU lacks are listed as n/a. A second table gives hardware
+    counters per element for each cell (perf_counters.h).
+
+ Build: gcc -O3 simd_dispatch_bench.c -o simd_dispatch_bench -lm
+ Usage: simd_dispatch_bench [elements] [repeats]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "mission_core.h"
+#include "simd_kernels.h"
+#include "perf_counters.h"
+
+#define NKERNELS 3
+
+static const char* kernel_names[NKERNELS] = {"capability", "temp_stats", "csv_separators"};
+
+typedef struct {
+    size_t n;
+    double* payload;
+    double* cap_out;
+    double* temps;
+    uint8_t* csv;
+    size_t csv_len;
+    size_t* seps;
+    SkRocket rocket;
+} Inputs;
+
+static void make_inputs(Inputs* in, size_t n) {
+    in->n = n;
+    in->payload = (double*)malloc(n * sizeof(double));
+    in->cap_out = (double*)malloc(n * sizeof(double));
+    in->temps = (double*)malloc(n * sizeof(double));
+    const Rocket* r = &rockets[0];
+    in->rocket.wet = r->wet_mass_kg;
+    in->rocket.dry = r->dry_mass_kg;
+    in->rocket.coef = r->isp_avg * G0 / 1000.0 * r->staging_factor;
+    in->rocket.leo = r->payload_leo_kg;
+    srand(5);
+    for(size_t i = 0; i < n; i++) {
+        in->payload[i] = 1.2 * r->payload_leo_kg * (double)i / (double)n;
+        in->temps[i] = 15.0 + 12.0 * sin((double)i * 0.0172) + (rand() % 1000) * 0.01;
+    }
+    /* CSV text of about n bytes with quoted names containing commas */
+    in->csv = (uint8_t*)malloc(n + 128);
+    size_t len = 0;
+    while(len + 64 < n) {
+        len += (size_t)sprintf((char*)in->csv + len, "%s,\"Titan, Saturn\",%d.%d,2031-%02d-%02d\n",
+                               rand() % 3 ? "Starship" : "\"SLS, Block 1\"", rand() % 150000, rand() % 10,
+                               1 + rand() % 12, 1 + rand() % 28);
+    }
+    in->csv_len = len;
+    in->seps = (size_t*)malloc((len + 64) * sizeof(size_t));
+}
+
+/* Time one kernel/variant; returns best seconds per call and a result digest.
+   ps covers all repeats. */
+static double run_cell(const SimdKernels* k, int kernel, Inputs* in, int repeats, double* digest, PerfCounters* pc,
+                       PcSample* ps) {
+    double best = 1e30;
+    pc_start(pc, ps);
+    for(int r = 0; r < repeats; r++) {
+        double t = pc_now();
+        if(kernel == 0) {
+            k->capability(in->payload, in->n, &in->rocket, in->cap_out);
+            *digest = in->cap_out[in->n / 3];
+        } else if(kernel == 1) {
+            SkTempStats st;
+            k->temp_stats(in->temps, in->n, &st);
+            *digest = st.sum + st.min * 1e6 + st.max * 1e9;
+        } else {
+            uint64_t inq = 0;
+            size_t cnt = k->csv_separators(in->csv, 0, in->csv_len, &inq, in->seps);
+            *digest = (double)cnt + (double)in->seps[cnt / 2];
+        }
+        t = pc_now() - t;
+        best = t < best ? t : best;
+    }
+    pc_stop(pc, ps);
+    return best;
+}
+
+/* Compare a variant's full output against scalar; returns a mismatch count */
+static long verify(const SimdKernels* k, const SimdKernels* ref, int kernel, Inputs* in, double* max_rel) {
+    long bad = 0;
+    if(kernel == 0) {
+        double* a = (double*)malloc(in->n * sizeof(double));
+        k->capability(in->payload, in->n, &in->rocket, a);
+        ref->capability(in->payload, in->n, &in->rocket, in->cap_out);
+        for(size_t i = 0; i < in->n; i++) {
+            double ref_libm = calc_capability(&rockets[0], in->payload[i]);
+            double e1 = fabs(a[i] - in->cap_out[i]), e2 = fabs(a[i] - ref_libm);
+            double scale = fabs(ref_libm) > 0 ? fabs(ref_libm) : 1.0;
+            double rel = (e1 > e2 ? e1 : e2) / scale;
+            if(rel > *max_rel) *max_rel = rel;
+            bad += rel > 1e-14;
+        }
+        free(a);
+    } else if(kernel == 1) {
+        SkTempStats x, y;
+        k->temp_stats(in->temps, in->n, &x);
+        ref->temp_stats(in->temps, in->n, &y);
+        bad = x.min != y.min || x.max != y.max || x.sum != y.sum;
+    } else {
+        size_t* a = (size_t*)malloc((in->csv_len + 64) * sizeof(size_t));
+        uint64_t q1 = 0, q2 = 0;
+        size_t na = k->csv_separators(in->csv, 0, in->csv_len, &q1, a);
+        size_t nb = ref->csv_separators(in->csv, 0, in->csv_len, &q2, in->seps);
+        bad = na != nb;
+        for(size_t i = 0; i < na && i < nb; i++) bad += a[i] != in->seps[i];
+        free(a);
+    }
+    return bad;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? (size_t)atol(argv[1]) : (1u << 20);
+    int repeats = argc > 2 ? atoi(argv[2]) : 20;
+    if(n < 1024) n = 1024;
+    if(repeats < 1) repeats = 1;
+
+    cd_print_features(stdout);
+    /* cd_select_isa() falls back to the best level when the forced one is refused */
+    const char* force = getenv("SIMD_FORCE_ISA");
+    CdIsa bound = sk_kernels()->isa;
+    int forced = force && *force && cd_parse_isa(force) == (int)bound;
+    printf("Best level: %s, bound level: %s%s\n\n", cd_isa_name(cd_best_isa()), cd_isa_name(bound),
+           forced ? " (SIMD_FORCE_ISA)" : "");
+
+    Inputs in;
+    make_inputs(&in, n);
+    SimdKernels scalar;
+    sk_bind(&scalar, CD_SCALAR);
+    PerfCounters pc;
+    PcSample ps[NKERNELS][CD_NUM_ISA];
+    int measured[NKERNELS][CD_NUM_ISA];
+    memset(measured, 0, sizeof(measured));
+    pc_open(&pc);
+
+    printf("%-16s", "ns/element");
+    for(int isa = 0; isa < CD_NUM_ISA; isa++) printf(" %16s", cd_isa_name((CdIsa)isa));
+    printf("\n");
+    long failures = 0;
+    double max_rel = 0;
+    for(int kernel = 0; kernel < NKERNELS; kernel++) {
+        size_t elems = kernel == 2 ? in.csv_len : n;
+        double base = 0, digest;
+        printf("%-16s", kernel_names[kernel]);
+        for(int isa = 0; isa < CD_NUM_ISA; isa++) {
+            if(!cd_isa_supported((CdIsa)isa)) {
+                printf(" %16s", "n/a");
+                continue;
+            }
+            SimdKernels k;
+            sk_bind(&k, (CdIsa)isa);
+            long bad = verify(&k, &scalar, kernel, &in, &max_rel);
+            failures += bad;
+            double t = run_cell(&k, kernel, &in, repeats, &digest, &pc, &ps[kernel][isa]);
+            measured[kernel][isa] = 1;
+            if(isa == CD_SCALAR) base = t;
+            char cell[32];
+            snprintf(cell, sizeof(cell), "%.3f (%.1fx)%s", t * 1e9 / elems, base / t, bad ? "!" : "");
+            printf(" %16s", cell);
+        }
+        printf("\n");
+    }
+    printf("\ncapability max relative error vs scalar/libm: %.2e\n", max_rel);
+    printf("Verification: %s\n", failures ? "FAILED (cells marked !)" : "all variants match");
+
+    printf("\n");
+    pc_print_status(stdout, &pc);
+    pc_print_header(stdout, 24);
+    for(int kernel = 0; kernel < NKERNELS; kernel++) {
+        double elems = (double)(kernel == 2 ? in.csv_len : n) * repeats;
+        for(int isa = 0; isa < CD_NUM_ISA; isa++) {
+            if(!measured[kernel][isa]) continue;
+            char label[48];
+            snprintf(label, sizeof(label), "%s/%s", kernel_names[kernel], cd_isa_name((CdIsa)isa));
+            pc_print_row(stdout, 24, label, &ps[kernel][isa], elems);
+        }
+    }
+    pc_close(&pc);
+    free(in.payload);
+    free(in.cap_out);
+    free(in.temps);
+    free(in.csv);
+    free(in.seps);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,386 @@
+/*
+ simd_kernels.h
+ SIMD kernels with one variant per ISA level, bound at runtime
+
+ Overview:
+  - Kernels shared by the planner and station tools:
+    * capability      rocket-equation delta-v over a payload array
+                      (calc_capability() for one rocket, many payloads);
+                      used by numa_sweep.c
+    * temp_stats      min / max / sum of a temperature series; used by
+                      temp_pyramid.h for partial leaf blocks (tempstream.c)
+    * csv_separators  comma/newline offsets outside quoted fields, for
+                      64-byte blocks; used by mission_import.c
+  - Only these kernels are dispatched. kepler_batch.h, screen_sweep.c and
+    result_codec.h still rely on the compiler vectorizing for the build
+    machine (-march=native).
+  - Each kernel body is written once. capability is a plain loop that the
+    compiler vectorizes separately for every CD_TARGET_* wrapper;
+    temp_stats uses GCC vector types sized to each target's registers;
+    csv_separators has hand-written compare/movemask variants. The scalar
+    variants are compiled with vectorization off so they serve as the
+    reference on any CPU.
+  - The log in capability is a branch-free polynomial (relative error
+    below 1e-15 against libm) so it vectorizes without -ffast-math.
+  - temp_stats accumulates in SK_LANES fixed lanes combined in a fixed
+    order, so every variant returns bit-identical sums.
+  - sk_bind() fills a SimdKernels table for one ISA level; sk_kernels()
+    binds once to cd_select_isa() (SIMD_FORCE_ISA overrides it).
+*/
+
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+#include "cpu_dispatch.h"
+#if CD_X86
+#include <immintrin.h>
+#endif
+
+#define SK_LANES 8
+#define SK_INLINE static inline __attribute__((always_inline))
+#define SK_NOVEC __attribute__((optimize("no-tree-vectorize")))
+
+/* Per-rocket constants for the capability kernel */
+typedef struct {
+    double wet, dry;
+    double coef;            /* Isp * g0 / 1000 * staging factor */
+    double leo;             /* payloads above this get 0 */
+} SkRocket;
+
+typedef struct {
+    double min, max, sum;
+} SkTempStats;
+
+typedef struct {
+    CdIsa isa;
+    void (*capability)(const double* payload, size_t n, const SkRocket* r, double* out);
+    void (*temp_stats)(const double* v, size_t n, SkTempStats* out);
+    size_t (*csv_separators)(const uint8_t* data, size_t begin, size_t end, uint64_t* in_quote, size_t* out);
+} SimdKernels;
+
+/* ---------------------------------------------------------------------- */
+/* Kernel bodies                                                           */
+/* ---------------------------------------------------------------------- */
+
+/* ln(x) for positive normal x: x = m * 2^e with m in [sqrt(1/2), sqrt(2)),
+   ln(m) = 2 atanh(s), s = (m - 1) / (m + 1), |s| < 0.1716 */
+SK_INLINE double sk_log(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, 8);
+    /* Range reduction in integer arithmetic: no FP compares or int64 ->
+       double conversions, which SSE2/AVX2 cannot vectorize */
+    uint64_t mbits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+    uint64_t big = (uint64_t)((int64_t)mbits > (int64_t)0x3ff6a09e667f3bcdull);   /* m > sqrt(2) */
+    mbits -= big << 52;                                     /* m /= 2 */
+    uint64_t ebits = ((bits >> 52) + big) | 0x4330000000000000ull;
+    double m, e;
+    memcpy(&m, &mbits, 8);
+    memcpy(&e, &ebits, 8);
+    e -= 4503599627370496.0 + 1023.0;                       /* 2^52 + bias */
+    double s = (m - 1.0) / (m + 1.0), z = s * s;
+    double p = 2.0 / 19;
+    p = p * z + 2.0 / 17;
+    p = p * z + 2.0 / 15;
+    p = p * z + 2.0 / 13;
+    p = p * z + 2.0 / 11;
+    p = p * z + 2.0 / 9;
+    p = p * z + 2.0 / 7;
+    p = p * z + 2.0 / 5;
+    p = p * z + 2.0 / 3;
+    p = p * z + 2.0;
+    return e * 0.6931471805599453 + s * p;
+}
+
+/* Payloads are non-negative, so their bit patterns order like the values */
+SK_INLINE void sk_capability_body(const double* payload, size_t n, const SkRocket* r, double* out) {
+    const double wet = r->wet, dry = r->dry, coef = r->coef;
+    int64_t leo;
+    memcpy(&leo, &r->leo, 8);
+    for(size_t i = 0; i < n; i++) {
+        double p = payload[i];
+        double dv = coef * sk_log((wet + p) / (dry + p));
+        int64_t pb;
+        uint64_t db;
+        memcpy(&pb, &p, 8);
+        memcpy(&db, &dv, 8);
+        db &= 0 - (uint64_t)(pb <= leo);                    /* 0.0 above the LEO payload */
+        memcpy(&out[i], &db, 8);
+    }
+}
+
+SK_INLINE void sk_temp_stats_body(const double* v, size_t n, SkTempStats* out) {
+    double mn[SK_LANES], mx[SK_LANES], sm[SK_LANES];
+    for(int l = 0; l < SK_LANES; l++) {
+        mn[l] = 1.0 / 0.0;
+        mx[l] = -1.0 / 0.0;
+        sm[l] = 0.0;
+    }
+    size_t i = 0;
+    for(; i + SK_LANES <= n; i += SK_LANES) {
+        for(int l = 0; l < SK_LANES; l++) {
+            double x = v[i + (size_t)l];
+            mn[l] = x < mn[l] ? x : mn[l];
+            mx[l] = x > mx[l] ? x : mx[l];
+            sm[l] += x;
+        }
+    }
+    for(int l = 0; i < n; i++, l++) {
+        mn[l] = v[i] < mn[l] ? v[i] : mn[l];
+        mx[l] = v[i] > mx[l] ? v[i] : mx[l];
+        sm[l] += v[i];
+    }
+    out->min = mn[0];
+    out->max = mx[0];
+    out->sum = sm[0];
+    for(int l = 1; l < SK_LANES; l++) {
+        out->min = mn[l] < out->min ? mn[l] : out->min;
+        out->max = mx[l] > out->max ? mx[l] : out->max;
+        out->sum += sm[l];
+    }
+}
+
+/* Same lanes and combine order as sk_temp_stats_body, written with GCC
+   vector types of the target's native width (SK_LANES / width registers
+   per accumulator). Selects go through integer masks: the vectorizer will
+   not if-convert FP min/max without -ffinite-math-only. */
+#define SK_TEMP_STATS_VEC(VD, VI)                                              \
+    enum { W = sizeof(VD) / 8, K = SK_LANES / W };                             \
+    VD mn[K], mx[K], sm[K];                                                    \
+    for(int k = 0; k < K; k++)                                                 \
+        for(int j = 0; j < W; j++) {                                           \
+            mn[k][j] = 1.0 / 0.0;                                              \
+            mx[k][j] = -1.0 / 0.0;                                             \
+            sm[k][j] = 0.0;                                                    \
+        }                                                                      \
+    size_t i = 0;                                                              \
+    for(; i + SK_LANES <= n; i += SK_LANES) {                                  \
+        for(int k = 0; k < K; k++) {                                           \
+            VD x;                                                              \
+            VI xi, ai, lt, gt;                                                 \
+            memcpy(&x, v + i + (size_t)(k * W), sizeof(x));                    \
+            memcpy(&xi, &x, sizeof(xi));                                       \
+            lt = (VI)(x < mn[k]);                                              \
+            gt = (VI)(x > mx[k]);                                              \
+            memcpy(&ai, &mn[k], sizeof(ai));                                   \
+            ai = (xi & lt) | (ai & ~lt);                                       \
+            memcpy(&mn[k], &ai, sizeof(ai));                                   \
+            memcpy(&ai, &mx[k], sizeof(ai));                                   \
+            ai = (xi & gt) | (ai & ~gt);                                       \
+            memcpy(&mx[k], &ai, sizeof(ai));                                   \
+            sm[k] += x;                                                        \
+        }                                                                      \
+    }                                                                          \
+    double lmn[SK_LANES], lmx[SK_LANES], lsm[SK_LANES];                        \
+    memcpy(lmn, mn, sizeof(lmn));                                              \
+    memcpy(lmx, mx, sizeof(lmx));                                              \
+    memcpy(lsm, sm, sizeof(lsm));                                              \
+    for(int l = 0; i < n; i++, l++) {                                          \
+        lmn[l] = v[i] < lmn[l] ? v[i] : lmn[l];                                \
+        lmx[l] = v[i] > lmx[l] ? v[i] : lmx[l];                                \
+        lsm[l] += v[i];                                                        \
+    }                                                                          \
+    out->min = lmn[0];                                                         \
+    out->max = lmx[0];                                                         \
+    out->sum = lsm[0];                                                         \
+    for(int l = 1; l < SK_LANES; l++) {                                        \
+        out->min = lmn[l] < out->min ? lmn[l] : out->min;                      \
+        out->max = lmx[l] > out->max ? lmx[l] : out->max;                      \
+        out->sum += lsm[l];                                                    \
+    }
+
+/* Bit i = XOR of bits 0..i: set for bytes after an odd number of quotes */
+SK_INLINE uint64_t sk_prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/* Scan loop shared by the csv variants; classify(p, &sep, &quote) fills the
+   comma|newline and quote masks of the 64 bytes at p */
+#define SK_CSV_SCAN(classify)                                                       \
+    size_t count = 0;                                                               \
+    for(size_t off = begin; off < end; off += 64) {                                 \
+        uint64_t sep, quote;                                                        \
+        if(end - off >= 64) {                                                       \
+            classify(data + off, &sep, &quote);                                     \
+        } else {                                                                    \
+            uint8_t tail[64];                                                       \
+            memset(tail, 0, sizeof(tail));                                          \
+            memcpy(tail, data + off, end - off);                                    \
+            classify(tail, &sep, &quote);                                           \
+        }                                                                           \
+        uint64_t inside = sk_prefix_xor(quote) ^ *in_quote;                         \
+        *in_quote = (uint64_t)((int64_t)inside >> 63);                              \
+        sep &= ~inside;                                                             \
+        while(sep) {                                                                \
+            out[count++] = off + (size_t)__builtin_ctzll(sep);                      \
+            sep &= sep - 1;                                                         \
+        }                                                                           \
+    }                                                                               \
+    return count;
+
+SK_INLINE void sk_classify_scalar(const uint8_t* p, uint64_t* sep, uint64_t* quote) {
+    uint64_t s = 0, q = 0;
+    for(int i = 0; i < 64; i++) {
+        s |= (uint64_t)(p[i] == ',' || p[i] == '\n') << i;
+        q |= (uint64_t)(p[i] == '"') << i;
+    }
+    *sep = s;
+    *quote = q;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Variants                                                                */
+/* ---------------------------------------------------------------------- */
+
+SK_NOVEC static void sk_capability_scalar(const double* payload, size_t n, const SkRocket* r, double* out) {
+    sk_capability_body(payload, n, r, out);
+}
+
+SK_NOVEC static void sk_temp_stats_scalar(const double* v, size_t n, SkTempStats* out) {
+    sk_temp_stats_body(v, n, out);
+}
+
+SK_NOVEC static size_t sk_csv_separators_scalar(const uint8_t* data, size_t begin, size_t end, uint64_t* in_quote,
+                                                size_t* out) {
+    SK_CSV_SCAN(sk_classify_scalar)
+}
+
+#if CD_X86
+CD_TARGET_SSE2 static void sk_capability_sse2(const double* payload, size_t n, const SkRocket* r, double* out) {
+    sk_capability_body(payload, n, r, out);
+}
+
+typedef double SkVd16 __attribute__((vector_size(16)));
+typedef int64_t SkVi16 __attribute__((vector_size(16)));
+
+CD_TARGET_SSE2 static void sk_temp_stats_sse2(const double* v, size_t n, SkTempStats* out) {
+    SK_TEMP_STATS_VEC(SkVd16, SkVi16)
+}
+
+CD_TARGET_SSE2 SK_INLINE void sk_classify_sse2(const uint8_t* p, uint64_t* sep, uint64_t* quote) {
+    const __m128i c = _mm_set1_epi8(','), nl = _mm_set1_epi8('\n'), q = _mm_set1_epi8('"');
+    uint64_t s = 0, qm = 0;
+    for(int k = 0; k < 4; k++) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * k));
+        __m128i sv = _mm_or_si128(_mm_cmpeq_epi8(v, c), _mm_cmpeq_epi8(v, nl));
+        s |= (uint64_t)(uint16_t)_mm_movemask_epi8(sv) << (16 * k);
+        qm |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)) << (16 * k);
+    }
+    *sep = s;
+    *quote = qm;
+}
+
+CD_TARGET_SSE2 static size_t sk_csv_separators_sse2(const uint8_t* data, size_t begin, size_t end,
+                                                    uint64_t* in_quote, size_t* out) {
+    SK_CSV_SCAN(sk_classify_sse2)
+}
+
+CD_TARGET_AVX2 static void sk_capability_avx2(const double* payload, size_t n, const SkRocket* r, double* out) {
+    sk_capability_body(payload, n, r, out);
+}
+
+typedef double SkVd32 __attribute__((vector_size(32)));
+typedef int64_t SkVi32 __attribute__((vector_size(32)));
+
+CD_TARGET_AVX2 static void sk_temp_stats_avx2(const double* v, size_t n, SkTempStats* out) {
+    SK_TEMP_STATS_VEC(SkVd32, SkVi32)
+}
+
+CD_TARGET_AVX2 SK_INLINE void sk_classify_avx2(const uint8_t* p, uint64_t* sep, uint64_t* quote) {
+    const __m256i c = _mm256_set1_epi8(','), nl = _mm256_set1_epi8('\n'), q = _mm256_set1_epi8('"');
+    __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+    __m256i slo = _mm256_or_si256(_mm256_cmpeq_epi8(lo, c), _mm256_cmpeq_epi8(lo, nl));
+    __m256i shi = _mm256_or_si256(_mm256_cmpeq_epi8(hi, c), _mm256_cmpeq_epi8(hi, nl));
+    *sep = (uint32_t)_mm256_movemask_epi8(slo) | (uint64_t)(uint32_t)_mm256_movemask_epi8(shi) << 32;
+    *quote = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, q)) |
+             (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, q)) << 32;
+}
+
+CD_TARGET_AVX2 static size_t sk_csv_separators_avx2(const uint8_t* data, size_t begin, size_t end,
+                                                    uint64_t* in_quote, size_t* out) {
+    SK_CSV_SCAN(sk_classify_avx2)
+}
+
+CD_TARGET_AVX512 static void sk_capability_avx512(const double* payload, size_t n, const SkRocket* r, double* out) {
+    sk_capability_body(payload, n, r, out);
+}
+
+typedef double SkVd64 __attribute__((vector_size(64)));
+typedef int64_t SkVi64 __attribute__((vector_size(64)));
+
+CD_TARGET_AVX512 static void sk_temp_stats_avx512(const double* v, size_t n, SkTempStats* out) {
+    SK_TEMP_STATS_VEC(SkVd64, SkVi64)
+}
+
+CD_TARGET_AVX512 SK_INLINE void sk_classify_avx512(const uint8_t* p, uint64_t* sep, uint64_t* quote) {
+    __m512i v = _mm512_loadu_si512((const void*)p);
+    *sep = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(',')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n'));
+    *quote = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"'));
+}
+
+CD_TARGET_AVX512 static size_t sk_csv_separators_avx512(const uint8_t* data, size_t begin, size_t end,
+                                                        uint64_t* in_quote, size_t* out) {
+    SK_CSV_SCAN(sk_classify_avx512)
+}
+#endif
+
+/* ---------------------------------------------------------------------- */
+/* Binding                                                                 */
+/* ---------------------------------------------------------------------- */
+
+/* Fill k with the variants for isa (unsupported levels fall back to scalar
+   on non-x86 builds; callers check cd_isa_supported() first) */
+static inline void sk_bind(SimdKernels* k, CdIsa isa) {
+    k->isa = CD_SCALAR;
+    k->capability = sk_capability_scalar;
+    k->temp_stats = sk_temp_stats_scalar;
+    k->csv_separators = sk_csv_separators_scalar;
+#if CD_X86
+    switch(isa) {
+    case CD_SSE2:
+        k->capability = sk_capability_sse2;
+        k->temp_stats = sk_temp_stats_sse2;
+        k->csv_separators = sk_csv_separators_sse2;
+        break;
+    case CD_AVX2:
+        k->capability = sk_capability_avx2;
+        k->temp_stats = sk_temp_stats_avx2;
+        k->csv_separators = sk_csv_separators_avx2;
+        break;
+    case CD_AVX512:
+        k->capability = sk_capability_avx512;
+        k->temp_stats = sk_temp_stats_avx512;
+        k->csv_separators = sk_csv_separators_avx512;
+        break;
+    default:
+        return;
+    }
+    k->isa = isa;
+#else
+    (void)isa;
+#endif
+}
+
+/* Kernels for the selected ISA, bound on first use */
+static inline const SimdKernels* sk_kernels() {
+    static SimdKernels k;
+    static int bound = 0;
+    if(!__atomic_load_n(&bound, __ATOMIC_ACQUIRE)) {
+        SimdKernels t;
+        sk_bind(&t, cd_select_isa());
+        k = t;
+        __atomic_store_n(&bound, 1, __ATOMIC_RELEASE);
+    }
+    return &k;
+}
+
+#endif /* SIMD_KERNELS_H */
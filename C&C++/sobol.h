@@ -0,0 +1,148 @@
+/*
+ sobol.h
+ Scrambled Sobol low-discrepancy sequences for quasi-Monte Carlo sampling
+
+ Overview:
+  - Up to SB_MAX_DIM dimensions using the Joe-Kuo direction numbers.
+  - Matousek linear matrix scrambling plus a random digital shift. The
+    scrambling is applied to the direction numbers once, so generating
+    points is still the plain Gray-code recurrence
+        x(n+1) = x(n) XOR V[ctz(n+1)]
+    and each step is one XOR across all dimensions. Direction numbers are
+    stored bit-major (V[bit][dim], padded to SB_MAX_DIM lanes) so that
+    update is a single contiguous vector XOR the compiler can emit as SIMD.
+  - Independent scrambles (different seeds) give unbiased replicates, so
+    the spread between replicates is an honest error estimate (RQMC).
+*/
+
+#ifndef SOBOL_H
+#define SOBOL_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define SB_BITS 32
+#define SB_MAX_DIM 8
+
+typedef struct {
+    int dim;
+    uint32_t index;                         /* index of the next point */
+    uint32_t x[SB_MAX_DIM];                 /* current point (scrambled) */
+    uint32_t v[SB_BITS][SB_MAX_DIM];        /* scrambled direction numbers */
+} Sobol;
+
+/* Joe-Kuo (new-joe-kuo-6.21201): degree s, polynomial a, initial m_1..m_s
+   for dimensions 2..SB_MAX_DIM. Dimension 1 is the van der Corput sequence. */
+static const struct { int s, a; uint32_t m[5]; } sb_dirs[SB_MAX_DIM - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}}
+};
+
+static inline uint64_t sb_splitmix(uint64_t* s) {
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* Unscrambled direction numbers of one dimension, bit b scaled to 2^(31-b) */
+static inline void sb_directions(int d, uint32_t* out) {
+    if(d == 0) {
+        for(int b = 0; b < SB_BITS; b++) out[b] = 1u << (31 - b);
+        return;
+    }
+    int s = sb_dirs[d - 1].s;
+    uint32_t a = (uint32_t)sb_dirs[d - 1].a;
+    for(int b = 0; b < s && b < SB_BITS; b++) out[b] = sb_dirs[d - 1].m[b] << (31 - b);
+    for(int b = s; b < SB_BITS; b++) {
+        uint32_t v = out[b - s] ^ (out[b - s] >> s);
+        for(int k = 1; k < s; k++) {
+            if((a >> (s - 1 - k)) & 1u) v ^= out[b - k];
+        }
+        out[b] = v;
+    }
+}
+
+/* Apply a random lower-triangular (unit diagonal) binary matrix to x,
+   acting on digits from the most significant bit down. rows[i] holds
+   output digit i's row: its own bit plus random more-significant bits. */
+static inline uint32_t sb_lms(const uint32_t* rows, uint32_t x) {
+    uint32_t y = 0;
+    for(int i = 0; i < SB_BITS; i++) {
+        y |= (uint32_t)(__builtin_parity(rows[i] & x)) << (31 - i);
+    }
+    return y;
+}
+
+/* Initialise a dim-dimensional generator. seed == 0 gives the plain
+   (unscrambled) sequence; any other seed gives an independent scramble. */
+static inline int sobol_init(Sobol* sb, int dim, uint64_t seed) {
+    if(dim < 1 || dim > SB_MAX_DIM) return -1;
+    memset(sb, 0, sizeof(*sb));
+    sb->dim = dim;
+    uint64_t rng = seed;
+    for(int d = 0; d < dim; d++) {
+        uint32_t dirs[SB_BITS];
+        sb_directions(d, dirs);
+        if(seed != 0) {
+            uint32_t rows[SB_BITS];
+            for(int i = 0; i < SB_BITS; i++) {
+                uint32_t above = i == 0 ? 0u : ~0u << (32 - i);
+                rows[i] = ((uint32_t)sb_splitmix(&rng) & above) | (1u << (31 - i));
+            }
+            for(int b = 0; b < SB_BITS; b++) dirs[b] = sb_lms(rows, dirs[b]);
+            sb->x[d] = (uint32_t)sb_splitmix(&rng);     /* digital shift */
+        }
+        for(int b = 0; b < SB_BITS; b++) sb->v[b][d] = dirs[b];
+    }
+    return 0;
+}
+
+/* Generate n points into out[n * dim] as doubles in (0, 1). Point i of the
+   call is sequence point (sb->index + i); the generator advances by n. */
+static inline void sobol_fill(Sobol* sb, double* out, uint32_t n) {
+    const double scale = 1.0 / 4294967296.0;
+    int dim = sb->dim;
+    uint32_t x[SB_MAX_DIM];
+    memcpy(x, sb->x, sizeof(x));
+    for(uint32_t i = 0; i < n; i++) {
+        for(int d = 0; d < dim; d++) out[(size_t)i * dim + d] = ((double)x[d] + 0.5) * scale;
+        uint32_t c = (uint32_t)__builtin_ctz(sb->index + i + 1);
+        const uint32_t* v = sb->v[c];
+        for(int d = 0; d < SB_MAX_DIM; d++) x[d] ^= v[d];
+    }
+    memcpy(sb->x, x, sizeof(x));
+    sb->index += n;
+}
+
+/* Inverse standard normal CDF (Acklam, relative error < 1.2e-9) */
+static inline double sb_norm_inv(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+        -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+        -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+        -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+        2.445134137142996e+00, 3.754408661907416e+00};
+    if(p < 0.02425) {
+        double q = sqrt(-2.0 * log(p));
+        return (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+               ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    }
+    if(p > 1.0 - 0.02425) {
+        double q = sqrt(-2.0 * log(1.0 - p));
+        return -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+                ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    }
+    double q = p - 0.5, r = q * q;
+    return (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q /
+           (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+}
+
+#endif /* SOBOL_H */
@@ -0,0 +1,274 @@
+/*
+ surrogate.h
+ Adaptive Chebyshev surrogates for expensive 2-D cost functions
+
+ Overview:
+  - Approximates f(x, y) on a rectangle (e.g. departure date x time of
+    flight) with a quadtree of tensor-product Chebyshev patches of degree
+    SG_N - 1. Each patch is fitted from f at the Chebyshev nodes.
+  - Error estimate per patch: twice the larger of the coefficient tail
+    (terms of the two highest degrees) and the error observed on an
+    SG_CHECK x SG_CHECK grid of check points (edges included). The grid is
+    only evaluated once the tail passes, so patches that will be split
+    anyway cost just their SG_N^2 node evaluations. Patches whose estimate
+    exceeds the tolerance are split into four, down to max_depth.
+  - Patches that still miss the tolerance at max_depth, or where f is
+    undefined (returns NaN) anywhere at that depth, are marked exact-only
+    (error INFINITY) and always fall back to the real function; an
+    estimate above the tolerance is never handed to sg_decide().
+  - sg_eval() is a cell lookup plus a 2-D Clenshaw sum. sg_decide() only
+    calls the exact function when the threshold lies inside the error band,
+    so feasibility sweeps stay exact at the boundary and cheap elsewhere.
+*/
+
+#ifndef SURROGATE_H
+#define SURROGATE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define SG_N 10             /* Chebyshev nodes per axis (degree 9) */
+#define SG_PI 3.14159265358979323846
+#define SG_ROOT 8           /* root cells per axis */
+#define SG_CHECK 7          /* validation points per axis, edges included */
+
+typedef double (*sg_fn)(double x, double y, void* ctx);
+
+typedef struct {
+    double x0, x1, y0, y1;
+    int child;              /* index of first of 4 children, -1 for a leaf */
+    int coef;               /* offset into coefs, -1 for exact-only leaves */
+    double err;             /* estimated max abs error of the leaf */
+} SgCell;
+
+typedef struct {
+    sg_fn f;
+    void* ctx;
+    double x0, x1, y0, y1;
+    double tol;
+    int max_depth;
+    SgCell* cells;
+    int num_cells, cap_cells;
+    double* coefs;
+    int num_coefs, cap_coefs;   /* in units of SG_N * SG_N blocks */
+    long fit_evals;             /* calls to f while building */
+    int exact_only;             /* leaves that always use f */
+} Surrogate;
+
+static inline int sg_new_cell(Surrogate* sg, double x0, double x1, double y0, double y1) {
+    if(sg->num_cells == sg->cap_cells) {
+        int nc = sg->cap_cells ? sg->cap_cells * 2 : 256;
+        SgCell* p = (SgCell*)realloc(sg->cells, sizeof(SgCell) * (size_t)nc);
+        if(!p) return -1;
+        sg->cells = p;
+        sg->cap_cells = nc;
+    }
+    SgCell* c = &sg->cells[sg->num_cells];
+    c->x0 = x0; c->x1 = x1; c->y0 = y0; c->y1 = y1;
+    c->child = -1;
+    c->coef = -1;
+    c->err = INFINITY;
+    return sg->num_cells++;
+}
+
+static inline int sg_new_coefs(Surrogate* sg) {
+    if(sg->num_coefs == sg->cap_coefs) {
+        int nc = sg->cap_coefs ? sg->cap_coefs * 2 : 256;
+        double* p = (double*)realloc(sg->coefs, sizeof(double) * SG_N * SG_N * (size_t)nc);
+        if(!p) return -1;
+        sg->coefs = p;
+        sg->cap_coefs = nc;
+    }
+    return sg->num_coefs++;
+}
+
+/* Clenshaw sum of a 2-D Chebyshev series at local coordinates (u, v) in [-1, 1] */
+static inline double sg_clenshaw(const double* c, double u, double v) {
+    double row[SG_N];
+    for(int i = 0; i < SG_N; i++) {
+        const double* ci = c + i * SG_N;
+        double b1 = 0.0, b2 = 0.0;
+        for(int j = SG_N - 1; j >= 1; j--) {
+            double b = 2.0 * v * b1 - b2 + ci[j];
+            b2 = b1;
+            b1 = b;
+        }
+        row[i] = v * b1 - b2 + ci[0];
+    }
+    double b1 = 0.0, b2 = 0.0;
+    for(int i = SG_N - 1; i >= 1; i--) {
+        double b = 2.0 * u * b1 - b2 + row[i];
+        b2 = b1;
+        b1 = b;
+    }
+    return u * b1 - b2 + row[0];
+}
+
+/* Fit one cell. Returns 0 if the fit meets the tolerance, 1 if it should be
+   split, -1 if f is undefined somewhere in the cell, -2 if everywhere. */
+static inline int sg_fit(Surrogate* sg, int ci, double* c) {
+    double x0 = sg->cells[ci].x0, x1 = sg->cells[ci].x1;
+    double y0 = sg->cells[ci].y0, y1 = sg->cells[ci].y1;
+    double t[SG_N], f[SG_N][SG_N];
+    for(int k = 0; k < SG_N; k++) t[k] = cos(SG_PI * (k + 0.5) / SG_N);
+    int undefined = 0;
+    for(int k = 0; k < SG_N; k++) {
+        double x = 0.5 * (x0 + x1) + 0.5 * (x1 - x0) * t[k];
+        for(int l = 0; l < SG_N; l++) {
+            double y = 0.5 * (y0 + y1) + 0.5 * (y1 - y0) * t[l];
+            f[k][l] = sg->f(x, y, sg->ctx);
+            undefined += !isfinite(f[k][l]);
+        }
+    }
+    sg->fit_evals += SG_N * SG_N;
+    if(undefined == SG_N * SG_N) return -2;
+    if(undefined) return -1;
+
+    /* c_ij = (2/N)^2 sum_k sum_l f_kl T_i(t_k) T_j(t_l), halved for i or j = 0 */
+    double T[SG_N][SG_N];
+    for(int i = 0; i < SG_N; i++)
+        for(int k = 0; k < SG_N; k++) T[i][k] = cos(SG_PI * i * (k + 0.5) / SG_N);
+    double tmp[SG_N][SG_N];
+    for(int i = 0; i < SG_N; i++)
+        for(int l = 0; l < SG_N; l++) {
+            double s = 0.0;
+            for(int k = 0; k < SG_N; k++) s += T[i][k] * f[k][l];
+            tmp[i][l] = s * (2.0 / SG_N) * (i == 0 ? 0.5 : 1.0);
+        }
+    double tail = 0.0;
+    for(int i = 0; i < SG_N; i++)
+        for(int j = 0; j < SG_N; j++) {
+            double s = 0.0;
+            for(int l = 0; l < SG_N; l++) s += T[j][l] * tmp[i][l];
+            c[i * SG_N + j] = s * (2.0 / SG_N) * (j == 0 ? 0.5 : 1.0);
+            if(i >= SG_N - 2 || j >= SG_N - 2) tail += fabs(c[i * SG_N + j]);
+        }
+
+    sg->cells[ci].err = 2.0 * tail;
+    if(sg->cells[ci].err > sg->tol) return 1;
+
+    /* Validation grid: uniform points, so it samples between the nodes and
+       out to the edges where the interpolant is least constrained */
+    double seen = 0.0;
+    for(int p = 0; p < SG_CHECK; p++) {
+        double u = -1.0 + 2.0 * p / (SG_CHECK - 1);
+        double x = 0.5 * (x0 + x1) + 0.5 * (x1 - x0) * u;
+        for(int q = 0; q < SG_CHECK; q++) {
+            double v = -1.0 + 2.0 * q / (SG_CHECK - 1);
+            double y = 0.5 * (y0 + y1) + 0.5 * (y1 - y0) * v;
+            double fe = sg->f(x, y, sg->ctx);
+            sg->fit_evals++;
+            if(!isfinite(fe)) return -1;
+            double d = fabs(fe - sg_clenshaw(c, u, v));
+            if(d > seen) seen = d;
+        }
+    }
+    sg->cells[ci].err = 2.0 * fmax(tail, seen);
+    return sg->cells[ci].err <= sg->tol ? 0 : 1;
+}
+
+static inline int sg_refine(Surrogate* sg, int ci, int depth) {
+    double c[SG_N * SG_N];
+    int r = sg_fit(sg, ci, c);
+    if(r == 0) {
+        int off = sg_new_coefs(sg);
+        if(off < 0) return -1;
+        for(int k = 0; k < SG_N * SG_N; k++) sg->coefs[(size_t)off * SG_N * SG_N + k] = c[k];
+        sg->cells[ci].coef = off;
+        return 0;
+    }
+    if(r == -2 || depth >= sg->max_depth) {
+        sg->cells[ci].err = INFINITY;
+        sg->exact_only++;
+        return 0;
+    }
+    double x0 = sg->cells[ci].x0, x1 = sg->cells[ci].x1;
+    double y0 = sg->cells[ci].y0, y1 = sg->cells[ci].y1;
+    double xm = 0.5 * (x0 + x1), ym = 0.5 * (y0 + y1);
+    /* Children in order (x low/high) + 2 * (y low/high) */
+    int first = sg_new_cell(sg, x0, xm, y0, ym);
+    if(first < 0 || sg_new_cell(sg, xm, x1, y0, ym) < 0 ||
+       sg_new_cell(sg, x0, xm, ym, y1) < 0 || sg_new_cell(sg, xm, x1, ym, y1) < 0) return -1;
+    sg->cells[ci].child = first;
+    for(int k = 0; k < 4; k++) {
+        if(sg_refine(sg, first + k, depth + 1) != 0) return -1;
+    }
+    return 0;
+}
+
+/* Build a surrogate of f over [x0,x1] x [y0,y1]. Returns 0 or -1 on allocation failure. */
+static inline int sg_build(Surrogate* sg, sg_fn f, void* ctx, double x0, double x1,
+                           double y0, double y1, double tol, int max_depth) {
+    memset(sg, 0, sizeof(*sg));
+    sg->f = f;
+    sg->ctx = ctx;
+    sg->x0 = x0; sg->x1 = x1; sg->y0 = y0; sg->y1 = y1;
+    sg->tol = tol;
+    sg->max_depth = max_depth;
+    double dx = (x1 - x0) / SG_ROOT, dy = (y1 - y0) / SG_ROOT;
+    for(int j = 0; j < SG_ROOT; j++)
+        for(int i = 0; i < SG_ROOT; i++)
+            if(sg_new_cell(sg, x0 + i * dx, x0 + (i + 1) * dx, y0 + j * dy, y0 + (j + 1) * dy) < 0) return -1;
+    for(int k = 0; k < SG_ROOT * SG_ROOT; k++) {
+        if(sg_refine(sg, k, 0) != 0) return -1;
+    }
+    return 0;
+}
+
+static inline const SgCell* sg_find(const Surrogate* sg, double x, double y) {
+    int i = (int)((x - sg->x0) / (sg->x1 - sg->x0) * SG_ROOT);
+    int j = (int)((y - sg->y0) / (sg->y1 - sg->y0) * SG_ROOT);
+    if(i < 0 || i >= SG_ROOT || j < 0 || j >= SG_ROOT) {
+        if(x < sg->x0 || x > sg->x1 || y < sg->y0 || y > sg->y1) return NULL;
+        i = i < 0 ? 0 : (i >= SG_ROOT ? SG_ROOT - 1 : i);
+        j = j < 0 ? 0 : (j >= SG_ROOT ? SG_ROOT - 1 : j);
+    }
+    const SgCell* c = &sg->cells[j * SG_ROOT + i];
+    while(c->child >= 0) {
+        double xm = 0.5 * (c->x0 + c->x1), ym = 0.5 * (c->y0 + c->y1);
+        c = &sg->cells[c->child + (x >= xm) + 2 * (y >= ym)];
+    }
+    return c;
+}
+
+/* Approximate f(x, y); *err receives the error estimate (INFINITY when the
+   point is outside the domain or in an exact-only cell, value is then NaN) */
+static inline double sg_eval(const Surrogate* sg, double x, double y, double* err) {
+    const SgCell* c = sg_find(sg, x, y);
+    if(!c || c->coef < 0) {
+        if(err) *err = INFINITY;
+        return NAN;
+    }
+    if(err) *err = c->err;
+    double u = (2.0 * x - c->x0 - c->x1) / (c->x1 - c->x0);
+    double v = (2.0 * y - c->y0 - c->y1) / (c->y1 - c->y0);
+    return sg_clenshaw(sg->coefs + (size_t)c->coef * SG_N * SG_N, u, v);
+}
+
+/* Is f(x, y) <= threshold? Uses the surrogate when the answer is certain
+   given its error band, otherwise evaluates f. The band is never narrower
+   than the tolerance every accepted leaf was validated to, since a cell's
+   own estimate can undershoot between check points. *value receives the
+   value used and *exact is set when f had to be called. */
+static inline int sg_decide(const Surrogate* sg, double x, double y, double threshold,
+                            double* value, int* exact) {
+    double err;
+    double v = sg_eval(sg, x, y, &err);
+    *exact = 0;
+    if(!(fabs(v - threshold) > fmax(err, sg->tol))) {
+        v = sg->f(x, y, sg->ctx);
+        *exact = 1;
+    }
+    *value = v;
+    return v <= threshold;
+}
+
+static inline void sg_free(Surrogate* sg) {
+    free(sg->cells);
+    free(sg->coefs);
+    sg->cells = NULL;
+    sg->coefs = NULL;
+}
+
+#endif /* SURROGATE_H */
@@ -0,0 +1,151 @@
+/*
+ temp_pyramid.h
+ Multi-resolution downsampling pyramid for station temperature series
+
+ Overview:
+  - Level 0 summarises blocks of PY_LEAF raw readings; every level above
+    summarises PY_FANOUT nodes of the level below. Each node holds
+    min/max/sum/count, so day/week/month/year dashboards and arbitrary
+    range aggregates combine O(PY_FANOUT * levels) nodes plus at most two
+    partial leaf blocks of raw readings instead of scanning everything.
+  - Maintained on append: each new reading is folded into one node per
+    level.
+  - Partial leaf blocks at the ends of a range are scanned with the
+    temp_stats kernel from simd_kernels.h (ISA picked at runtime).
+  - Overhead: a 32-byte node per 64 readings (8 bytes each) is 6.25%, and
+    the upper levels add 1/7 of that, about 7% in total.
+*/
+
+#ifndef TEMP_PYRAMID_H
+#define TEMP_PYRAMID_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include "simd_kernels.h"
+
+#define PY_LEAF 64
+#define PY_FANOUT 8
+#define PY_MAX_LEVELS 10    /* 64 * 8^9 readings is far beyond any archive */
+
+typedef struct {
+    double min;
+    double max;
+    double sum;
+    long count;
+} PyNode;
+
+typedef struct {
+    double* raw;
+    long n;
+    long raw_cap;
+    PyNode* level[PY_MAX_LEVELS];
+    long level_len[PY_MAX_LEVELS];
+    long level_cap[PY_MAX_LEVELS];
+    long block[PY_MAX_LEVELS];  /* readings covered by one node per level */
+} TempPyramid;
+
+static inline void py_node_empty(PyNode* a) {
+    a->min = DBL_MAX;
+    a->max = -DBL_MAX;
+    a->sum = 0.0;
+    a->count = 0;
+}
+
+static inline void py_node_add(PyNode* a, double x) {
+    if(x < a->min) a->min = x;
+    if(x > a->max) a->max = x;
+    a->sum += x;
+    a->count++;
+}
+
+static inline void py_node_merge(PyNode* a, const PyNode* b) {
+    if(b->min < a->min) a->min = b->min;
+    if(b->max > a->max) a->max = b->max;
+    a->sum += b->sum;
+    a->count += b->count;
+}
+
+static inline void py_init(TempPyramid* py) {
+    memset(py, 0, sizeof(*py));
+    long b = PY_LEAF;
+    for(int l = 0; l < PY_MAX_LEVELS; l++) {
+        py->block[l] = b;
+        b *= PY_FANOUT;
+    }
+}
+
+static inline void py_free(TempPyramid* py) {
+    free(py->raw);
+    for(int l = 0; l < PY_MAX_LEVELS; l++) free(py->level[l]);
+    memset(py, 0, sizeof(*py));
+}
+
+/* Append one reading. Returns 0 on success, -1 if out of memory. */
+static inline int py_append(TempPyramid* py, double x) {
+    if(py->n == py->raw_cap) {
+        long ncap = py->raw_cap ? py->raw_cap * 2 : 1024;
+        double* nr = (double*)realloc(py->raw, sizeof(double) * ncap);
+        if(!nr) return -1;
+        py->raw = nr;
+        py->raw_cap = ncap;
+    }
+    long idx = py->n;
+    for(int l = 0; l < PY_MAX_LEVELS; l++) {
+        long node = idx / py->block[l];
+        if(node == py->level_len[l]) {
+            if(py->level_len[l] == py->level_cap[l]) {
+                long ncap = py->level_cap[l] ? py->level_cap[l] * 2 : 16;
+                PyNode* nl = (PyNode*)realloc(py->level[l], sizeof(PyNode) * ncap);
+                if(!nl) return -1;
+                py->level[l] = nl;
+                py->level_cap[l] = ncap;
+            }
+            py_node_empty(&py->level[l][node]);
+            py->level_len[l]++;
+        }
+        py_node_add(&py->level[l][node], x);
+    }
+    py->raw[py->n++] = x;
+    return 0;
+}
+
+/* Aggregate readings [first, last). Returns the node count (0 if empty). */
+static inline long py_range(const TempPyramid* py, long first, long last, PyNode* out) {
+    py_node_empty(out);
+    if(first < 0) first = 0;
+    if(last > py->n) last = py->n;
+
+    long a = first;
+    while(a < last) {
+        /* Take the coarsest complete, aligned node starting at a */
+        int best = -1;
+        for(int l = PY_MAX_LEVELS - 1; l >= 0; l--) {
+            long b = py->block[l];
+            if(a % b == 0 && a + b <= last && a / b < py->level_len[l]) { best = l; break; }
+        }
+        if(best >= 0) {
+            py_node_merge(out, &py->level[best][a / py->block[best]]);
+            a += py->block[best];
+        } else {
+            /* Partial leaf block: scan raw up to the next leaf boundary */
+            long stop = (a / PY_LEAF + 1) * PY_LEAF;
+            if(stop > last) stop = last;
+            SkTempStats st;
+            sk_kernels()->temp_stats(py->raw + a, (size_t)(stop - a), &st);
+            PyNode part = {st.min, st.max, st.sum, stop - a};
+            py_node_merge(out, &part);
+            a = stop;
+        }
+    }
+    return out->count;
+}
+
+/* Bytes used by summary nodes, for checking the overhead against raw data */
+static inline long py_summary_bytes(const TempPyramid* py) {
+    long bytes = 0;
+    for(int l = 0; l < PY_MAX_LEVELS; l++) bytes += py->level_len[l] * (long)sizeof(PyNode);
+    return bytes;
+}
+
+#endif /* TEMP_PYRAMID_H */
@@ -0,0 +1,270 @@
+/*
+ tempstore_ooc.c
+ Out-of-core temperature store for archives larger than RAM
+
+ Overview:
+  - Readings live in a flat file of int32 values (one per station-day) and
+    are accessed in fixed-size chunks mapped with mmap().
+  - A small buffer manager owns a fixed number of frames (the memory
+    budget). Chunks are pinned while in use and unpinned chunks are evicted
+    with a clock (second chance) policy.
+  - Scans hint the kernel about upcoming chunks (posix_fadvise WILLNEED /
+    madvise SEQUENTIAL) so the next chunks are being read while the current
+    one is aggregated. Evicted chunks stay in the page cache, so a repeated
+    scan of a range that fits in RAM is served from memory; --drop-cache
+    evicts them from the page cache as well (POSIX_FADV_DONTNEED), for
+    one-pass scans that should not push other data out.
+  - This is a standalone archive format (raw int32 readings, e.g. tenths
+    of a degree); tempstream.c keeps its per-station series in memory and
+    does not read or write these files.
+
+ Usage:
+   tempstore_ooc gen  <file> <count>                 write count random readings
+   tempstore_ooc scan <file> [mem_mb] [first] [last] [--drop-cache]
+                                                     min/max/mean over [first,last)
+
+ POSIX only (mmap/madvise); this tool is not built on Windows.
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define CHUNK_BYTES (64L << 20)     /* 64 MiB per chunk */
+#define CHUNK_VALUES (CHUNK_BYTES / (long)sizeof(int32_t))
+#define PREFETCH_CHUNKS 4           /* chunks hinted ahead of the scan */
+#define DEFAULT_MEM_MB 1024
+
+/* One frame of the buffer pool */
+typedef struct {
+    long chunk;         /* chunk index mapped here, -1 if empty */
+    int32_t* data;
+    size_t bytes;
+    int pins;
+    int referenced;     /* clock bit */
+} Frame;
+
+typedef struct {
+    int fd;
+    off_t file_bytes;
+    long num_chunks;
+    Frame* frames;
+    int num_frames;
+    int clock_hand;
+    long* chunk_frame;  /* chunk -> frame index or -1 */
+    int drop_cache;     /* also drop evicted chunks from the page cache */
+    long maps, evictions;
+} BufferPool;
+
+typedef struct {
+    long count;
+    int32_t min;
+    int32_t max;
+    double sum;
+} Aggregate;
+
+/* Open the store with a memory budget in bytes. Returns 0 on success. */
+int pool_open(BufferPool* bp, const char* path, size_t mem_bytes) {
+    memset(bp, 0, sizeof(*bp));
+    bp->fd = open(path, O_RDONLY);
+    if(bp->fd < 0) return -1;
+    struct stat st;
+    if(fstat(bp->fd, &st) != 0) { close(bp->fd); bp->fd = -1; return -1; }
+    bp->file_bytes = st.st_size;
+    bp->num_chunks = (long)((st.st_size + CHUNK_BYTES - 1) / CHUNK_BYTES);
+
+    bp->num_frames = (int)(mem_bytes / CHUNK_BYTES);
+    if(bp->num_frames < 2) bp->num_frames = 2;
+    bp->frames = calloc(bp->num_frames, sizeof(Frame));
+    bp->chunk_frame = malloc(sizeof(long) * (bp->num_chunks > 0 ? bp->num_chunks : 1));
+    if(!bp->frames || !bp->chunk_frame) {
+        free(bp->frames);
+        free(bp->chunk_frame);
+        close(bp->fd);
+        memset(bp, 0, sizeof(*bp));
+        return -1;
+    }
+    for(int i = 0; i < bp->num_frames; i++) bp->frames[i].chunk = -1;
+    for(long c = 0; c < bp->num_chunks; c++) bp->chunk_frame[c] = -1;
+    return 0;
+}
+
+static void frame_release(BufferPool* bp, Frame* f) {
+    if(f->chunk < 0) return;
+    munmap(f->data, f->bytes);
+    if(bp->drop_cache)
+        posix_fadvise(bp->fd, (off_t)f->chunk * CHUNK_BYTES, (off_t)f->bytes, POSIX_FADV_DONTNEED);
+    bp->chunk_frame[f->chunk] = -1;
+    f->chunk = -1;
+    f->data = NULL;
+    bp->evictions++;
+}
+
+/* Clock sweep for an unpinned frame. Returns -1 if every frame is pinned. */
+static int pool_victim(BufferPool* bp) {
+    for(int scanned = 0; scanned < bp->num_frames * 2; scanned++) {
+        Frame* f = &bp->frames[bp->clock_hand];
+        int idx = bp->clock_hand;
+        bp->clock_hand = (bp->clock_hand + 1) % bp->num_frames;
+        if(f->pins > 0) continue;
+        if(f->chunk >= 0 && f->referenced) { f->referenced = 0; continue; }
+        return idx;
+    }
+    return -1;
+}
+
+/* Pin a chunk in memory, mapping it if needed. Returns its values or NULL. */
+int32_t* pool_pin(BufferPool* bp, long chunk, long* nvalues) {
+    if(chunk < 0 || chunk >= bp->num_chunks) return NULL;
+    long fi = bp->chunk_frame[chunk];
+    if(fi < 0) {
+        fi = pool_victim(bp);
+        if(fi < 0) return NULL;
+        Frame* f = &bp->frames[fi];
+        frame_release(bp, f);
+
+        off_t off = (off_t)chunk * CHUNK_BYTES;
+        size_t bytes = (size_t)((bp->file_bytes - off) < CHUNK_BYTES ? (bp->file_bytes - off) : CHUNK_BYTES);
+        void* p = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, bp->fd, off);
+        if(p == MAP_FAILED) return NULL;
+        madvise(p, bytes, MADV_SEQUENTIAL);
+        f->chunk = chunk;
+        f->data = p;
+        f->bytes = bytes;
+        bp->chunk_frame[chunk] = fi;
+        bp->maps++;
+    }
+    Frame* f = &bp->frames[fi];
+    f->pins++;
+    f->referenced = 1;
+    *nvalues = (long)(f->bytes / sizeof(int32_t));
+    return f->data;
+}
+
+void pool_unpin(BufferPool* bp, long chunk) {
+    long fi = bp->chunk_frame[chunk];
+    if(fi >= 0 && bp->frames[fi].pins > 0) bp->frames[fi].pins--;
+}
+
+/* Ask the kernel to start reading a chunk that is not mapped yet */
+void pool_prefetch(BufferPool* bp, long chunk) {
+    if(chunk < 0 || chunk >= bp->num_chunks) return;
+    if(bp->chunk_frame[chunk] >= 0) return;
+    posix_fadvise(bp->fd, (off_t)chunk * CHUNK_BYTES, CHUNK_BYTES, POSIX_FADV_WILLNEED);
+}
+
+void pool_close(BufferPool* bp) {
+    for(int i = 0; i < bp->num_frames; i++) frame_release(bp, &bp->frames[i]);
+    free(bp->frames);
+    free(bp->chunk_frame);
+    close(bp->fd);
+}
+
+static void aggregate_values(Aggregate* a, const int32_t* v, long n) {
+    int32_t mn = a->min, mx = a->max;
+    int64_t sum = 0;
+    for(long i = 0; i < n; i++) {
+        mn = v[i] < mn ? v[i] : mn;
+        mx = v[i] > mx ? v[i] : mx;
+        sum += v[i];
+    }
+    a->min = mn;
+    a->max = mx;
+    a->sum += (double)sum;
+    a->count += n;
+}
+
+/* Stream an aggregate over readings [first, last) */
+int scan_range(BufferPool* bp, long first, long last, Aggregate* out) {
+    out->count = 0;
+    out->min = INT32_MAX;
+    out->max = INT32_MIN;
+    out->sum = 0.0;
+    if(first >= last) return 0;
+
+    long c0 = first / CHUNK_VALUES;
+    long c1 = (last - 1) / CHUNK_VALUES;
+    for(long c = c0; c <= c0 + PREFETCH_CHUNKS && c <= c1; c++) pool_prefetch(bp, c);
+
+    for(long c = c0; c <= c1; c++) {
+        /* Keep the readahead window PREFETCH_CHUNKS ahead of the scan */
+        if(c + PREFETCH_CHUNKS <= c1) pool_prefetch(bp, c + PREFETCH_CHUNKS);
+
+        long n;
+        int32_t* v = pool_pin(bp, c, &n);
+        if(!v) return -1;
+        long base = c * CHUNK_VALUES;
+        long lo = (first > base) ? first - base : 0;
+        long hi = (last < base + n) ? last - base : n;
+        aggregate_values(out, v + lo, hi - lo);
+        pool_unpin(bp, c);
+    }
+    return 0;
+}
+
+/* Write count pseudo-random readings (-40..49 degrees) to path */
+int generate(const char* path, long count) {
+    FILE* f = fopen(path, "wb");
+    if(!f) return -1;
+    int32_t buf[4096];
+    uint32_t state = 12345;
+    for(long done = 0; done < count; ) {
+        long n = count - done < 4096 ? count - done : 4096;
+        for(long i = 0; i < n; i++) {
+            state = state * 1664525u + 1013904223u;
+            buf[i] = (int32_t)((state >> 8) % 90) - 40;
+        }
+        if(fwrite(buf, sizeof(int32_t), n, f) != (size_t)n) { fclose(f); return -1; }
+        done += n;
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    if(argc >= 4 && strcmp(argv[1], "gen") == 0) {
+        if(generate(argv[2], atol(argv[3])) != 0) { perror("gen"); return 1; }
+        return 0;
+    }
+    if(argc >= 3 && strcmp(argv[1], "scan") == 0) {
+        int drop = argc >= 4 && strcmp(argv[argc - 1], "--drop-cache") == 0;
+        if(drop) argc--;
+        long mem_mb = argc >= 4 ? atol(argv[3]) : DEFAULT_MEM_MB;
+        BufferPool bp;
+        if(pool_open(&bp, argv[2], (size_t)mem_mb << 20) != 0) { perror("open"); return 1; }
+        bp.drop_cache = drop;
+        long total = (long)(bp.file_bytes / sizeof(int32_t));
+        long first = argc >= 5 ? atol(argv[4]) : 0;
+        long last = argc >= 6 ? atol(argv[5]) : total;
+        if(first < 0) first = 0;
+        if(last > total) last = total;
+
+        Aggregate a;
+        double t0 = now_sec();
+        int rc = scan_range(&bp, first, last, &a);
+        double dt = now_sec() - t0;
+        if(rc != 0) { fprintf(stderr, "scan failed\n"); pool_close(&bp); return 1; }
+
+        printf("Readings: %ld\n", a.count);
+        if(a.count > 0) printf("Min: %d | Max: %d | Mean: %.3f\n", a.min, a.max, a.sum / a.count);
+        printf("Scanned %.1f MiB in %.3f s (%.1f MiB/s), %ld maps, %ld evictions, %d frames\n",
+               a.count * 4.0 / (1 << 20), dt, dt > 0 ? a.count * 4.0 / (1 << 20) / dt : 0.0,
+               bp.maps, bp.evictions, bp.num_frames);
+        pool_close(&bp);
+        return 0;
+    }
+    printf("usage: %s gen <file> <count> | scan <file> [mem_mb] [first] [last] [--drop-cache]\n", argv[0]);
+    return 1;
+}
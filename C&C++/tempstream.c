@@ -0,0 +1,152 @@
+/*
+ tempstream.c
+ Streaming station temperatures with rolling 7/30/365-day statistics
+
+ Usage (one command per line on stdin):
+   add <station> <temperature>   append today's reading for a station
+   show <station>                print rolling mean/min/max for the station
+   range <station> <first> <last>  min/max/mean over readings [first, last)
+   summary <station> day|week|month|year   last 12 periods of that length
+   list                          show every station
+   quit
+
+ Rolling values are maintained on append (see rolling_window.h), so
+ "show" is a lookup and never rescans the readings. Range and summary
+ queries are answered from the downsampling pyramid (see temp_pyramid.h).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rolling_window.h"
+#include "temp_pyramid.h"
+
+#define MAX_LINE 256
+#define NAME_LEN 32
+
+typedef struct {
+    char name[NAME_LEN];
+    RollingStats stats;
+    TempPyramid pyramid;
+} Station;
+
+Station* stations = NULL;
+int num_stations = 0;
+int cap_stations = 0;
+
+/* Find a station by name, optionally creating it. Returns NULL if missing. */
+Station* find_station(const char* name, int create) {
+    for(int i = 0; i < num_stations; i++) {
+        if(strcmp(stations[i].name, name) == 0) return &stations[i];
+    }
+    if(!create) return NULL;
+    if(num_stations == cap_stations) {
+        int ncap = cap_stations ? cap_stations * 2 : 8;
+        Station* ns = realloc(stations, sizeof(Station) * ncap);
+        if(!ns) return NULL;
+        stations = ns;
+        cap_stations = ncap;
+    }
+    Station* s = &stations[num_stations++];
+    strncpy(s->name, name, NAME_LEN - 1);
+    s->name[NAME_LEN - 1] = 0;
+    rw_init(&s->stats);
+    py_init(&s->pyramid);
+    return s;
+}
+
+void print_station(const Station* s) {
+    printf("%s (%ld readings)\n", s->name, s->stats.count);
+    for(int w = 0; w < RW_NUM_WINDOWS; w++) {
+        WindowResult r;
+        if(rw_query(&s->stats, w, &r) != 0) continue;
+        printf("  %3d-day: mean %7.2f | min %7.2f | max %7.2f (%d samples)\n",
+               r.width, r.mean, r.min, r.max, r.samples);
+    }
+}
+
+/* Period length in days for a summary granularity, 0 if unknown */
+int period_days(const char* g) {
+    if(strcmp(g, "day") == 0) return 1;
+    if(strcmp(g, "week") == 0) return 7;
+    if(strcmp(g, "month") == 0) return 30;
+    if(strcmp(g, "year") == 0) return 365;
+    return 0;
+}
+
+void print_range(const Station* s, long first, long last) {
+    PyNode r;
+    if(py_range(&s->pyramid, first, last, &r) == 0) {
+        printf("  [%ld, %ld): no readings\n", first, last);
+        return;
+    }
+    printf("  [%ld, %ld): mean %7.2f | min %7.2f | max %7.2f (%ld samples)\n",
+           first, last, r.sum / r.count, r.min, r.max, r.count);
+}
+
+/* Last 12 periods of the given length, most recent last */
+void print_summary(const Station* s, int days) {
+    long n = s->pyramid.n;
+    long first = n - 12L * days;
+    if(first < 0) first = 0;
+    for(long a = first; a < n; a += days) {
+        long b = a + days < n ? a + days : n;
+        print_range(s, a, b);
+    }
+}
+
+int main() {
+    char line[MAX_LINE];
+    char cmd[16], name[NAME_LEN], gran[16];
+    double temp;
+    long first, last;
+
+    while(fgets(line, sizeof(line), stdin)) {
+        if(sscanf(line, "%15s", cmd) != 1) continue;
+
+        if(strcmp(cmd, "add") == 0) {
+            if(sscanf(line, "%*s %31s %lf", name, &temp) != 2) {
+                printf("usage: add <station> <temperature>\n");
+                continue;
+            }
+            Station* s = find_station(name, 1);
+            if(!s) { printf("out of memory\n"); return 1; }
+            rw_append(&s->stats, temp);
+            if(py_append(&s->pyramid, temp) != 0) { printf("out of memory\n"); return 1; }
+        } else if(strcmp(cmd, "show") == 0) {
+            if(sscanf(line, "%*s %31s", name) != 1) {
+                printf("usage: show <station>\n");
+                continue;
+            }
+            Station* s = find_station(name, 0);
+            if(!s) printf("unknown station %s\n", name);
+            else print_station(s);
+        } else if(strcmp(cmd, "range") == 0) {
+            if(sscanf(line, "%*s %31s %ld %ld", name, &first, &last) != 3) {
+                printf("usage: range <station> <first> <last>\n");
+                continue;
+            }
+            Station* s = find_station(name, 0);
+            if(!s) printf("unknown station %s\n", name);
+            else print_range(s, first, last);
+        } else if(strcmp(cmd, "summary") == 0) {
+            if(sscanf(line, "%*s %31s %15s", name, gran) != 2 || period_days(gran) == 0) {
+                printf("usage: summary <station> day|week|month|year\n");
+                continue;
+            }
+            Station* s = find_station(name, 0);
+            if(!s) printf("unknown station %s\n", name);
+            else print_summary(s, period_days(gran));
+        } else if(strcmp(cmd, "list") == 0) {
+            for(int i = 0; i < num_stations; i++) print_station(&stations[i]);
+        } else if(strcmp(cmd, "quit") == 0) {
+            break;
+        } else {
+            printf("unknown command: %s\n", cmd);
+        }
+    }
+
+    for(int i = 0; i < num_stations; i++) py_free(&stations[i].pyramid);
+    free(stations);
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ topk.h
+ Bounded top-k selection for streaming sweeps
+
+ Overview:
+  - TopK keeps the k best (key, id) entries seen so far in a min-heap whose
+    root is the worst kept entry, so a candidate that cannot make the cut is
+    rejected with one compare.
+  - Larger keys are better; equal keys prefer the smaller id, which makes
+    the result independent of how rows were split between threads. Ids are
+    row numbers the caller can turn back into the full record.
+  - TkSet holds one TopK per (ranking key, group) plus an overall group, so
+    a worker can track several rankings and per-group bests at once in
+    O(k * keys * groups) memory. Worker sets are combined with tk_set_merge().
+*/
+
+#ifndef TOPK_H
+#define TOPK_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+typedef struct {
+    double key;
+    uint64_t id;
+} TkEntry;
+
+typedef struct {
+    TkEntry* e;
+    int n, k;
+} TopK;
+
+/* a ranks ahead of b */
+static inline int tk_better(const TkEntry* a, const TkEntry* b) {
+    return a->key > b->key || (a->key == b->key && a->id < b->id);
+}
+
+static inline int tk_init(TopK* t, int k) {
+    t->k = k > 0 ? k : 1;
+    t->n = 0;
+    t->e = (TkEntry*)malloc(sizeof(TkEntry) * (size_t)t->k);
+    return t->e ? 0 : -1;
+}
+
+static inline void tk_free(TopK* t) {
+    free(t->e);
+    t->e = NULL;
+    t->n = 0;
+}
+
+static inline void tk_sift_down(TopK* t, int i) {
+    TkEntry x = t->e[i];
+    for(;;) {
+        int c = 2 * i + 1;
+        if(c >= t->n) break;
+        if(c + 1 < t->n && tk_better(&t->e[c], &t->e[c + 1])) c++;     /* worse child */
+        if(!tk_better(&x, &t->e[c])) break;
+        t->e[i] = t->e[c];
+        i = c;
+    }
+    t->e[i] = x;
+}
+
+static inline void tk_sift_up(TopK* t, int i) {
+    TkEntry x = t->e[i];
+    while(i > 0) {
+        int p = (i - 1) / 2;
+        if(!tk_better(&t->e[p], &x)) break;
+        t->e[i] = t->e[p];
+        i = p;
+    }
+    t->e[i] = x;
+}
+
+/* Offer a candidate; returns 1 if it was kept */
+static inline int tk_offer(TopK* t, double key, uint64_t id) {
+    TkEntry c = {key, id};
+    if(t->n < t->k) {
+        t->e[t->n++] = c;
+        tk_sift_up(t, t->n - 1);
+        return 1;
+    }
+    if(!tk_better(&c, &t->e[0])) return 0;
+    t->e[0] = c;
+    tk_sift_down(t, 0);
+    return 1;
+}
+
+/* Key a candidate must beat to enter (-inf while not full) */
+static inline double tk_threshold(const TopK* t) {
+    return t->n < t->k ? -INFINITY : t->e[0].key;
+}
+
+static inline void tk_merge(TopK* dst, const TopK* src) {
+    for(int i = 0; i < src->n; i++) tk_offer(dst, src->e[i].key, src->e[i].id);
+}
+
+/* Copy the entries to out best first; returns the count */
+static inline int tk_sorted(const TopK* t, TkEntry* out) {
+    TopK tmp = *t;
+    tmp.e = out;
+    memcpy(out, t->e, sizeof(TkEntry) * (size_t)t->n);
+    /* Heap sort: repeatedly move the worst entry to the end */
+    for(int n = tmp.n; n > 1; n--) {
+        TkEntry w = tmp.e[0];
+        tmp.e[0] = tmp.e[n - 1];
+        tmp.n = n - 1;
+        tk_sift_down(&tmp, 0);
+        tmp.e[n - 1] = w;
+    }
+    return t->n;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Several rankings, per group and overall                                 */
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    int nkeys, ngroups, k;
+    TopK* heaps;            /* [key][group], group == ngroups is overall */
+} TkSet;
+
+static inline void tk_set_free(TkSet* s) {
+    if(!s->heaps) return;
+    for(int i = 0; i < s->nkeys * (s->ngroups + 1); i++) tk_free(&s->heaps[i]);
+    free(s->heaps);
+    s->heaps = NULL;
+}
+
+static inline int tk_set_init(TkSet* s, int nkeys, int ngroups, int k) {
+    s->nkeys = nkeys;
+    s->ngroups = ngroups;
+    s->k = k;
+    s->heaps = (TopK*)calloc((size_t)nkeys * (size_t)(ngroups + 1), sizeof(TopK));
+    if(!s->heaps) return -1;
+    for(int i = 0; i < nkeys * (ngroups + 1); i++) {
+        if(tk_init(&s->heaps[i], k) != 0) {
+            tk_set_free(s);     /* heaps not reached yet are still zeroed */
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static inline TopK* tk_set_heap(TkSet* s, int key, int group) {
+    return &s->heaps[key * (s->ngroups + 1) + (group < 0 ? s->ngroups : group)];
+}
+
+/* Offer to the group heap, and to the overall heap only if the group kept
+   it: k better rows in its own group also rule it out overall */
+static inline void tk_set_offer(TkSet* s, int key, int group, double value, uint64_t id) {
+    if(tk_offer(tk_set_heap(s, key, group), value, id)) tk_offer(tk_set_heap(s, key, -1), value, id);
+}
+
+static inline void tk_set_merge(TkSet* dst, const TkSet* src) {
+    for(int i = 0; i < dst->nkeys * (dst->ngroups + 1); i++) tk_merge(&dst->heaps[i], &src->heaps[i]);
+}
+
+static inline size_t tk_set_bytes(const TkSet* s) {
+    return sizeof(TkSet) + (size_t)s->nkeys * (size_t)(s->ngroups + 1) * (sizeof(TopK) + sizeof(TkEntry) * (size_t)s->k);
+}
+
+#endif /* TOPK_H */
@@ -0,0 +1,245 @@
+/*
+ topk_sweep.c
+ Best-N mission selection without materializing the sweep
+
+ Overview:
+  - Sweeps every rocket/body pair over a payload grid with evaluate_mission()
+    split across worker threads. Each worker keeps a topk.h TkSet with the
+    k best feasible rows per rocket/body pair and overall for three
+    rankings:
+    * margin   largest final delta-v margin
+    * payload  heaviest feasible payload
+    * tankers  fewest tanker flights, then heaviest payload
+  - Worker sets are merged at the end; only row ids are kept, and the
+    winners are re-evaluated for display, so memory is O(k * threads)
+    however large the sweep is.
+  - The same sweep is then materialized (every feasible row's keys) and
+    sorted per ranking and group to check the merged top-k entry for entry.
+
+ Build: gcc -O3 -march=native topk_sweep.c -o topk_sweep -lm -pthread
+ Usage: topk_sweep [payloads_per_pair] [k] [threads] [shown]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include "mission_core.h"
+#include "topk.h"
+
+#define NKEYS 3
+#define KEY_MARGIN 0
+#define KEY_PAYLOAD 1
+#define KEY_TANKERS 2
+#define MAX_THREADS 64
+
+#define NROCKETS ((int)(sizeof(rockets) / sizeof(rockets[0])))
+#define NBODIES ((int)(sizeof(bodies) / sizeof(bodies[0])))
+#define NPAIRS (NROCKETS * NBODIES)
+
+static const char* key_names[NKEYS] = {"margin", "payload", "tankers"};
+
+typedef struct {
+    size_t per_pair;
+    uint64_t begin, end;
+    int k;
+    TkSet set;
+    size_t feasible;
+} Worker;
+
+typedef struct {
+    int pair;
+    double payload;
+    Mission m;
+    MissionResult res;
+    int ok;
+} Row;
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Row id -> rocket/body pair and payload on the grid */
+static void eval_row(uint64_t id, size_t per_pair, Row* row) {
+    row->pair = (int)(id / per_pair);
+    int r = row->pair / NBODIES;
+    double top = 2.0 * rockets[r].payload_leo_kg;
+    row->payload = (double)(int)(1.0 + top * (double)(id % per_pair) / (double)per_pair);
+    memset(&row->m, 0, sizeof(row->m));
+    row->m.rocket = rockets[r];
+    row->m.body = bodies[row->pair % NBODIES];
+    row->m.payload_kg = row->payload;
+    row->ok = evaluate_mission(&row->m, &row->res);
+}
+
+static inline void row_keys(const Row* row, double keys[NKEYS]) {
+    keys[KEY_MARGIN] = row->res.final_margin;
+    keys[KEY_PAYLOAD] = row->payload;
+    keys[KEY_TANKERS] = -1e7 * row->res.tankers + row->payload;   /* payloads stay below 1e7 kg */
+}
+
+static void* worker_main(void* arg) {
+    Worker* w = (Worker*)arg;
+    Row row;
+    double keys[NKEYS];
+    for(uint64_t id = w->begin; id < w->end; id++) {
+        eval_row(id, w->per_pair, &row);
+        if(!row.ok) continue;
+        w->feasible++;
+        row_keys(&row, keys);
+        for(int k = 0; k < NKEYS; k++) tk_set_offer(&w->set, k, row.pair, keys[k], id);
+    }
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Materialize-and-sort check                                              */
+/* ---------------------------------------------------------------------- */
+
+static int cmp_entry(const void* a, const void* b) {
+    const TkEntry* x = (const TkEntry*)a;
+    const TkEntry* y = (const TkEntry*)b;
+    return tk_better(x, y) ? -1 : tk_better(y, x) ? 1 : 0;
+}
+
+/* Returns the number of mismatching entries, or -1 when out of memory;
+   *bytes gets the peak buffer size */
+static long check_full_sort(TkSet* merged, size_t per_pair, size_t* bytes, double* seconds) {
+    size_t rows = per_pair * NPAIRS;
+    TkEntry* all[NKEYS];
+    size_t n = 0;
+    double t0 = now_sec();
+    int oom = 0;
+    for(int k = 0; k < NKEYS; k++) oom |= (all[k] = (TkEntry*)malloc(rows * sizeof(TkEntry))) == NULL;
+    TkEntry* buf = (TkEntry*)malloc(sizeof(TkEntry) * (size_t)merged->k);     /* expected top-k of one heap */
+    TkEntry* got = (TkEntry*)malloc(sizeof(TkEntry) * (size_t)merged->k);
+    if(oom || !buf || !got) {
+        for(int k = 0; k < NKEYS; k++) free(all[k]);
+        free(buf);
+        free(got);
+        return -1;
+    }
+    Row row;
+    double keys[NKEYS];
+    for(uint64_t id = 0; id < rows; id++) {
+        eval_row(id, per_pair, &row);
+        if(!row.ok) continue;
+        row_keys(&row, keys);
+        for(int k = 0; k < NKEYS; k++) {
+            all[k][n].key = keys[k];
+            all[k][n].id = id;
+        }
+        n++;
+    }
+    *bytes = rows * NKEYS * sizeof(TkEntry);
+
+    long bad = 0;
+    for(int k = 0; k < NKEYS; k++) {
+        qsort(all[k], n, sizeof(TkEntry), cmp_entry);
+        for(int g = -1; g < NPAIRS; g++) {
+            size_t m = 0;
+            for(size_t i = 0; i < n && m < (size_t)merged->k; i++)
+                if(g < 0 || (int)(all[k][i].id / per_pair) == g) buf[m++] = all[k][i];
+            int cnt = tk_sorted(tk_set_heap(merged, k, g), got);
+            if((size_t)cnt != m) bad += labs((long)m - cnt);
+            for(int i = 0; i < cnt && (size_t)i < m; i++) bad += got[i].id != buf[i].id;
+        }
+    }
+    *seconds = now_sec() - t0;
+    for(int k = 0; k < NKEYS; k++) free(all[k]);
+    free(buf);
+    free(got);
+    return bad;
+}
+
+int main(int argc, char* argv[]) {
+    size_t per_pair = argc > 1 ? (size_t)atol(argv[1]) : 500000;
+    int k = argc > 2 ? atoi(argv[2]) : 10;
+    int nthreads = argc > 3 ? atoi(argv[3]) : 4;
+    int shown = argc > 4 ? atoi(argv[4]) : 5;
+    if(per_pair < 1) per_pair = 1;
+    if(k < 1) k = 1;
+    if(nthreads < 1) nthreads = 1;
+    if(nthreads > MAX_THREADS) nthreads = MAX_THREADS;
+    if(shown > k) shown = k;
+    uint64_t rows = (uint64_t)per_pair * NPAIRS;
+
+    Worker workers[MAX_THREADS];
+    pthread_t tids[MAX_THREADS];
+    int threaded[MAX_THREADS];
+    TkEntry* best = (TkEntry*)malloc(sizeof(TkEntry) * (size_t)k);
+    /* Every set exists before any worker starts, so a failure leaves nothing running */
+    for(int t = 0; t < nthreads; t++) {
+        if(!best || tk_set_init(&workers[t].set, NKEYS, NPAIRS, k) != 0) {
+            for(int u = 0; u < t; u++) tk_set_free(&workers[u].set);
+            free(best);
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+    double t0 = now_sec();
+    for(int t = 0; t < nthreads; t++) {
+        Worker* w = &workers[t];
+        w->per_pair = per_pair;
+        w->begin = rows * (uint64_t)t / (uint64_t)nthreads;
+        w->end = rows * (uint64_t)(t + 1) / (uint64_t)nthreads;
+        w->k = k;
+        w->feasible = 0;
+        /* No thread: sweep the range here, the result is the same */
+        threaded[t] = pthread_create(&tids[t], NULL, worker_main, w) == 0;
+        if(!threaded[t]) worker_main(w);
+    }
+    for(int t = 0; t < nthreads; t++)
+        if(threaded[t]) pthread_join(tids[t], NULL);
+    TkSet* merged = &workers[0].set;
+    size_t feasible = workers[0].feasible;
+    for(int t = 1; t < nthreads; t++) {
+        tk_set_merge(merged, &workers[t].set);
+        feasible += workers[t].feasible;
+    }
+    double t_topk = now_sec() - t0;
+    size_t topk_bytes = tk_set_bytes(merged) * (size_t)nthreads;
+
+    printf("Sweep: %lu rows, %zu feasible, %d threads, top %d per ranking and pair\n\n", (unsigned long)rows, feasible,
+           nthreads, k);
+    Row row;
+    for(int key = 0; key < NKEYS; key++) {
+        printf("Best by %s:\n", key_names[key]);
+        int cnt = tk_sorted(tk_set_heap(merged, key, -1), best);
+        for(int i = 0; i < cnt && i < shown; i++) {
+            eval_row(best[i].id, per_pair, &row);
+            printf("  %2d. %-28s -> %-15s %9.0f kg  margin %7.3f km/s  tankers %d\n", i + 1, row.m.rocket.name,
+                   row.m.body.name, row.payload, row.res.final_margin, row.res.tankers);
+        }
+    }
+    printf("\nHeaviest feasible payload per pair:\n");
+    for(int g = 0; g < NPAIRS; g++) {
+        int cnt = tk_sorted(tk_set_heap(merged, KEY_PAYLOAD, g), best);
+        if(cnt == 0) continue;
+        eval_row(best[0].id, per_pair, &row);
+        printf("  %-28s -> %-15s %9.0f kg  margin %7.3f km/s\n", row.m.rocket.name, row.m.body.name, row.payload,
+               row.res.final_margin);
+    }
+
+    size_t full_bytes;
+    double t_full;
+    long bad = check_full_sort(merged, per_pair, &full_bytes, &t_full);
+    printf("\n%-22s %10s %14s\n", "method", "seconds", "memory");
+    printf("%-22s %10.3f %12.1f KB\n", "per-worker top-k", t_topk, topk_bytes / 1024.0);
+    if(bad < 0) {
+        printf("%-22s %10s %14s\n", "materialize + sort", "-", "out of memory");
+        printf("Top-k check: skipped\n");
+        bad = 0;
+    } else {
+        printf("%-22s %10.3f %12.1f MB\n", "materialize + sort", t_full, full_bytes / 1048576.0);
+        printf("Top-k check: %s (%ld mismatches)\n", bad ? "FAILED" : "identical", bad);
+    }
+
+    free(best);
+    for(int t = 0; t < nthreads; t++) tk_set_free(&workers[t].set);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,332 @@
+/*
+ transfer_costs.h
+ Closed-form transfer costs derived from orbit radii
+
+ Overview:
+  - Replaces hand-typed dv_transfer / dv_capture numbers with values
+    derived from semi-major axes, gravitational parameters and the
+    parking / capture orbit altitudes:
+    * Departure: patched conic from a circular Earth parking orbit onto a
+      Hohmann (or bi-elliptic, when its total is cheaper) transfer; the
+      bi-elliptic apoapsis burn is kept as a separate midcourse term
+    * Arrival: plane change folded into the arrival v-infinity, then a
+      single burn into a circular capture orbit
+    * Moons of other planets: brake at the moon's orbital radius around
+      the parent, then a low-energy capture at the moon
+    * Earth's Moon: capture from the Earth-Moon restricted three-body
+      energy of the injection (the Jacobi constant fixes the periselene
+      speed; cr3bp.c integrates the same problem)
+  - Every destination x parking altitude x capture altitude combination is
+    computed once into a cached table, so sweeps look values up in O(1).
+  - Hundreds of destinations can be added by appending to orbit_bodies[].
+*/
+
+#ifndef TRANSFER_COSTS_H
+#define TRANSFER_COSTS_H
+
+#include <math.h>
+#include <string.h>
+#include "mission_core.h"
+
+#define MU_SUN 1.32712440018e11     /* km^3/s^2 */
+#define AU_KM 1.495978707e8
+#define TC_PI 3.14159265358979323846
+#define TC_DEG (TC_PI / 180.0)
+
+#define TC_SUN -1       /* central body index for heliocentric orbits */
+#define TC_EARTH 0      /* index of Earth in orbit_bodies[] */
+
+#define TC_HOHMANN 0
+#define TC_BIELLIPTIC 1
+
+typedef struct {
+    char name[64];
+    int central;        /* index of the body it orbits, TC_SUN for the Sun */
+    double a_km;        /* semi-major axis around the central body */
+    double mu;          /* gravitational parameter km^3/s^2 */
+    double radius_km;
+    double inc_deg;     /* inclination relative to the central body's reference plane */
+} OrbitBody;
+
+OrbitBody orbit_bodies[] = {
+    {"Earth",          TC_SUN,   1.00000 * AU_KM, 398600.4418, 6378.1, 0.00},
+    {"Moon",           TC_EARTH, 384400.0,        4902.800066, 1737.4, 5.15},
+    {"Mercury",        TC_SUN,   0.38710 * AU_KM, 22031.78,    2439.7, 7.00},
+    {"Venus",          TC_SUN,   0.72333 * AU_KM, 324858.59,   6051.8, 3.39},
+    {"Mars",           TC_SUN,   1.52368 * AU_KM, 42828.37,    3396.2, 1.85},
+    {"Phobos (Mars)",  4,        9376.0,          7.087e-4,    11.1,   1.09},
+    {"Deimos (Mars)",  4,        23463.0,         9.615e-5,    6.2,    0.93},
+    {"Vesta",          TC_SUN,   2.36150 * AU_KM, 17.288,      262.7,  7.14},
+    {"Ceres",          TC_SUN,   2.76750 * AU_KM, 62.6284,     469.7,  10.59},
+    {"Psyche",         TC_SUN,   2.92400 * AU_KM, 1.53,        113.0,  3.10},
+    {"Jupiter",        TC_SUN,   5.20440 * AU_KM, 126686534.0, 71492.0, 1.30},
+    {"Europa (Jupiter)",   10,   671100.0,        3202.739,    1560.8, 0.47},
+    {"Ganymede (Jupiter)", 10,   1070400.0,       9887.834,    2634.1, 0.20},
+    {"Callisto (Jupiter)", 10,   1882700.0,       7179.289,    2410.3, 0.19},
+    {"Saturn",         TC_SUN,   9.58260 * AU_KM, 37931187.0,  60268.0, 2.49},
+    {"Enceladus (Saturn)", 14,   238020.0,        7.211,       252.1,  0.01},
+    {"Titan (Saturn)", 14,       1221870.0,       8978.138,    2574.7, 0.35},
+    {"Uranus",         TC_SUN,  19.19126 * AU_KM, 5793939.0,   25559.0, 0.77},
+    {"Neptune",        TC_SUN,  30.07000 * AU_KM, 6836529.0,   24764.0, 1.77}
+};
+
+#define NUM_ORBIT_BODIES ((int)(sizeof(orbit_bodies) / sizeof(orbit_bodies[0])))
+
+/* Parking (Earth) and capture (target) circular orbit altitudes in km */
+static const double tc_parking_alt[] = {200.0, 400.0, 1000.0};
+static const double tc_capture_alt[] = {100.0, 500.0, 2000.0};
+#define NUM_PARKING 3
+#define NUM_CAPTURE 3
+
+typedef struct {
+    double dv_depart;       /* km/s from the parking orbit */
+    double dv_midcourse;    /* km/s at the bi-elliptic apoapsis (0 for Hohmann) */
+    double dv_capture;      /* km/s into the capture orbit */
+    double transit_days;
+    double synodic_days;    /* spacing of departure windows */
+    int method;             /* TC_HOHMANN or TC_BIELLIPTIC */
+} TransferCost;
+
+/* ---------------------------------------------------------------------- */
+/* Closed-form building blocks                                             */
+/* ---------------------------------------------------------------------- */
+
+/* Two-impulse Hohmann transfer between circular orbits r1 -> r2.
+   Returns the total and fills the periapsis/apoapsis speeds on the ellipse. */
+double hohmann_dv(double mu, double r1, double r2, double* v_dep, double* v_arr) {
+    double at = 0.5 * (r1 + r2);
+    double vt1 = sqrt(mu * (2.0 / r1 - 1.0 / at));
+    double vt2 = sqrt(mu * (2.0 / r2 - 1.0 / at));
+    if(v_dep) *v_dep = vt1;
+    if(v_arr) *v_arr = vt2;
+    return fabs(vt1 - sqrt(mu / r1)) + fabs(sqrt(mu / r2) - vt2);
+}
+
+/* Three-impulse bi-elliptic transfer r1 -> rb -> r2 */
+double bielliptic_dv(double mu, double r1, double r2, double rb) {
+    double a1 = 0.5 * (r1 + rb), a2 = 0.5 * (r2 + rb);
+    double dv1 = sqrt(mu * (2.0 / r1 - 1.0 / a1)) - sqrt(mu / r1);
+    double dv2 = fabs(sqrt(mu * (2.0 / rb - 1.0 / a2)) - sqrt(mu * (2.0 / rb - 1.0 / a1)));
+    double dv3 = fabs(sqrt(mu * (2.0 / r2 - 1.0 / a2)) - sqrt(mu / r2));
+    return dv1 + dv2 + dv3;
+}
+
+/* Single burn changing speed v1 -> v2 and rotating the plane by di (rad) */
+double combined_plane_change_dv(double v1, double v2, double di) {
+    return sqrt(fmax(v1 * v1 + v2 * v2 - 2.0 * v1 * v2 * cos(di), 0.0));
+}
+
+/* Burn between a hyperbola with v_inf and a circular orbit of radius r */
+double hyperbolic_burn_dv(double mu, double r, double v_inf) {
+    return sqrt(v_inf * v_inf + 2.0 * mu / r) - sqrt(mu / r);
+}
+
+double orbit_period_days(double mu, double a) {
+    return 2.0 * TC_PI * sqrt(a * a * a / mu) / 86400.0;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Cost of one destination / parking / capture combination                 */
+/* ---------------------------------------------------------------------- */
+
+/* Heliocentric impulses of an Earth -> planet leg between circular orbits
+   r1 -> r2: excess speed leaving Earth, the bi-elliptic apoapsis burn and
+   the arrival v-infinity with a plane change di folded in. rb <= 0 gives
+   the Hohmann leg; with di = 0 the three terms sum to hohmann_dv() or
+   bielliptic_dv(). */
+typedef struct {
+    double v_inf_dep, dv_mid, v_inf_arr;
+    double days;
+} TcLeg;
+
+static TcLeg tc_helio_leg(double r1, double r2, double rb, double di) {
+    TcLeg l;
+    if(rb <= 0.0) {
+        double v_dep, v_arr;
+        hohmann_dv(MU_SUN, r1, r2, &v_dep, &v_arr);
+        l.v_inf_dep = fabs(v_dep - sqrt(MU_SUN / r1));
+        l.dv_mid = 0.0;
+        l.v_inf_arr = combined_plane_change_dv(v_arr, sqrt(MU_SUN / r2), di);
+        l.days = 0.5 * orbit_period_days(MU_SUN, 0.5 * (r1 + r2));
+        return l;
+    }
+    double a1 = 0.5 * (r1 + rb), a2 = 0.5 * (r2 + rb);
+    l.v_inf_dep = fabs(sqrt(MU_SUN * (2.0 / r1 - 1.0 / a1)) - sqrt(MU_SUN / r1));
+    l.dv_mid = fabs(sqrt(MU_SUN * (2.0 / rb - 1.0 / a2)) - sqrt(MU_SUN * (2.0 / rb - 1.0 / a1)));
+    l.v_inf_arr = combined_plane_change_dv(sqrt(MU_SUN * (2.0 / r2 - 1.0 / a2)), sqrt(MU_SUN / r2), di);
+    l.days = 0.5 * (orbit_period_days(MU_SUN, a1) + orbit_period_days(MU_SUN, a2));
+    return l;
+}
+
+/* Capture at body idx (a planet, or a moon of planet) from v_inf at the planet */
+static double tc_arrival_dv(int idx, int planet, double r_cap, double v_inf) {
+    const OrbitBody* b = &orbit_bodies[idx];
+    const OrbitBody* p = &orbit_bodies[planet];
+    if(planet == idx) return hyperbolic_burn_dv(p->mu, r_cap, v_inf);
+    /* Brake at the moon's orbital radius to match it, then capture from
+       near-zero v-infinity at the moon */
+    double v_moon = sqrt(p->mu / b->a_km);
+    double match = hyperbolic_burn_dv(p->mu, b->a_km, v_inf);
+    double plane = 2.0 * v_moon * sin(0.5 * b->inc_deg * TC_DEG);
+    return match + plane + hyperbolic_burn_dv(b->mu, r_cap, 0.0);
+}
+
+/* 2U on the rotating x axis of a restricted three-body problem with mass
+   ratio mu (unit distance and mean motion) */
+static double tc_jacobi_2u(double mu, double x) {
+    return x * x + 2.0 * (1.0 - mu) / fabs(x + mu) + 2.0 * mu / fabs(x - 1.0 + mu);
+}
+
+/* Capture at Earth-system body idx into a circular orbit of radius r_cap,
+   after an injection from a circular orbit of radius r_park whose apogee
+   reaches the body. The injection state's Jacobi constant fixes the
+   rotating-frame speed at a far-side periapsis. */
+static double tc_cr3bp_capture_dv(int idx, double r_park, double r_cap) {
+    const OrbitBody* earth = &orbit_bodies[TC_EARTH];
+    const OrbitBody* b = &orbit_bodies[idx];
+    double mu = b->mu / (earth->mu + b->mu), L = b->a_km;
+    double vu = sqrt((earth->mu + b->mu) / L);     /* km/s per unit speed */
+    double v_inj = sqrt(earth->mu * (2.0 / r_park - 2.0 / (r_park + L)));
+    /* Injection state with Earth at (-mu, 0): inertial speed minus omega x r */
+    double x = -mu - r_park / L;
+    double vy = -v_inj / vu - x - mu;
+    double c = tc_jacobi_2u(mu, x) - vy * vy;
+    double rl = r_cap / L;
+    double v_rot = sqrt(fmax(tc_jacobi_2u(mu, 1.0 - mu + rl) - c, 0.0));
+    /* Body-centred inertial speed adds omega * r back */
+    return (v_rot + rl) * vu - sqrt(b->mu / r_cap);
+}
+
+/* force_rb > 0 forces a bi-elliptic leg with that apoapsis (for checks);
+   otherwise the cheapest total of Hohmann and a few bi-elliptic apoapses
+   is used */
+static TransferCost tc_compute_rb(int idx, double park_alt, double cap_alt, double force_rb) {
+    TransferCost tc = {0};
+    const OrbitBody* earth = &orbit_bodies[TC_EARTH];
+    const OrbitBody* b = &orbit_bodies[idx];
+    double r_park = earth->radius_km + park_alt;
+    double r_cap = b->radius_km + cap_alt;
+
+    if(idx == TC_EARTH) return tc;
+
+    if(b->central == TC_EARTH) {
+        /* Earth-system target: Hohmann from the parking orbit, capture from
+           the three-body energy of that injection */
+        double v_dep, v_arr;
+        hohmann_dv(earth->mu, r_park, b->a_km, &v_dep, &v_arr);
+        tc.dv_depart = v_dep - sqrt(earth->mu / r_park);
+        tc.dv_capture = tc_cr3bp_capture_dv(idx, r_park, r_cap);
+        tc.transit_days = 0.5 * orbit_period_days(earth->mu, 0.5 * (r_park + b->a_km));
+        /* Same Sun-relative geometry repeats once per synodic month */
+        double sidereal = orbit_period_days(earth->mu + b->mu, b->a_km);
+        double year = orbit_period_days(MU_SUN, earth->a_km);
+        tc.synodic_days = 1.0 / (1.0 / sidereal - 1.0 / year);
+        tc.method = TC_HOHMANN;
+        return tc;
+    }
+
+    /* Heliocentric leg to the body itself or to the planet it orbits */
+    int planet = (b->central == TC_SUN) ? idx : b->central;
+    const OrbitBody* p = &orbit_bodies[planet];
+    double r1 = earth->a_km, r2 = p->a_km, di = p->inc_deg * TC_DEG;
+
+    TcLeg best = tc_helio_leg(r1, r2, force_rb, di);
+    double best_dv = hyperbolic_burn_dv(earth->mu, r_park, best.v_inf_dep) + best.dv_mid +
+                     tc_arrival_dv(idx, planet, r_cap, best.v_inf_arr);
+    tc.method = force_rb > 0.0 ? TC_BIELLIPTIC : TC_HOHMANN;
+
+    /* Bi-elliptic only pays off for large radius ratios; try a few apoapses
+       whose flight time stays within twice the Hohmann transit */
+    for(double k = 1.25; force_rb <= 0.0 && k <= 4.0; k *= 1.25) {
+        TcLeg l = tc_helio_leg(r1, r2, k * fmax(r1, r2), di);
+        if(l.days > 2.0 * tc_helio_leg(r1, r2, 0.0, di).days) continue;
+        double dv = hyperbolic_burn_dv(earth->mu, r_park, l.v_inf_dep) + l.dv_mid +
+                    tc_arrival_dv(idx, planet, r_cap, l.v_inf_arr);
+        if(dv < best_dv) {
+            best = l;
+            best_dv = dv;
+            tc.method = TC_BIELLIPTIC;
+        }
+    }
+    tc.dv_depart = hyperbolic_burn_dv(earth->mu, r_park, best.v_inf_dep);
+    tc.dv_midcourse = best.dv_mid;
+    tc.dv_capture = tc_arrival_dv(idx, planet, r_cap, best.v_inf_arr);
+    tc.transit_days = best.days;
+
+    double te = orbit_period_days(MU_SUN, r1), tp = orbit_period_days(MU_SUN, r2);
+    tc.synodic_days = 1.0 / fabs(1.0 / te - 1.0 / tp);
+    return tc;
+}
+
+static TransferCost tc_compute(int idx, double park_alt, double cap_alt) {
+    return tc_compute_rb(idx, park_alt, cap_alt, 0.0);
+}
+
+/* Consistency check of the bi-elliptic bookkeeping: for every planet, a
+   forced coplanar bi-elliptic leg must sum to bielliptic_dv(), and the
+   derived cost must carry its middle burn and departure excess unchanged.
+   Returns the largest discrepancy in km/s. */
+double tc_bielliptic_check() {
+    const OrbitBody* earth = &orbit_bodies[TC_EARTH];
+    double worst = 0.0;
+    for(int i = 0; i < NUM_ORBIT_BODIES; i++) {
+        if(i == TC_EARTH || orbit_bodies[i].central != TC_SUN) continue;
+        double r1 = earth->a_km, r2 = orbit_bodies[i].a_km, rb = 2.0 * fmax(r1, r2);
+        TcLeg l = tc_helio_leg(r1, r2, rb, 0.0);
+        double e = fabs(l.v_inf_dep + l.dv_mid + l.v_inf_arr - bielliptic_dv(MU_SUN, r1, r2, rb));
+        TransferCost tc = tc_compute_rb(i, tc_parking_alt[0], tc_capture_alt[0], rb);
+        e = fmax(e, fabs(tc.dv_midcourse - l.dv_mid));
+        e = fmax(e, fabs(tc.dv_depart - hyperbolic_burn_dv(earth->mu, earth->radius_km + tc_parking_alt[0],
+                                                           l.v_inf_dep)));
+        worst = fmax(worst, e);
+    }
+    return worst;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Cached table                                                            */
+/* ---------------------------------------------------------------------- */
+
+TransferCost transfer_table[sizeof(orbit_bodies) / sizeof(orbit_bodies[0])][NUM_PARKING][NUM_CAPTURE];
+int transfer_table_ready = 0;
+
+/* Compute every combination once */
+void build_transfer_table() {
+    for(int i = 0; i < NUM_ORBIT_BODIES; i++)
+        for(int p = 0; p < NUM_PARKING; p++)
+            for(int c = 0; c < NUM_CAPTURE; c++)
+                transfer_table[i][p][c] = tc_compute(i, tc_parking_alt[p], tc_capture_alt[c]);
+    transfer_table_ready = 1;
+}
+
+/* O(1) lookup; builds the table on first use */
+const TransferCost* transfer_cost(int body, int parking, int capture) {
+    if(!transfer_table_ready) build_transfer_table();
+    if(body < 0 || body >= NUM_ORBIT_BODIES || parking < 0 || parking >= NUM_PARKING ||
+       capture < 0 || capture >= NUM_CAPTURE) return NULL;
+    return &transfer_table[body][parking][capture];
+}
+
+/* Index of a destination by name, or -1 */
+int find_orbit_body(const char* name) {
+    for(int i = 0; i < NUM_ORBIT_BODIES; i++) {
+        if(strcmp(orbit_bodies[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+/* Fill a planner Body from the derived table (epoch supplied by caller) */
+int derive_body(int body, int parking, int capture, const char* epoch, Body* out) {
+    const TransferCost* tc = transfer_cost(body, parking, capture);
+    if(!tc) return -1;
+    memset(out, 0, sizeof(*out));
+    strncpy(out->name, orbit_bodies[body].name, sizeof(out->name) - 1);
+    out->dv_transfer = tc->dv_depart + tc->dv_midcourse;
+    out->dv_capture = tc->dv_capture;
+    out->synodic_days = tc->synodic_days;
+    strncpy(out->epoch_date, epoch, DATE_STRLEN - 1);
+    out->typical_transit_days = tc->transit_days;
+    return 0;
+}
+
+#endif /* TRANSFER_COSTS_H */